@@ -0,0 +1,62 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace lab {
+
+/**
+ * @brief aligned_allocator hands out storage aligned to Alignment bytes
+ * (a cache line by default), so that columns of plain numbers start on a
+ * vector register boundary. Needs C++17 for the aligned operator new.
+ */
+template<typename T, size_t Alignment = 64>
+class aligned_allocator {
+public:
+	typedef T		value_type;
+	typedef T*		pointer;
+	typedef const T*	const_pointer;
+	typedef size_t		size_type;
+	typedef ptrdiff_t	difference_type;
+
+	static_assert(Alignment >= alignof(T) && !(Alignment & (Alignment - 1)),
+		      "Alignment must be a power of two not below alignof(T).");
+
+	template<typename U>
+	struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+	aligned_allocator() noexcept {}
+	template<typename U>
+	aligned_allocator(aligned_allocator<U, Alignment> const&) noexcept {}
+
+	// throws std::bad_array_new_length if n * sizeof(T) does not fit
+	pointer allocate(size_type n)
+	{
+		if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+			throw std::bad_array_new_length();
+		return static_cast<pointer>(::operator new(n * sizeof(T),
+						std::align_val_t(Alignment)));
+	}
+
+	void deallocate(pointer p, size_type) noexcept
+	{
+		::operator delete(p, std::align_val_t(Alignment));
+	}
+
+	friend bool operator==(aligned_allocator const&,
+			       aligned_allocator const&) noexcept
+	{
+		return true;
+	}
+	friend bool operator!=(aligned_allocator const&,
+			       aligned_allocator const&) noexcept
+	{
+		return false;
+	}
+};
+
+} // namespace lab
+
+#endif // ALIGNED_ALLOCATOR_H
@@ -0,0 +1,1277 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Benchmarks of the containers and rational kernels of the laboratory work.
+ *
+ * Build with optimizations, for example
+ *	g++ -std=c++17 -O2 -march=native -pthread bench.cpp -o bench
+ * and run "bench" for every benchmark or "bench <name>..." for some of
+ * them; "bench list" prints the names.
+ */
+
+#include "concurrent_queue.h"
+#include "rational_batch.h"
+#include "gcd.h"
+#include "bigint.h"
+#include "rational_expr.h"
+#include "rational_charconv.h"
+#include "rational_map.h"
+#include "packed_rational.h"
+#include "matrix.h"
+#include "rational_numeric.h"
+#include "polynomial.h"
+#include "rational_filter.h"
+#include "radix_sort.h"
+#include "parallel_sort.h"
+
+using std::cout;
+
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * @brief seconds: The time of the fastest of runs calls of f().
+ */
+template<typename F>
+double seconds(F f, int runs = 3)
+{
+	double best = 0;
+	for (int i = 0; i < runs; i++) {
+		bench_clock::time_point const start = bench_clock::now();
+		f();
+		std::chrono::duration<double> const d =
+			bench_clock::now() - start;
+		if (!i || d.count() < best)
+			best = d.count();
+	}
+	return best;
+}
+
+/**
+ * @brief report: Print one measurement as time and throughput.
+ */
+void report(const char* what, double secs, double items, const char* unit)
+{
+	cout << "	" << what << ": " << secs * 1e3 << " ms, "
+	     << items / secs / 1e6 << " M" << unit << "/s\n";
+}
+
+// keeps a result alive so the computation is not optimized away
+template<typename T>
+void keep(T const& value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+std::uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		bench_clock::now().time_since_epoch()).count();
+}
+
+std::uint64_t percentile(std::vector<std::uint64_t>& samples, double p)
+{
+	if (samples.empty())
+		return 0;
+	size_t const k = static_cast<size_t>(p * (samples.size() - 1));
+	std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+	return samples[k];
+}
+
+/*
+ * Queues: ops/s and the p99 latency from push to pop, with time stamps
+ * as elements, for one spsc pair and 1, 2 and 4 mpmc producer/consumer
+ * pairs, moving single elements and batches of 64.
+ */
+template<typename Queue>
+void queue_run(const char* what, size_t pairs, size_t batch)
+{
+	size_t const total = 1 << 21;
+	size_t const per_producer = total / pairs;
+	Queue q(4096);
+	std::vector<std::vector<std::uint64_t> > latency(pairs);
+	std::vector<std::thread> threads;
+
+	bench_clock::time_point const start = bench_clock::now();
+	for (size_t p = 0; p < pairs; p++)
+		threads.emplace_back([&q, per_producer, batch] {
+			std::uint64_t stamps[64];
+			for (size_t sent = 0; sent < per_producer;) {
+				size_t n = std::min(batch, per_producer - sent);
+				std::uint64_t const t = now_ns();
+				for (size_t i = 0; i < n; i++)
+					stamps[i] = t;
+				const std::uint64_t* s = stamps;
+				while (n) {
+					size_t const k = q.try_push(s, n);
+					s += k;
+					n -= k;
+					sent += k;
+					if (!k)
+						std::this_thread::yield();
+				}
+			}
+		});
+	for (size_t c = 0; c < pairs; c++)
+		threads.emplace_back([&q, &latency, c, per_producer, batch] {
+			std::uint64_t stamps[64];
+			std::vector<std::uint64_t>& lat = latency[c];
+			lat.reserve(per_producer / 16 + 1);
+			for (size_t got = 0; got < per_producer;) {
+				size_t const k = q.try_pop(stamps,
+					std::min(batch, per_producer - got));
+				if (!k) {
+					std::this_thread::yield();
+					continue;
+				}
+				std::uint64_t const t = now_ns();
+				for (size_t i = 0; i < k; i++)
+					if (!((got + i) & 15))
+						lat.push_back(t - stamps[i]);
+				got += k;
+			}
+		});
+	for (std::thread& t : threads)
+		t.join();
+	std::chrono::duration<double> const d = bench_clock::now() - start;
+
+	std::vector<std::uint64_t> all;
+	for (std::vector<std::uint64_t> const& l : latency)
+		all.insert(all.end(), l.begin(), l.end());
+	cout << "	" << what << ", " << pairs << " pair(s), batch "
+	     << batch << ": " << per_producer * pairs / d.count() / 1e6
+	     << " Mops/s, p50 " << percentile(all, 0.5) << " ns, p99 "
+	     << percentile(all, 0.99) << " ns\n";
+}
+
+void bench_queue()
+{
+	cout << "queue:\n";
+	typedef lab::spsc_queue<std::uint64_t> spsc;
+	typedef lab::mpmc_queue<std::uint64_t> mpmc;
+	for (size_t batch : {1, 64}) {
+		queue_run<spsc>("spsc", 1, batch);
+		for (size_t pairs : {1, 2, 4})
+			queue_run<mpmc>("mpmc", pairs, batch);
+	}
+}
+
+/*
+ * Batch arithmetic: elements/s of batch::apply (vector lanes where the CPU
+ * has them) against the scalar rational_t operators, over 1M elements.
+ * With components below 2^15 all products fit int; dyadic numbers with
+ * denominators of 2^16 to 2^20 have denominator products that do not, so
+ * their sums take the scalar fallback although the results fit.
+ */
+void batch_run(const char* what, lab::batch::operation op,
+	       lab::rational_soa_vector<int> const& a,
+	       lab::rational_soa_vector<int> const& b)
+{
+	lab::rational_soa_vector<int> out(a.size());
+	size_t const n = a.size();
+	cout << "	" << what << "\n";
+	report("	scalar", seconds([&] {
+		lab::batch::detail::apply_scalar(op, a.num_data(),
+			a.denom_data(), b.num_data(), b.denom_data(),
+			out.num_data(), out.denom_data(), n);
+	}), n, "elem");
+	report("	batch", seconds([&] {
+		lab::batch::apply(op, a, b, out);
+	}), n, "elem");
+}
+
+void bench_batch()
+{
+	cout << "batch:\n";
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-(1 << 15) + 1, (1 << 15) - 1);
+	std::uniform_int_distribution<int> den(1, (1 << 15) - 1);
+	std::uniform_int_distribution<int> shift(16, 20);
+
+	lab::rational_soa_vector<int> a, b, c, d;
+	for (size_t i = 0; i < n; i++) {
+		a.push_back(lab::rational_t<int>(num(gen), den(gen)));
+		b.push_back(lab::rational_t<int>(num(gen) | 1, den(gen)));
+		c.push_back(lab::rational_t<int>(num(gen) >> 5,
+						 1 << shift(gen)));
+		d.push_back(lab::rational_t<int>(num(gen) >> 5,
+						 1 << shift(gen)));
+	}
+	batch_run("add, 15-bit", lab::batch::op_add, a, b);
+	batch_run("sub, 15-bit", lab::batch::op_sub, a, b);
+	batch_run("mul, 15-bit", lab::batch::op_mul, a, b);
+	batch_run("div, 15-bit", lab::batch::op_div, a, b);
+	batch_run("add, dyadic", lab::batch::op_add, c, d);
+	batch_run("sub, dyadic", lab::batch::op_sub, c, d);
+}
+
+/*
+ * gcd and rational_t construction per component width: lab::gcd (binary)
+ * against Euclid's algorithm, and construction, which reduces by gcd, of
+ * 1M random pairs with a small common factor.
+ */
+template<typename IntT>
+IntT euclid_gcd(IntT a, IntT b)
+{
+	if (a < 0)
+		a = -a;
+	if (b < 0)
+		b = -b;
+	while (b) {
+		IntT const t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+template<typename IntT>
+void gcd_run(const char* what)
+{
+	size_t const n = 1 << 20;
+	std::mt19937_64 gen(1);
+	std::vector<IntT> a(n), b(n);
+	for (size_t i = 0; i < n; i++) {
+		// at most half the bits, so the products of IntT fit too
+		int const bits = 4 * static_cast<int>(sizeof(IntT)) - 2;
+		IntT const mask = static_cast<IntT>((IntT(1) << bits) - 1);
+		IntT const k = static_cast<IntT>(gen() % 5 + 1);
+		a[i] = static_cast<IntT>((static_cast<IntT>(gen()) & mask) * k);
+		b[i] = static_cast<IntT>((static_cast<IntT>(gen()) & mask) * k
+					 + k);
+	}
+
+	cout << "	" << what << "\n";
+	report("	euclid", seconds([&] {
+		IntT sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum = static_cast<IntT>(sum + euclid_gcd(a[i], b[i]));
+		keep(sum);
+	}), n, "gcd");
+	report("	binary", seconds([&] {
+		IntT sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum = static_cast<IntT>(sum + lab::gcd(a[i], b[i]));
+		keep(sum);
+	}), n, "gcd");
+	report("	rational_t", seconds([&] {
+		IntT sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum = static_cast<IntT>(sum
+				+ lab::rational_t<IntT>(a[i], b[i]).num());
+		keep(sum);
+	}), n, "obj");
+}
+
+void bench_gcd()
+{
+	cout << "gcd:\n";
+	gcd_run<signed char>("signed char");
+	gcd_run<int>("int");
+	gcd_run<long long>("long long");
+#ifdef __SIZEOF_INT128__
+	gcd_run<__int128>("__int128");
+#endif
+}
+
+/*
+ * Overflow checks: rational_t + and * with the throwing and the wrapping
+ * policy against the unchecked arithmetic rational_t had before, which
+ * computed in IntT (int temporaries for +) and reduced by Euclid's gcd.
+ * 1M pairs with components below 2^12, so nothing overflows.
+ */
+template<typename IntT>
+struct unchecked_rational {
+	typedef IntT int_type;
+
+	IntT num, denom;
+
+	unchecked_rational(IntT n, IntT d) : num(n), denom(d)
+	{
+		if (denom < 0) {
+			denom = -denom;
+			num = -num;
+		}
+		IntT const g = euclid_gcd(num, denom);
+		num /= g;
+		denom /= g;
+	}
+
+	friend unchecked_rational operator+(unchecked_rational const& lhs,
+					    unchecked_rational const& rhs)
+	{
+		IntT const d = lhs.denom * rhs.denom
+			       / euclid_gcd(lhs.denom, rhs.denom);
+		return unchecked_rational(d / lhs.denom * lhs.num
+					  + d / rhs.denom * rhs.num, d);
+	}
+	friend unchecked_rational operator*(unchecked_rational const& lhs,
+					    unchecked_rational const& rhs)
+	{
+		return unchecked_rational(lhs.num * rhs.num,
+					  lhs.denom * rhs.denom);
+	}
+};
+
+template<typename IntT>
+IntT numerator(unchecked_rational<IntT> const& x)
+{
+	return x.num;
+}
+
+template<typename IntT, typename Policy>
+IntT numerator(lab::rational_t<IntT, Policy> const& x)
+{
+	return x.num();
+}
+
+template<typename Rational>
+void overflow_run(const char* what)
+{
+	typedef typename Rational::int_type int_type;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-4095, 4095);
+	std::uniform_int_distribution<int> den(1, 4095);
+	std::vector<Rational> a, b;
+	for (size_t i = 0; i < n; i++) {
+		a.push_back(Rational(int_type(num(gen)), int_type(den(gen))));
+		b.push_back(Rational(int_type(num(gen)), int_type(den(gen))));
+	}
+
+	cout << "	" << what << "\n";
+	report("	a + b", seconds([&] {
+		int_type sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += numerator(a[i] + b[i]);
+		keep(sum);
+	}), n, "op");
+	report("	a * b", seconds([&] {
+		int_type sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += numerator(a[i] * b[i]);
+		keep(sum);
+	}), n, "op");
+}
+
+void bench_overflow()
+{
+	cout << "overflow:\n";
+	overflow_run<unchecked_rational<int> >("int, unchecked");
+	overflow_run<lab::rational_t<int> >("int, overflow_throw");
+	overflow_run<lab::rational_t<int, lab::overflow_wrap> >(
+		"int, overflow_wrap");
+	overflow_run<unchecked_rational<long long> >("long long, unchecked");
+	overflow_run<lab::rational_t<long long> >(
+		"long long, overflow_throw");
+}
+
+/*
+ * rational_t<bigint>: the harmonic series 1 + 1/2 + ... + 1/n summed
+ * exactly, for n up to 10^5, where the denominator has about 43000 digits.
+ * Every term needs a gcd of the long partial sum, so this shows how the
+ * cost grows with the operand length.
+ */
+void bench_harmonic()
+{
+	cout << "harmonic:\n";
+	typedef lab::rational_t<lab::bigint> rational_big;
+	for (int n : {1000, 10000, 100000}) {
+		size_t bits = 0;
+		double const secs = seconds([&] {
+			rational_big h;
+			for (int k = 1; k <= n; k++)
+				h += rational_big(1, k);
+			bits = h.denom().bit_width();
+		}, 1);
+		cout << "	n = " << n << ": " << secs * 1e3 << " ms, "
+		     << n / secs << " terms/s, " << bits
+		     << "-bit denominator\n";
+	}
+}
+
+/*
+ * Lazy normalization: dot products of 16 rationals with denominators
+ * dividing 2^6, eager against lazy long long components. The lazy sums
+ * skip the gcds until a stored denominator would overflow.
+ */
+template<typename Rational>
+void lazy_run(const char* what, std::vector<Rational> const& a,
+	      std::vector<Rational> const& b)
+{
+	size_t const len = 16;
+	report(what, seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i + len <= a.size(); i += len) {
+			Rational dot;
+			for (size_t j = i; j < i + len; j++)
+				dot += a[j] * b[j];
+			sum += dot.normalized().num();
+		}
+		keep(sum);
+	}), a.size(), "term");
+}
+
+void bench_lazy()
+{
+	cout << "lazy:\n";
+	typedef lab::rational_t<long long> eager;
+	typedef lab::rational_t<long long, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-1000, 1000);
+	std::uniform_int_distribution<int> shift(0, 6);
+	std::vector<eager> a, b;
+	std::vector<lazy> la, lb;
+	for (size_t i = 0; i < n; i++) {
+		long long const p = num(gen), q = num(gen);
+		long long const d = 1LL << shift(gen), e = 1LL << shift(gen);
+		a.push_back(eager(p, d));
+		b.push_back(eager(q, e));
+		la.push_back(lazy(p, d));
+		lb.push_back(lazy(q, e));
+	}
+	lazy_run("eager", a, b);
+	lazy_run("lazy", la, lb);
+}
+
+/*
+ * Expression templates: a * b + c * d over 1M long long rationals with
+ * components below 2^12, with the operators (a reduction per operator)
+ * and fused (one reduction of the 128-bit result).
+ */
+void bench_fused()
+{
+	cout << "fused:\n";
+	typedef lab::rational_t<long long> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-4095, 4095);
+	std::uniform_int_distribution<int> den(1, 4095);
+	std::vector<rational> v[4];
+	for (size_t i = 0; i < n; i++)
+		for (std::vector<rational>& x : v)
+			x.push_back(rational(num(gen), den(gen)));
+
+	report("operators", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[0][i] * v[1][i] + v[2][i] * v[3][i]).num();
+		keep(sum);
+	}), n, "expr");
+	report("fused", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += rational(fused(v[0][i]) * v[1][i]
+					+ fused(v[2][i]) * v[3][i]).num();
+		keep(sum);
+	}), n, "expr");
+}
+
+/*
+ * Comparison: std::sort of 1M int rationals with operator<, which
+ * cross-multiplies, against the sign of lhs - rhs as rational_t compared
+ * before.
+ */
+void bench_compare()
+{
+	cout << "compare:\n";
+	typedef lab::rational_t<int> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-4095, 4095);
+	std::uniform_int_distribution<int> den(1, 4095);
+	std::vector<rational> v;
+	for (size_t i = 0; i < n; i++)
+		v.push_back(rational(num(gen), den(gen)));
+
+	report("sort, operator<", seconds([&] {
+		std::vector<rational> w(v);
+		std::sort(w.begin(), w.end());
+		keep(w[0]);
+	}), n, "elem");
+	report("sort, subtraction", seconds([&] {
+		std::vector<rational> w(v);
+		std::sort(w.begin(), w.end(),
+			  [](rational const& a, rational const& b) {
+				return (a - b).num() < 0;
+			  });
+		keep(w[0]);
+	}), n, "elem");
+}
+
+/*
+ * std::ratio operands: 1M int rationals times std::milli and divided by
+ * std::ratio<3, 7>, against the same constants as rational_t operands.
+ * The ratio needs no gcd of its own and no final reduction.
+ */
+void bench_ratio()
+{
+	cout << "ratio:\n";
+	typedef lab::rational_t<int> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-4095, 4095);
+	std::uniform_int_distribution<int> den(1, 4095);
+	std::vector<rational> v;
+	for (size_t i = 0; i < n; i++)
+		v.push_back(rational(num(gen), den(gen)));
+
+	rational const milli(1, 1000), three_sevenths(3, 7);
+	report("rational operands", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[i] * milli / three_sevenths).num();
+		keep(sum);
+	}), n, "elem");
+	report("std::ratio operands", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[i] * std::milli() / std::ratio<3, 7>()).num();
+		keep(sum);
+	}), n, "elem");
+}
+
+/*
+ * Integer operands: r + 3, r * 3 and ++r over 1M int rationals, against
+ * the same operations with rational_t(3, 1) and rational_t(1, 1).
+ */
+void bench_integer()
+{
+	cout << "integer:\n";
+	typedef lab::rational_t<int> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-4095, 4095);
+	std::uniform_int_distribution<int> den(1, 4095);
+	std::vector<rational> v;
+	for (size_t i = 0; i < n; i++)
+		v.push_back(rational(num(gen), den(gen)));
+
+	rational const three(3, 1), one(1, 1);
+	report("r + rational(3, 1)", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[i] + three).num();
+		keep(sum);
+	}), n, "op");
+	report("r + 3", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[i] + 3).num();
+		keep(sum);
+	}), n, "op");
+	report("r * rational(3, 1)", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[i] * three).num();
+		keep(sum);
+	}), n, "op");
+	report("r * 3", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += (v[i] * 3).num();
+		keep(sum);
+	}), n, "op");
+	report("r += rational(1, 1)", seconds([&] {
+		std::vector<rational> w(v);
+		for (rational& x : w)
+			x += one;
+		keep(w[0]);
+	}), n, "op");
+	report("++r", seconds([&] {
+		std::vector<rational> w(v);
+		for (rational& x : w)
+			++x;
+		keep(w[0]);
+	}), n, "op");
+}
+
+/*
+ * Conversion to double: 1M int rationals one at a time and with
+ * batch::to_double, and 1M long long rationals with components of up to
+ * 63 bits, which mostly need the long division.
+ */
+void bench_floating()
+{
+	cout << "floating:\n";
+	size_t const n = 1 << 20;
+	std::mt19937_64 gen(1);
+	std::vector<lab::rational_t<int> > u;
+	lab::rational_soa_vector<int> v;
+	std::vector<lab::rational_t<long long> > w;
+	for (size_t i = 0; i < n; i++) {
+		int const d = static_cast<int>(gen() % INT_MAX) + 1;
+		u.push_back(lab::rational_t<int>(static_cast<int>(gen()), d));
+		v.push_back(u.back());
+		long long const e = static_cast<long long>(gen() >> 1) + 1;
+		w.push_back(lab::rational_t<long long>(
+				static_cast<long long>(gen()), e));
+	}
+
+	lab::vector<double> out(n);
+	report("int, scalar", seconds([&] {
+		for (size_t i = 0; i < n; i++)
+			out[i] = u[i];
+		keep(out[0]);
+	}), n, "elem");
+	report("int, batch::to_double", seconds([&] {
+		lab::batch::to_double(v, out);
+		keep(out[0]);
+	}), n, "elem");
+	report("long long, scalar", seconds([&] {
+		for (size_t i = 0; i < n; i++)
+			out[i] = w[i];
+		keep(out[0]);
+	}), n, "elem");
+}
+
+/*
+ * from_double: 1M doubles in [-1000, 1000) to int rationals with
+ * denominators of at most 1000 and 2^30, and to long long rationals with
+ * any denominator, through batch::from_double.
+ */
+void bench_from_double()
+{
+	cout << "from_double:\n";
+	size_t const n = 1 << 20;
+	std::mt19937_64 gen(1);
+	std::uniform_real_distribution<double> value(-1000, 1000);
+	std::vector<double> x(n);
+	for (double& y : x)
+		y = value(gen);
+
+	lab::rational_soa_vector<int> out;
+	report("int, max_denom 1000", seconds([&] {
+		lab::batch::from_double(x.data(), n, out, 1000);
+		keep(out.num_data()[0]);
+	}), n, "conv");
+	report("int, max_denom 2^30", seconds([&] {
+		lab::batch::from_double(x.data(), n, out, 1 << 30);
+		keep(out.num_data()[0]);
+	}), n, "conv");
+	lab::rational_soa_vector<long long> wide;
+	report("long long, any denominator", seconds([&] {
+		lab::batch::from_double(x.data(), n, wide);
+		keep(wide.num_data()[0]);
+	}), n, "conv");
+}
+
+/*
+ * Parsing: 1M lines "p / q" of int rationals with parse_rationals, in
+ * MB/s, against reading the same numbers from a std::istringstream.
+ */
+void bench_parse()
+{
+	cout << "parse:\n";
+	typedef lab::rational_t<int> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-1000000, 1000000);
+	std::uniform_int_distribution<int> den(1, 1000000);
+	std::string text;
+	for (size_t i = 0; i < n; i++) {
+		char line[lab::max_rational_chars<int> + 1];
+		char* const end = lab::to_chars(line, line + sizeof(line),
+				rational(num(gen), den(gen))).ptr;
+		text.append(line, end);
+		text += '\n';
+	}
+	double const mb = text.size() / 1e6;
+
+	lab::vector<rational> out;
+	double secs = seconds([&] {
+		out.clear();
+		lab::parse_rationals(text.data(), text.data() + text.size(),
+				     out);
+		keep(out[0]);
+	});
+	cout << "	parse_rationals: " << secs * 1e3 << " ms, " << mb / secs
+	     << " MB/s\n";
+	secs = seconds([&] {
+		std::istringstream in(text);
+		std::vector<rational> v;
+		int p, q;
+		char slash;
+		while (in >> p >> slash >> q)
+			v.push_back(rational(p, q));
+		keep(v[0]);
+	});
+	cout << "	std::istringstream: " << secs * 1e3 << " ms, "
+	     << mb / secs << " MB/s\n";
+}
+
+/*
+ * Formatting: 1M int rationals written into one buffer with
+ * batch::to_chars, from the columns of a rational_soa_vector and from a
+ * rational_t array, in MB/s, against operator<< into a std::ostringstream.
+ */
+void bench_format()
+{
+	cout << "format:\n";
+	typedef lab::rational_t<int> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-1000000, 1000000);
+	std::uniform_int_distribution<int> den(1, 1000000);
+	std::vector<rational> values;
+	lab::rational_soa_vector<int> columns;
+	for (size_t i = 0; i < n; i++) {
+		values.push_back(rational(num(gen), den(gen)));
+		columns.push_back(values.back());
+	}
+	std::string buffer(n * (lab::max_rational_chars<int> + 1), ' ');
+	char* const first = &buffer[0];
+	char* const last = first + buffer.size();
+	double const mb = (lab::batch::to_chars(values.data(), n, first,
+						last).ptr - first) / 1e6;
+
+	double secs = seconds([&] {
+		keep(*lab::batch::to_chars(columns.num_data(),
+					   columns.denom_data(), n, first,
+					   last).ptr);
+	});
+	cout << "	batch::to_chars, columns: " << secs * 1e3 << " ms, "
+	     << mb / secs << " MB/s\n";
+	secs = seconds([&] {
+		keep(*lab::batch::to_chars(values.data(), n, first,
+					   last).ptr);
+	});
+	cout << "	batch::to_chars, rational_t: " << secs * 1e3 << " ms, "
+	     << mb / secs << " MB/s\n";
+	secs = seconds([&] {
+		std::ostringstream out;
+		for (rational const& r : values)
+			out << r << '\n';
+		keep(out.str()[0]);
+	});
+	cout << "	std::ostringstream: " << secs * 1e3 << " ms, "
+	     << mb / secs << " MB/s\n";
+}
+
+/*
+ * Hashing: 1M random int rationals, mostly distinct, inserted into an
+ * empty map and then looked up, with rational_map and with
+ * std::unordered_map using std::hash<rational_t>.
+ */
+void bench_map()
+{
+	cout << "map:\n";
+	typedef lab::rational_t<int> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-1000000, 1000000);
+	std::uniform_int_distribution<int> den(1, 1000000);
+	std::vector<rational> keys;
+	for (size_t i = 0; i < n; i++)
+		keys.push_back(rational(num(gen), den(gen)));
+
+	report("rational_map, insert", seconds([&] {
+		lab::rational_map<rational, int> map;
+		for (size_t i = 0; i < n; i++)
+			map.insert(keys[i], static_cast<int>(i));
+		keep(map.size());
+	}), n, "op");
+	lab::rational_map<rational, int> map;
+	for (size_t i = 0; i < n; i++)
+		map.insert(keys[i], static_cast<int>(i));
+	report("rational_map, find", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += *map.find(keys[i]);
+		keep(sum);
+	}), n, "op");
+
+	report("std::unordered_map, insert", seconds([&] {
+		std::unordered_map<rational, int> map;
+		for (size_t i = 0; i < n; i++)
+			map.emplace(keys[i], static_cast<int>(i));
+		keep(map.size());
+	}), n, "op");
+	std::unordered_map<rational, int> reference;
+	for (size_t i = 0; i < n; i++)
+		reference.emplace(keys[i], static_cast<int>(i));
+	report("std::unordered_map, find", seconds([&] {
+		long long sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum += reference.find(keys[i])->second;
+		keep(sum);
+	}), n, "op");
+}
+
+/*
+ * Packed storage: 4M rationals with small components, as rational_t and as
+ * packed_rational words of half the size, scanned for one value and summed
+ * as doubles; then the same with 1% of the values too large to pack, which
+ * go to the spill table.
+ */
+template<typename IntT>
+void packed_run(const char* what, size_t n, double spilled)
+{
+	typedef lab::rational_t<IntT> rational;
+	typedef lab::packed_rational<IntT> packed_type;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-1000, 1000), den(1, 1000);
+	std::bernoulli_distribution spill(spilled);
+	IntT const large = std::numeric_limits<IntT>::max() / 3;
+	std::vector<rational> values;
+	lab::packed_rational_vector<IntT> packed;
+	for (size_t i = 0; i < n; i++) {
+		values.push_back(spill(gen) ? rational(large, den(gen))
+				 : rational(num(gen), den(gen)));
+		packed.push_back(values.back());
+	}
+	rational const key(1, 2);
+	typedef typename packed_type::word_type word_type;
+	word_type const key_word = packed_type(key).word();
+
+	cout << "	" << what << ", " << spilled * 100 << "% spilled\n";
+	cout << "		footprint: rational_t " << sizeof(rational)
+	     << " bytes, packed_rational "
+	     << (sizeof(key_word) * n
+		 + sizeof(rational) * packed.spill_count()) / double(n)
+	     << " bytes per element\n";
+	report("	rational_t, count ==", seconds([&] {
+		keep(std::count(values.begin(), values.end(), key));
+	}), n, "elem");
+	report("	packed_rational, count ==", seconds([&] {
+		keep(std::count(packed.data(), packed.data() + n, key_word));
+	}), n, "elem");
+	report("	rational_t, sum", seconds([&] {
+		double sum = 0;
+		for (rational const& r : values)
+			sum += static_cast<double>(r.num()) / r.denom();
+		keep(sum);
+	}), n, "elem");
+	report("	packed_rational, sum", seconds([&] {
+		double sum = 0;
+		for (size_t i = 0; i < n; i++) {
+			word_type const w = packed.data()[i];
+			rational const r = packed_type::spilled(w)
+					   ? rational(packed[i])
+					   : packed_type::from_word(w).unpack();
+			sum += static_cast<double>(r.num()) / r.denom();
+		}
+		keep(sum);
+	}), n, "elem");
+}
+
+void bench_packed()
+{
+	cout << "packed:\n";
+	size_t const n = 1 << 22;
+	packed_run<long long>("long long", n, 0);
+	packed_run<long long>("long long", n, 0.01);
+	packed_run<int>("int", n, 0);
+	packed_run<int>("int", n, 0.01);
+}
+
+/*
+ * Exact linear algebra: blocked products of rational_t<long long> matrices
+ * with small entries, and determinants of integer matrices with entries in
+ * [-9, 9] and bigint components, by Bareiss' elimination against Gaussian
+ * elimination with rational operators, which reduces after every step;
+ * then solve() on systems with bigint components and entries p / q,
+ * |p| <= 9, q <= 4, checked by their residual.
+ */
+void bench_matrix()
+{
+	cout << "matrix:\n";
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-9, 9), den(1, 4);
+
+	typedef lab::rational_t<long long> rational;
+	for (size_t n = 64; n <= 256; n *= 2) {
+		lab::matrix<rational> a(n, n), b(n, n);
+		for (size_t i = 0; i < n * n; i++) {
+			a.data()[i] = rational(num(gen), den(gen));
+			b.data()[i] = rational(num(gen), den(gen));
+		}
+		std::string const what = "product " + std::to_string(n) + "x"
+					  + std::to_string(n);
+		report(what.c_str(), seconds([&] {
+			keep((a * b)(0, 0));
+		}, 1), double(n) * n * n, "mul");
+	}
+
+	typedef lab::rational_t<lab::bigint> big;
+	for (size_t n = 32; n <= 128; n *= 2) {
+		lab::matrix<big> a(n, n);
+		for (size_t i = 0; i < n * n; i++)
+			a.data()[i] = big(lab::bigint(num(gen)), lab::bigint(1));
+		std::string what = "Bareiss determinant " + std::to_string(n)
+				   + "x" + std::to_string(n);
+		big det;
+		double secs = seconds([&] {
+			det = lab::determinant(a);
+		}, 1);
+		cout << "	" << what << ": " << secs * 1e3 << " ms\n";
+		if (n > 64)
+			continue;
+		what = "Gaussian determinant " + std::to_string(n) + "x"
+		       + std::to_string(n);
+		big gauss;
+		secs = seconds([&] {
+			lab::matrix<big> m = a;
+			gauss = big(lab::bigint(1), lab::bigint(1));
+			for (size_t k = 0; k < n; k++) {
+				size_t p = k;
+				while (p < n && m(p, k) == big())
+					p++;
+				if (p == n) {
+					gauss = big();
+					break;
+				}
+				if (p != k) {
+					for (size_t j = k; j < n; j++)
+						std::swap(m(k, j), m(p, j));
+					gauss = -gauss;
+				}
+				gauss *= m(k, k);
+				for (size_t i = k + 1; i < n; i++) {
+					big const f = m(i, k) / m(k, k);
+					for (size_t j = k + 1; j < n; j++)
+						m(i, j) -= f * m(k, j);
+				}
+			}
+		}, 1);
+		cout << "	" << what << ": " << secs * 1e3 << " ms\n";
+		if (!(gauss == det))
+			cout << "	the determinants differ\n";
+	}
+
+	for (size_t n = 64; n <= 256; n *= 2) {
+		lab::matrix<big> a(n, n);
+		lab::vector<big> b(n), x;
+		for (size_t i = 0; i < n * n; i++)
+			a.data()[i] = big(lab::bigint(num(gen)),
+					  lab::bigint(den(gen)));
+		for (size_t i = 0; i < n; i++)
+			b.data()[i] = big(lab::bigint(num(gen)),
+					  lab::bigint(den(gen)));
+		std::string const what = "solve " + std::to_string(n) + "x"
+					  + std::to_string(n);
+		double const secs = seconds([&] {
+			lab::solve(a, b, x);
+		}, 1);
+		cout << "	" << what << ": " << secs * 1e3 << " ms\n";
+		bool exact = true;
+		for (size_t i = 0; exact && i < n; i++) {
+			big sum;
+			for (size_t j = 0; j < n; j++)
+				sum += a(i, j) * x.data()[j];
+			exact = sum == b.data()[i];
+		}
+		if (!exact)
+			cout << "	the solution is not exact\n";
+	}
+}
+
+/*
+ * Parallel sums: 4M rational_t<long long> with denominators 1..16, summed
+ * with operator+= and with reduce() on pools of 0 to 7 workers, and
+ * prefix-summed with inclusive_scan(). Scaling past the number of hardware
+ * threads only measures the overhead.
+ */
+void bench_reduce()
+{
+	cout << "reduce:\n";
+	typedef lab::rational_t<long long> rational;
+	size_t const n = 1 << 22;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-100, 100), den(1, 16);
+	lab::vector<rational> v(n), out(n);
+	for (size_t i = 0; i < n; i++)
+		v.data()[i] = rational(num(gen), den(gen));
+
+	report("operator+=", seconds([&] {
+		rational sum;
+		for (size_t i = 0; i < n; i++)
+			sum += v.data()[i];
+		keep(sum);
+	}), n, "elem");
+	for (size_t threads = 0; threads < 8; threads = 2 * threads + 1) {
+		lab::thread_pool pool(threads);
+		std::string const workers = std::to_string(threads) + " workers";
+		report(("reduce, " + workers).c_str(), seconds([&] {
+			keep(lab::reduce(v, pool));
+		}), n, "elem");
+		report(("inclusive_scan, " + workers).c_str(), seconds([&] {
+			lab::inclusive_scan(v.data(), n, out.data(), pool);
+			keep(out.data()[n - 1]);
+		}), n, "elem");
+	}
+}
+
+/*
+ * Polynomials: a degree-4 polynomial with denominators up to 12 evaluated
+ * at 1M points with components below 100, by batch::evaluate and by
+ * Horner's scheme with the rational_t operators, for int and long long
+ * components.
+ */
+template<typename IntT>
+void polynomial_run(const char* what)
+{
+	typedef lab::rational_t<IntT> rational;
+	size_t const n = 1 << 20;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> num(-99, 99), den(1, 99);
+	lab::polynomial<rational> const p = {
+		rational(1, 2), rational(-3, 4), rational(5, 6),
+		rational(-7, 12), rational(2, 3)};
+	lab::rational_soa_vector<IntT> x, y;
+	for (size_t i = 0; i < n; i++)
+		x.push_back(rational(static_cast<IntT>(num(gen)),
+				     static_cast<IntT>(den(gen))));
+
+	cout << "	" << what << "\n";
+	report("	batch::evaluate", seconds([&] {
+		lab::batch::evaluate(p, x, y);
+		keep(y.num_data()[0]);
+	}), n, "point");
+	report("	operators", seconds([&] {
+		IntT sum = 0;
+		for (size_t i = 0; i < n; i++)
+			sum ^= p(rational(x.num_data()[i],
+					  x.denom_data()[i])).num();
+		keep(sum);
+	}), n, "point");
+}
+
+void bench_polynomial()
+{
+	cout << "polynomial:\n";
+	polynomial_run<int>("int");
+	polynomial_run<long long>("long long");
+}
+
+/*
+ * Filtered comparisons: 512K random rationals with components of half the
+ * width of IntT, sorted and scanned for their minimum and maximum with the
+ * exact operators and with the double filter.
+ */
+template<typename IntT>
+void filter_run(const char* what)
+{
+	typedef lab::rational_t<IntT> rational;
+	size_t const n = 1 << 19;
+	int const bits = 4 * static_cast<int>(sizeof(IntT)) - 1;
+	std::mt19937_64 gen(1);
+	std::vector<rational> values;
+	for (size_t i = 0; i < n; i++) {
+		IntT const p = static_cast<IntT>(gen() & ((1ULL << bits) - 1));
+		IntT const q = static_cast<IntT>(gen() & ((1ULL << bits) - 1));
+		values.push_back(rational(static_cast<IntT>(p - (q >> 1)),
+					  static_cast<IntT>(q + 1)));
+	}
+
+	cout << "	" << what << "\n";
+	std::vector<rational> v;
+	report("	std::sort", seconds([&] {
+		v = values;
+		std::sort(v.begin(), v.end());
+		keep(v[0]);
+	}), n, "elem");
+	report("	filtered_sort", seconds([&] {
+		v = values;
+		lab::filtered_sort(v.data(), n);
+		keep(v[0]);
+	}), n, "elem");
+	report("	std::minmax_element", seconds([&] {
+		auto const r = std::minmax_element(values.begin(), values.end());
+		keep(*r.first);
+		keep(*r.second);
+	}), n, "elem");
+	report("	filtered min and max", seconds([&] {
+		keep(*lab::filtered_min_element(values.data(), n));
+		keep(*lab::filtered_max_element(values.data(), n));
+	}), n, "elem");
+}
+
+void bench_filter()
+{
+	cout << "filter:\n";
+	filter_run<int>("int");
+	filter_run<long long>("long long");
+#ifdef __SIZEOF_INT128__
+	filter_run<__int128>("__int128");
+#endif
+}
+
+/*
+ * Radix sort: 4M integers and 1M rationals sorted by radix_sort() on the
+ * calling thread and on a pool of 3 workers, against std::sort. Values
+ * below 1000 leave the high bytes of the integers unchanged, which makes
+ * their passes counting-only.
+ */
+template<typename T, typename Next>
+void radix_run(const char* what, size_t n, Next next)
+{
+	std::vector<T> values;
+	for (size_t i = 0; i < n; i++)
+		values.push_back(next());
+	std::vector<T> v;
+	lab::thread_pool serial(0), pool(3);
+
+	cout << "	" << what << "\n";
+	report("	std::sort", seconds([&] {
+		v = values;
+		std::sort(v.begin(), v.end());
+		keep(v[0]);
+	}), n, "elem");
+	report("	radix_sort", seconds([&] {
+		v = values;
+		lab::radix_sort(v.data(), n, serial);
+		keep(v[0]);
+	}), n, "elem");
+	report("	radix_sort, 3 workers", seconds([&] {
+		v = values;
+		lab::radix_sort(v.data(), n, pool);
+		keep(v[0]);
+	}), n, "elem");
+}
+
+void bench_radix()
+{
+	cout << "radix:\n";
+	std::mt19937_64 gen(1);
+	typedef lab::rational_t<int> rational;
+	typedef lab::rational_t<long long> rational_ll;
+	radix_run<int>("int", 1 << 22, [&] { return static_cast<int>(gen()); });
+	radix_run<int>("int below 1000", 1 << 22, [&] {
+		return static_cast<int>(gen() % 1000);
+	});
+	radix_run<long long>("long long", 1 << 22, [&] {
+		return static_cast<long long>(gen());
+	});
+	radix_run<rational>("rational_t<int>", 1 << 20, [&] {
+		return rational(static_cast<int>(gen() % 2000001) - 1000000,
+				static_cast<int>(gen() % 1000000) + 1);
+	});
+	radix_run<rational_ll>("rational_t<long long>", 1 << 20, [&] {
+		return rational_ll(static_cast<long long>(gen() >> 1),
+				   static_cast<long long>(gen() >> 1) + 1);
+	});
+}
+
+// 1, 2, 4, ... and then all threads
+unsigned next_threads(unsigned t, unsigned threads)
+{
+	return t == threads ? threads + 1 : 2 * t < threads ? 2 * t : threads;
+}
+
+/*
+ * Parallel sort: 100M random ints sorted by std::sort and by
+ * parallel_sort() on pools from one thread to all hardware threads, then
+ * merged back from 8 sorted runs by parallel_merge(). One run each: a
+ * single sort takes seconds.
+ */
+void bench_sort()
+{
+	cout << "sort:\n";
+	size_t const n = 100000000;
+	size_t const runs = 8;
+	std::mt19937_64 gen(1);
+	lab::vector<int> values(n);
+	for (size_t i = 0; i < n; i++)
+		values.data()[i] = static_cast<int>(gen());
+	lab::vector<int> v(values);
+	unsigned const hardware = std::thread::hardware_concurrency();
+	unsigned const threads = hardware ? hardware : 1;
+
+	report("std::sort", seconds([&] {
+		std::copy(values.data(), values.data() + n, v.data());
+		std::sort(v.data(), v.data() + n);
+		keep(v.data()[0]);
+	}, 1), n, "elem");
+	for (unsigned t = 1; t <= threads; t = next_threads(t, threads)) {
+		lab::thread_pool pool(t - 1);
+		std::string const what =
+			"parallel_sort, " + std::to_string(t) + " threads";
+		report(what.c_str(), seconds([&] {
+			std::copy(values.data(), values.data() + n, v.data());
+			lab::parallel_sort(v, pool);
+			keep(v.data()[0]);
+		}, 1), n, "elem");
+	}
+
+	std::vector<lab::vector<int> > sorted;
+	for (size_t r = 0; r < runs; r++) {
+		lab::vector<int> run(n / runs);
+		std::copy(values.data() + r * (n / runs),
+			  values.data() + (r + 1) * (n / runs), run.data());
+		std::sort(run.data(), run.data() + n / runs);
+		sorted.push_back(std::move(run));
+	}
+	for (unsigned t = 1; t <= threads; t = next_threads(t, threads)) {
+		lab::thread_pool pool(t - 1);
+		std::string const what =
+			"parallel_merge of 8 runs, " + std::to_string(t)
+			+ " threads";
+		report(what.c_str(), seconds([&] {
+			lab::parallel_merge(sorted.data(), runs, v, pool);
+			keep(v.data()[0]);
+		}, 1), n, "elem");
+	}
+}
+
+struct benchmark {
+	const char* name;
+	void (*run)();
+};
+
+benchmark const benchmarks[] = {
+	{"queue", bench_queue},
+	{"batch", bench_batch},
+	{"gcd", bench_gcd},
+	{"overflow", bench_overflow},
+	{"harmonic", bench_harmonic},
+	{"lazy", bench_lazy},
+	{"fused", bench_fused},
+	{"compare", bench_compare},
+	{"ratio", bench_ratio},
+	{"integer", bench_integer},
+	{"floating", bench_floating},
+	{"from_double", bench_from_double},
+	{"parse", bench_parse},
+	{"format", bench_format},
+	{"map", bench_map},
+	{"packed", bench_packed},
+	{"matrix", bench_matrix},
+	{"reduce", bench_reduce},
+	{"polynomial", bench_polynomial},
+	{"filter", bench_filter},
+	{"radix", bench_radix},
+	{"sort", bench_sort},
+};
+
+int main(int argc, char** argv)
+{
+	cout << "hardware threads: " << std::thread::hardware_concurrency()
+	     << "\n";
+	for (benchmark const& b : benchmarks) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++) {
+			if (!std::strcmp(argv[i], "list"))
+				cout << b.name << "\n";
+			selected |= !std::strcmp(argv[i], b.name);
+		}
+		if (selected)
+			b.run();
+	}
+	return 0;
+}
@@ -0,0 +1,667 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>            // std::invalid_argument
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "gcd.h"
+#include "hash.h"
+#include "overflow.h"
+
+namespace lab {
+
+/**
+ * @brief bigint is a signed integer of unlimited precision.
+ *
+ * Magnitudes that fit into 64 bits are kept inline, so small values never
+ * touch the heap; larger ones are stored as 32-bit limbs, least significant
+ * first. Multiplication switches from the schoolbook method to Karatsuba
+ * for long operands and division uses Knuth's algorithm D.
+ *
+ * Division truncates toward zero and the remainder takes the sign of the
+ * dividend, as for built-in integers. Division by zero throws
+ * std::invalid_argument.
+ *
+ * rational_t<bigint> is a rational number that never overflows.
+ */
+class bigint {
+public:
+	typedef std::uint32_t		limb_type;
+	typedef std::vector<limb_type>	limbs_type;
+private:
+	typedef std::uint64_t		double_limb_type;
+	typedef std::int64_t		signed_double_limb_type;
+
+	enum : size_t {
+		limb_bits = 32,
+		karatsuba_threshold = 32
+	};
+
+	bool negative_;
+	std::uint64_t small_;	// the magnitude while limbs_ is empty
+	limbs_type limbs_;	// the magnitude otherwise, always > 2^64 - 1
+
+	// Read-only limbs of a magnitude, whatever its representation.
+	struct view {
+		limb_type buf[2];
+		const limb_type* data;
+		size_t size;
+
+		explicit view(bigint const& x) noexcept
+		{
+			if (x.limbs_.empty()) {
+				buf[0] = static_cast<limb_type>(x.small_);
+				buf[1] = static_cast<limb_type>(x.small_ >> limb_bits);
+				data = buf;
+				size = buf[1] ? 2 : buf[0] ? 1 : 0;
+			} else {
+				data = x.limbs_.data();
+				size = x.limbs_.size();
+			}
+		}
+		view(view const&) = delete;
+		view& operator=(view const&) = delete;
+	};
+
+	bool is_small() const noexcept { return limbs_.empty(); }
+	bool is_zero() const noexcept { return is_small() && !small_; }
+
+	static bigint from_small(std::uint64_t magnitude, bool negative) noexcept
+	{
+		bigint result;
+		result.small_ = magnitude;
+		result.negative_ = negative && magnitude;
+		return result;
+	}
+
+	// Takes ownership of a magnitude that may have leading zero limbs.
+	static bigint from_limbs(limbs_type&& magnitude, bool negative)
+	{
+		size_t size = magnitude.size();
+		while (size && !magnitude[size - 1])
+			--size;
+
+		bigint result;
+		if (size <= 2) {
+			result.small_ = size ? magnitude[0] : 0;
+			if (size == 2)
+				result.small_ |= double_limb_type(magnitude[1])
+						 << limb_bits;
+		} else {
+			magnitude.resize(size);
+			result.limbs_ = std::move(magnitude);
+		}
+		result.negative_ = negative && !result.is_zero();
+		return result;
+	}
+
+	// Compares magnitudes without leading zero limbs.
+	static int compare(const limb_type* a, size_t an,
+			   const limb_type* b, size_t bn) noexcept
+	{
+		if (an != bn)
+			return an < bn ? -1 : 1;
+		while (an--)
+			if (a[an] != b[an])
+				return a[an] < b[an] ? -1 : 1;
+		return 0;
+	}
+
+	static int compare_magnitude(bigint const& a, bigint const& b) noexcept
+	{
+		if (a.is_small() && b.is_small())
+			return a.small_ < b.small_ ? -1 : a.small_ > b.small_;
+		view const va(a), vb(b);
+		return compare(va.data, va.size, vb.data, vb.size);
+	}
+
+	// r[0, rn) += x[0, xn), xn <= rn; the sum must fit into rn limbs.
+	static void add_into(limb_type* r, size_t rn,
+			     const limb_type* x, size_t xn) noexcept
+	{
+		double_limb_type carry = 0;
+		size_t i = 0;
+		for (; i != xn; ++i) {
+			carry += double_limb_type(r[i]) + x[i];
+			r[i] = static_cast<limb_type>(carry);
+			carry >>= limb_bits;
+		}
+		for (; carry && i != rn; ++i) {
+			carry += r[i];
+			r[i] = static_cast<limb_type>(carry);
+			carry >>= limb_bits;
+		}
+	}
+
+	// r[0, rn) -= x[0, xn); the difference must not be negative.
+	static void sub_into(limb_type* r, size_t rn,
+			     const limb_type* x, size_t xn) noexcept
+	{
+		signed_double_limb_type borrow = 0;
+		size_t i = 0;
+		for (; i != xn; ++i) {
+			borrow += signed_double_limb_type(r[i]) - x[i];
+			r[i] = static_cast<limb_type>(borrow);
+			borrow >>= limb_bits;
+		}
+		for (; borrow && i != rn; ++i) {
+			borrow += r[i];
+			r[i] = static_cast<limb_type>(borrow);
+			borrow >>= limb_bits;
+		}
+	}
+
+	// out[0, an + bn) = a * b, schoolbook method
+	static void mul_basecase(const limb_type* a, size_t an,
+				 const limb_type* b, size_t bn,
+				 limb_type* out) noexcept
+	{
+		std::fill(out, out + an + bn, limb_type(0));
+		for (size_t i = 0; i != an; ++i) {
+			double_limb_type carry = 0;
+			for (size_t j = 0; j != bn; ++j) {
+				carry += double_limb_type(a[i]) * b[j] + out[i + j];
+				out[i + j] = static_cast<limb_type>(carry);
+				carry >>= limb_bits;
+			}
+			out[i + bn] = static_cast<limb_type>(carry);
+		}
+	}
+
+	// out[0, an + bn) = a * b; Karatsuba for long, balanced operands
+	static void mul(const limb_type* a, size_t an,
+			const limb_type* b, size_t bn, limb_type* out)
+	{
+		if (an < bn) {
+			std::swap(a, b);
+			std::swap(an, bn);
+		}
+		if (bn < karatsuba_threshold) {
+			mul_basecase(a, an, b, bn, out);
+			return;
+		}
+		if (an >= 2 * bn) {
+			// cut the longer operand into balanced pieces
+			std::fill(out, out + an + bn, limb_type(0));
+			limbs_type part(2 * bn);
+			for (size_t i = 0; i < an; i += bn) {
+				size_t const len = std::min(bn, an - i);
+				mul(a + i, len, b, bn, part.data());
+				add_into(out + i, an + bn - i, part.data(), len + bn);
+			}
+			return;
+		}
+
+		// a = a1 * B^m + a0, b = b1 * B^m + b0, with bn > m
+		size_t const m = an / 2;
+		size_t const n = an + bn;
+		mul(a, m, b, m, out);				// z0
+		mul(a + m, an - m, b + m, bn - m, out + 2 * m);	// z2
+
+		limbs_type sa(std::max(m, an - m) + 1), sb(std::max(m, bn - m) + 1);
+		std::copy(a, a + m, sa.begin());
+		add_into(sa.data(), sa.size(), a + m, an - m);
+		std::copy(b, b + m, sb.begin());
+		add_into(sb.data(), sb.size(), b + m, bn - m);
+
+		limbs_type z1(sa.size() + sb.size());
+		mul(sa.data(), sa.size(), sb.data(), sb.size(), z1.data());
+		sub_into(z1.data(), z1.size(), out, 2 * m);
+		sub_into(z1.data(), z1.size(), out + 2 * m, n - 2 * m);
+
+		size_t z1n = z1.size();
+		while (z1n && !z1[z1n - 1])
+			--z1n;
+		add_into(out + m, n - m, z1.data(), z1n);
+	}
+
+	// out[0, n) = x[0, n) << s, 0 <= s < limb_bits; returns the bits
+	// shifted out of the top limb
+	static limb_type shift_left(const limb_type* x, size_t n, int s,
+				    limb_type* out) noexcept
+	{
+		limb_type carry = 0;
+		for (size_t i = 0; i != n; ++i) {
+			out[i] = (x[i] << s) | carry;
+			carry = s ? limb_type(x[i] >> (limb_bits - s)) : 0;
+		}
+		return carry;
+	}
+
+	// q = u / v, r = u % v for magnitudes without leading zero limbs,
+	// un >= vn >= 1. q gets un - vn + 1 limbs, r gets vn limbs.
+	static void divmod(const limb_type* u, size_t un,
+			   const limb_type* v, size_t vn,
+			   limb_type* q, limb_type* r)
+	{
+		if (vn == 1) {
+			double_limb_type rem = 0;
+			for (size_t i = un; i--; ) {
+				double_limb_type const cur = (rem << limb_bits) | u[i];
+				q[i] = static_cast<limb_type>(cur / v[0]);
+				rem = cur % v[0];
+			}
+			r[0] = static_cast<limb_type>(rem);
+			return;
+		}
+
+		// Knuth, TAOCP vol. 2, 4.3.1, algorithm D
+		double_limb_type const base = double_limb_type(1) << limb_bits;
+		int const s = __builtin_clz(v[vn - 1]);
+		limbs_type vs(vn), us(un + 1);
+		shift_left(v, vn, s, vs.data());
+		us[un] = shift_left(u, un, s, us.data());
+
+		for (size_t j = un - vn + 1; j--; ) {
+			double_limb_type const num =
+				(double_limb_type(us[j + vn]) << limb_bits)
+				| us[j + vn - 1];
+			double_limb_type qhat = num / vs[vn - 1];
+			double_limb_type rhat = num % vs[vn - 1];
+			while (qhat >= base || qhat * vs[vn - 2]
+			       > ((rhat << limb_bits) | us[j + vn - 2])) {
+				--qhat;
+				rhat += vs[vn - 1];
+				if (rhat >= base)
+					break;
+			}
+
+			signed_double_limb_type borrow = 0, t;
+			for (size_t i = 0; i != vn; ++i) {
+				double_limb_type const p = qhat * vs[i];
+				t = signed_double_limb_type(us[i + j]) - borrow
+				    - signed_double_limb_type(p & 0xFFFFFFFFu);
+				us[i + j] = static_cast<limb_type>(t);
+				borrow = signed_double_limb_type(p >> limb_bits)
+					 - (t >> limb_bits);
+			}
+			t = signed_double_limb_type(us[j + vn]) - borrow;
+			us[j + vn] = static_cast<limb_type>(t);
+
+			q[j] = static_cast<limb_type>(qhat);
+			if (t < 0) {
+				--q[j];
+				double_limb_type carry = 0;
+				for (size_t i = 0; i != vn; ++i) {
+					carry += double_limb_type(us[i + j]) + vs[i];
+					us[i + j] = static_cast<limb_type>(carry);
+					carry >>= limb_bits;
+				}
+				us[j + vn] = static_cast<limb_type>(us[j + vn] + carry);
+			}
+		}
+
+		for (size_t i = 0; i != vn; ++i)
+			r[i] = (us[i] >> s)
+			       | (s ? limb_type(us[i + 1] << (limb_bits - s)) : 0);
+	}
+
+	// |a| + |b| with the given sign
+	static bigint add_magnitudes(bigint const& a, bigint const& b,
+				     bool negative)
+	{
+		std::uint64_t sum;
+		if (a.is_small() && b.is_small()
+		    && !__builtin_add_overflow(a.small_, b.small_, &sum))
+			return from_small(sum, negative);
+
+		view const va(a), vb(b);
+		limbs_type result(std::max(va.size, vb.size) + 1);
+		std::copy(va.data, va.data + va.size, result.begin());
+		add_into(result.data(), result.size(), vb.data, vb.size);
+		return from_limbs(std::move(result), negative);
+	}
+
+	// |a| - |b| with the given sign, |a| >= |b|
+	static bigint sub_magnitudes(bigint const& a, bigint const& b,
+				     bool negative)
+	{
+		if (a.is_small())
+			return from_small(a.small_ - b.small_, negative);
+
+		view const vb(b);
+		limbs_type result(a.limbs_);
+		sub_into(result.data(), result.size(), vb.data, vb.size);
+		return from_limbs(std::move(result), negative);
+	}
+
+	// a + b, or a - b when subtract is set
+	static bigint add(bigint const& a, bigint const& b, bool subtract)
+	{
+		bool const b_negative = b.negative_ != subtract;
+		if (a.negative_ == b_negative)
+			return add_magnitudes(a, b, a.negative_);
+		if (compare_magnitude(a, b) >= 0)
+			return sub_magnitudes(a, b, a.negative_);
+		return sub_magnitudes(b, a, b_negative);
+	}
+
+	static void divmod(bigint const& a, bigint const& b,
+			   bigint* quotient, bigint* remainder)
+	{
+		if (b.is_zero())
+			throw std::invalid_argument("Division by zero.");
+
+		bool const q_negative = a.negative_ != b.negative_;
+		if (a.is_small() && b.is_small()) {
+			if (quotient)
+				*quotient = from_small(a.small_ / b.small_, q_negative);
+			if (remainder)
+				*remainder = from_small(a.small_ % b.small_, a.negative_);
+			return;
+		}
+		if (compare_magnitude(a, b) < 0) {
+			if (remainder)
+				*remainder = a;
+			if (quotient)
+				*quotient = bigint();
+			return;
+		}
+
+		view const va(a), vb(b);
+		limbs_type q(va.size - vb.size + 1), r(vb.size);
+		divmod(va.data, va.size, vb.data, vb.size, q.data(), r.data());
+		bool const r_negative = a.negative_;
+		if (quotient)
+			*quotient = from_limbs(std::move(q), q_negative);
+		if (remainder)
+			*remainder = from_limbs(std::move(r), r_negative);
+	}
+public:
+	/**
+	 *  @brief  Creates a zero.
+	 */
+	bigint() noexcept : negative_(false), small_(0) {}
+
+	/**
+	 *  @brief  Converts a built-in integer.
+	 */
+	template<typename IntT, typename = typename std::enable_if<
+			detail::is_builtin_integer<IntT>::value>::type>
+	bigint(IntT value) : negative_(value < 0), small_(0)
+	{
+		typedef typename detail::make_unsigned<IntT>::type unsigned_type;
+
+		unsigned_type magnitude = detail::magnitude<unsigned_type>(value);
+		if (sizeof(unsigned_type) <= sizeof(std::uint64_t)
+		    || magnitude == static_cast<std::uint64_t>(magnitude)) {
+			small_ = static_cast<std::uint64_t>(magnitude);
+			return;
+		}
+		while (magnitude) {
+			limbs_.push_back(static_cast<limb_type>(magnitude));
+			magnitude = static_cast<unsigned_type>(
+				magnitude >> (limb_bits / 2) >> (limb_bits / 2));
+		}
+	}
+
+	explicit operator bool() const noexcept { return !is_zero(); }
+
+	explicit operator long double() const noexcept
+	{
+		long double result = 0;
+		view const v(*this);
+		for (size_t i = v.size; i--; )
+			result = result * 4294967296.0L + v.data[i];
+		return negative_ ? -result : result;
+	}
+	explicit operator double() const noexcept
+	{
+		return static_cast<double>(static_cast<long double>(*this));
+	}
+
+	/**
+	 * @brief Returns the number of significant bits of the magnitude.
+	 */
+	size_t bit_width() const noexcept
+	{
+		view const v(*this);
+		if (!v.size)
+			return 0;
+		return v.size * limb_bits - __builtin_clz(v.data[v.size - 1]);
+	}
+
+	friend bigint abs(bigint const& number)
+	{
+		bigint result(number);
+		result.negative_ = false;
+		return result;
+	}
+
+	friend std::string to_string(bigint const& number)
+	{
+		if (number.is_small()) {
+			std::string digits = std::to_string(number.small_);
+			return number.negative_ ? "-" + digits : digits;
+		}
+
+		// peel off nine decimal digits at a time
+		limb_type const chunk = 1000000000u;
+		limbs_type magnitude(number.limbs_), quotient(magnitude.size());
+		std::string digits;
+		size_t size = magnitude.size();
+		while (size) {
+			limb_type rem;
+			divmod(magnitude.data(), size, &chunk, 1,
+			       quotient.data(), &rem);
+			for (int i = 0; i != 9; ++i) {
+				digits.push_back(static_cast<char>('0' + rem % 10));
+				rem /= 10;
+			}
+			magnitude.swap(quotient);
+			while (size && !magnitude[size - 1])
+				--size;
+		}
+		while (digits.size() > 1 && digits.back() == '0')
+			digits.pop_back();
+		if (number.negative_)
+			digits.push_back('-');
+		std::reverse(digits.begin(), digits.end());
+		return digits;
+	}
+
+	friend std::ostream& operator<<(std::ostream& os, bigint const& number)
+	{
+		return os << to_string(number);
+	}
+
+	//unary +
+	friend bigint const& operator+(bigint const& number) noexcept
+	{
+		return number;
+	}
+
+	//unary -
+	friend bigint operator-(bigint const& number)
+	{
+		bigint result(number);
+		result.negative_ = !result.negative_ && !result.is_zero();
+		return result;
+	}
+
+	friend bigint operator+(bigint const& lhs, bigint const& rhs)
+	{
+		return add(lhs, rhs, false);
+	}
+
+	friend bigint operator-(bigint const& lhs, bigint const& rhs)
+	{
+		return add(lhs, rhs, true);
+	}
+
+	friend bigint operator*(bigint const& lhs, bigint const& rhs)
+	{
+		bool const negative = lhs.negative_ != rhs.negative_;
+#ifdef __SIZEOF_INT128__
+		if (lhs.is_small() && rhs.is_small()) {
+			unsigned __int128 const p =
+				static_cast<unsigned __int128>(lhs.small_) * rhs.small_;
+			if (!(p >> 64))
+				return from_small(static_cast<std::uint64_t>(p),
+						  negative);
+		}
+#endif
+		view const a(lhs), b(rhs);
+		if (!a.size || !b.size)
+			return bigint();
+		limbs_type result(a.size + b.size);
+		mul(a.data, a.size, b.data, b.size, result.data());
+		return from_limbs(std::move(result), negative);
+	}
+
+	friend bigint operator/(bigint const& lhs, bigint const& rhs)
+	{
+		bigint quotient;
+		divmod(lhs, rhs, &quotient, nullptr);
+		return quotient;
+	}
+
+	friend bigint operator%(bigint const& lhs, bigint const& rhs)
+	{
+		bigint remainder;
+		divmod(lhs, rhs, nullptr, &remainder);
+		return remainder;
+	}
+
+	friend bigint& operator+=(bigint& lhs, bigint const& rhs)
+	{
+		return lhs = lhs + rhs;
+	}
+	friend bigint& operator-=(bigint& lhs, bigint const& rhs)
+	{
+		return lhs = lhs - rhs;
+	}
+	friend bigint& operator*=(bigint& lhs, bigint const& rhs)
+	{
+		return lhs = lhs * rhs;
+	}
+	friend bigint& operator/=(bigint& lhs, bigint const& rhs)
+	{
+		return lhs = lhs / rhs;
+	}
+	friend bigint& operator%=(bigint& lhs, bigint const& rhs)
+	{
+		return lhs = lhs % rhs;
+	}
+
+	friend bigint& operator++(bigint& number) { return number += 1; }
+	friend bigint& operator--(bigint& number) { return number -= 1; }
+	friend bigint operator++(bigint& number, int)
+	{
+		bigint old(number);
+		++number;
+		return old;
+	}
+	friend bigint operator--(bigint& number, int)
+	{
+		bigint old(number);
+		--number;
+		return old;
+	}
+
+	friend bool operator==(bigint const& lhs, bigint const& rhs) noexcept
+	{
+		return lhs.negative_ == rhs.negative_
+		       && compare_magnitude(lhs, rhs) == 0;
+	}
+	friend bool operator!=(bigint const& lhs, bigint const& rhs) noexcept
+	{
+		return !(lhs == rhs);
+	}
+	friend bool operator<(bigint const& lhs, bigint const& rhs) noexcept
+	{
+		if (lhs.negative_ != rhs.negative_)
+			return lhs.negative_;
+		int const cmp = compare_magnitude(lhs, rhs);
+		return lhs.negative_ ? cmp > 0 : cmp < 0;
+	}
+	friend bool operator>(bigint const& lhs, bigint const& rhs) noexcept
+	{
+		return rhs < lhs;
+	}
+	friend bool operator<=(bigint const& lhs, bigint const& rhs) noexcept
+	{
+		return !(rhs < lhs);
+	}
+	friend bool operator>=(bigint const& lhs, bigint const& rhs) noexcept
+	{
+		return !(lhs < rhs);
+	}
+
+	friend struct std::hash<bigint>;
+
+	/**
+	 * @brief Greatest common divisor of |a| and |b|.
+	 *
+	 * Euclid's algorithm on the long representation, switching to the
+	 * binary gcd of lab::gcd as soon as both values fit into 64 bits.
+	 */
+	friend bigint gcd(bigint const& a, bigint const& b)
+	{
+		bigint u = abs(a), v = abs(b);
+		while (!v.is_zero()) {
+			if (u.is_small() && v.is_small())
+				return from_small(lab::gcd(u.small_, v.small_), false);
+			u = u % v;
+			std::swap(u, v);
+		}
+		return u;
+	}
+};
+
+} // namespace lab
+
+namespace std {
+
+template<>
+class numeric_limits<lab::bigint> {
+public:
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = true;
+	static constexpr bool is_exact = true;
+	static constexpr bool is_bounded = false;
+	static constexpr bool is_modulo = false;
+	static constexpr int radix = 2;
+	static constexpr int digits = 0;
+	static constexpr int digits10 = 0;
+
+	static lab::bigint min() noexcept { return lab::bigint(); }
+	static lab::bigint max() noexcept { return lab::bigint(); }
+	static lab::bigint lowest() noexcept { return lab::bigint(); }
+};
+
+/**
+ * @brief Hashes the magnitude 64 bits at a time and the sign, so that
+ * rational_t<bigint> can be hashed too.
+ */
+template<>
+struct hash<lab::bigint> {
+	size_t operator()(lab::bigint const& x) const noexcept
+	{
+		using namespace lab::detail;
+		std::uint64_t h = hash_seed0 ^ x.negative_;
+		if (x.is_small())
+			return static_cast<size_t>(hash_mix(h ^ x.small_,
+							    hash_seed1));
+		lab::bigint::view const v(x);
+		for (size_t i = 0; i < v.size; i += 2) {
+			std::uint64_t word = v.data[i];
+			if (i + 1 < v.size)
+				word |= static_cast<std::uint64_t>(
+						v.data[i + 1]) << 32;
+			h = hash_mix(h ^ word, hash_seed1);
+		}
+		return static_cast<size_t>(hash_mix(h ^ v.size, hash_seed2));
+	}
+};
+
+} // namespace std
+
+#endif // BIGINT_H
@@ -0,0 +1,282 @@
+#ifndef CONCURRENT_QUEUE_H
+#define CONCURRENT_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace lab {
+
+namespace detail {
+
+enum : size_t { cache_line_size = 64 };
+
+inline size_t round_up_pow2(size_t n)
+{
+	size_t constexpr top = ~(~size_t(0) >> 1);
+	if (n > top)
+		throw std::length_error("Capacity is too large.");
+	size_t p = 1;
+	while (p < n)
+		p <<= 1;
+	return p;
+}
+
+} // namespace detail
+
+/**
+ * @brief spsc_queue is a bounded lock-free queue for exactly one producer
+ * thread and one consumer thread.
+ *
+ * The ring is a preallocated array whose size is rounded up to a power of
+ * two. Producer and consumer indices live on separate cache lines,
+ * and each side keeps a cached copy of the other side's index so the shared
+ * line is only touched when the cached value runs out.
+ */
+template<typename T>
+class spsc_queue {
+public:
+	typedef size_t		size_type;
+	typedef T*		pointer;
+	typedef const T*	const_pointer;
+	typedef T&		reference;
+	typedef const T&	const_reference;
+	typedef T		value_type;
+private:
+	std::unique_ptr<value_type[]> buffer;
+	size_type const mask;
+
+	alignas(detail::cache_line_size) std::atomic<size_type> head;
+	size_type cached_tail;	// consumer's view of tail
+
+	alignas(detail::cache_line_size) std::atomic<size_type> tail;
+	size_type cached_head;	// producer's view of head
+public:
+	/**
+	 *  @brief  Creates an empty queue.
+	 *  @param  capacity The minimal number of elements the queue holds,
+	 *  rounded up to a power of two; std::length_error is thrown when
+	 *  that power does not fit size_type.
+	 */
+	explicit spsc_queue(size_type capacity) noexcept(false)
+		: buffer(new value_type[detail::round_up_pow2(capacity)]),
+		  mask(detail::round_up_pow2(capacity) - 1),
+		  head(0), cached_tail(0), tail(0), cached_head(0)
+	{
+		if (!capacity)
+			throw std::invalid_argument("Capacity can't be 0.");
+	}
+
+	spsc_queue(spsc_queue const&) = delete;
+	spsc_queue& operator=(spsc_queue const&) = delete;
+
+	size_type capacity() const noexcept { return mask + 1; }
+
+	/**
+	 * @brief Approximate number of elements; exact only when neither
+	 * side is running.
+	 */
+	size_type size() const noexcept
+	{
+		return tail.load(std::memory_order_acquire)
+		       - head.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Producer side: add a range of elements.
+	 * @param p:		pointer to the first element
+	 * @param p_size:	size of the range
+	 * @return		number of elements actually enqueued, which is
+	 *			less than p_size when the queue fills up.
+	 */
+	size_type try_push(const_pointer p, size_type p_size)
+	{
+		size_type const t = tail.load(std::memory_order_relaxed);
+		if (capacity() - (t - cached_head) < p_size)
+			cached_head = head.load(std::memory_order_acquire);
+
+		size_type const room = capacity() - (t - cached_head);
+		size_type const n = (room < p_size) ? room : p_size;
+		pointer const ring = buffer.get();
+		for (size_type i = 0; i != n; ++i)
+			ring[(t + i) & mask] = p[i];
+
+		tail.store(t + n, std::memory_order_release);
+		return n;
+	}
+	bool try_push(const_reference element)
+	{
+		return try_push(&element, 1) == 1;
+	}
+
+	/**
+	 * @brief Consumer side: take up to n elements from the front.
+	 * @param p:	destination of at least n elements
+	 * @param n:	maximal number of elements to dequeue
+	 * @return	number of elements actually dequeued.
+	 */
+	size_type try_pop(pointer p, size_type n)
+	{
+		size_type const h = head.load(std::memory_order_relaxed);
+		if (cached_tail - h < n)
+			cached_tail = tail.load(std::memory_order_acquire);
+
+		size_type const avail = cached_tail - h;
+		if (avail < n)
+			n = avail;
+		const_pointer const ring = buffer.get();
+		for (size_type i = 0; i != n; ++i)
+			p[i] = ring[(h + i) & mask];
+
+		head.store(h + n, std::memory_order_release);
+		return n;
+	}
+	bool try_pop(reference element)
+	{
+		return try_pop(&element, 1) == 1;
+	}
+};
+
+/**
+ * @brief mpmc_queue is a bounded lock-free queue for any number of
+ * producers and consumers.
+ *
+ * Each slot of the preallocated array carries a sequence number
+ * telling whether it is ready to be written or read in the current lap,
+ * so producers and consumers only contend on their own position counter.
+ * Batched operations claim a run of consecutive ready slots with a single
+ * compare-and-swap.
+ */
+template<typename T>
+class mpmc_queue {
+public:
+	typedef size_t		size_type;
+	typedef T*		pointer;
+	typedef const T*	const_pointer;
+	typedef T&		reference;
+	typedef const T&	const_reference;
+	typedef T		value_type;
+private:
+	struct cell {
+		std::atomic<size_type> sequence;
+		value_type value;
+	};
+
+	std::unique_ptr<cell[]> buffer;
+	size_type const mask;
+
+	alignas(detail::cache_line_size) std::atomic<size_type> enqueue_pos;
+	alignas(detail::cache_line_size) std::atomic<size_type> dequeue_pos;
+
+	/*
+	 * Claims up to n consecutive slots starting at the shared position
+	 * pos. A slot is ready when its sequence equals its position plus
+	 * lag (0 for producers, 1 for consumers).
+	 */
+	size_type claim(std::atomic<size_type>& pos, size_type lag,
+			size_type n, size_type& first)
+	{
+		if (!n)
+			return 0;
+		cell* const ring = buffer.get();
+		size_type p = pos.load(std::memory_order_relaxed);
+		for (;;) {
+			size_type ready = 0;
+			while (ready != n) {
+				size_type const seq = ring[(p + ready) & mask]
+					.sequence.load(std::memory_order_acquire);
+				if (seq != p + ready + lag)
+					break;
+				++ready;
+			}
+			if (!ready) {
+				size_type const seq = ring[p & mask]
+					.sequence.load(std::memory_order_acquire);
+				// the slot is still in use by the previous lap
+				if (static_cast<ptrdiff_t>(seq - (p + lag)) < 0)
+					return 0;
+				p = pos.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (pos.compare_exchange_weak(p, p + ready,
+						      std::memory_order_relaxed)) {
+				first = p;
+				return ready;
+			}
+		}
+	}
+public:
+	/**
+	 *  @brief  Creates an empty queue.
+	 *  @param  capacity The minimal number of elements the queue holds,
+	 *  rounded up to a power of two; std::length_error is thrown when
+	 *  that power does not fit size_type.
+	 */
+	explicit mpmc_queue(size_type capacity) noexcept(false)
+		: buffer(new cell[detail::round_up_pow2(capacity)]),
+		  mask(detail::round_up_pow2(capacity) - 1),
+		  enqueue_pos(0), dequeue_pos(0)
+	{
+		if (!capacity)
+			throw std::invalid_argument("Capacity can't be 0.");
+		cell* const ring = buffer.get();
+		for (size_type i = 0; i != this->capacity(); ++i)
+			ring[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	mpmc_queue(mpmc_queue const&) = delete;
+	mpmc_queue& operator=(mpmc_queue const&) = delete;
+
+	size_type capacity() const noexcept { return mask + 1; }
+
+	/**
+	 * @brief Add a range of elements.
+	 * @param p:		pointer to the first element
+	 * @param p_size:	size of the range
+	 * @return		number of elements actually enqueued.
+	 */
+	size_type try_push(const_pointer p, size_type p_size)
+	{
+		size_type first = 0;
+		size_type const n = claim(enqueue_pos, 0, p_size, first);
+		cell* const ring = buffer.get();
+		for (size_type i = 0; i != n; ++i) {
+			cell& c = ring[(first + i) & mask];
+			c.value = p[i];
+			c.sequence.store(first + i + 1, std::memory_order_release);
+		}
+		return n;
+	}
+	bool try_push(const_reference element)
+	{
+		return try_push(&element, 1) == 1;
+	}
+
+	/**
+	 * @brief Take up to n elements.
+	 * @param p:	destination of at least n elements
+	 * @param n:	maximal number of elements to dequeue
+	 * @return	number of elements actually dequeued.
+	 */
+	size_type try_pop(pointer p, size_type n)
+	{
+		size_type first = 0;
+		n = claim(dequeue_pos, 1, n, first);
+		cell* const ring = buffer.get();
+		for (size_type i = 0; i != n; ++i) {
+			cell& c = ring[(first + i) & mask];
+			p[i] = c.value;
+			c.sequence.store(first + i + capacity(),
+					 std::memory_order_release);
+		}
+		return n;
+	}
+	bool try_pop(reference element)
+	{
+		return try_pop(&element, 1) == 1;
+	}
+};
+
+} // namespace lab
+
+#endif // CONCURRENT_QUEUE_H
@@ -0,0 +1,76 @@
+#ifndef DISTRIBUTE_H
+#define DISTRIBUTE_H
+
+#include <cstddef>
+
+#include "thread_pool.h"
+#include "vector.h"
+
+namespace lab {
+
+namespace detail {
+
+/**
+ * @brief Copies src[0], ..., src[n - 1] into dst grouped by bucket(x), in
+ * [0, buckets), keeping the order within each bucket.
+ *
+ * The array is cut into chunks of at least grain elements, at most one per
+ * thread, that are counted in parallel; each chunk then scatters its
+ * elements from its own offsets, so the scatter runs in parallel too and
+ * stays stable. If begin is not null, bucket b is left in
+ * [begin[b], begin[b + 1]) of dst. Returns false, with dst untouched, if
+ * all elements fall into one bucket.
+ */
+template<typename T, typename Bucket>
+bool distribute(const T* src, T* dst, size_t n, Bucket const& bucket,
+		size_t buckets, size_t grain, thread_pool& pool,
+		size_t* begin = nullptr)
+{
+	size_t chunks = (n + grain - 1) / grain;
+	if (chunks > pool.size() + 1)
+		chunks = pool.size() + 1;
+	vector<size_t> counts(chunks * buckets, size_t(0));
+	size_t* const c = counts.data();
+
+	pool.parallel_for(0, chunks, [&](size_t lo, size_t hi) {
+		for (size_t k = lo; k != hi; ++k) {
+			size_t* const count = c + k * buckets;
+			size_t const end = n * (k + 1) / chunks;
+			for (size_t i = n * k / chunks; i != end; ++i)
+				++count[bucket(src[i])];
+		}
+	});
+
+	// bucket by bucket, chunk by chunk: the counts become offsets
+	size_t total = 0;
+	for (size_t b = 0; b != buckets; ++b) {
+		size_t const bucket_start = total;
+		if (begin)
+			begin[b] = bucket_start;
+		for (size_t k = 0; k != chunks; ++k) {
+			size_t const count = c[k * buckets + b];
+			c[k * buckets + b] = total;
+			total += count;
+		}
+		if (total - bucket_start == n)
+			return false;
+	}
+	if (begin)
+		begin[buckets] = total;
+
+	pool.parallel_for(0, chunks, [&](size_t lo, size_t hi) {
+		for (size_t k = lo; k != hi; ++k) {
+			size_t* const offset = c + k * buckets;
+			size_t const end = n * (k + 1) / chunks;
+			for (size_t i = n * k / chunks; i != end; ++i)
+				dst[offset[bucket(src[i])]++] = src[i];
+		}
+	});
+	return true;
+}
+
+} // namespace detail
+
+} // namespace lab
+
+#endif // DISTRIBUTE_H
@@ -0,0 +1,155 @@
+#ifndef FLOATING_H
+#define FLOATING_H
+
+#include <limits>
+#include <type_traits>
+
+#include "overflow.h"
+
+namespace lab {
+
+namespace detail {
+
+// Number of significant bits of a non-negative integer; bigint and other
+// class types provide bit_width() themselves.
+template<typename UIntT>
+constexpr int bit_width(UIntT const& x) noexcept
+{
+	if constexpr (is_builtin_integer<UIntT>::value) {
+		int width = 0;
+		widest_uint value = static_cast<widest_uint>(x);
+		for (; value >> 32; value >>= 32)
+			width += 32;
+		return value ? width + 32
+			       - __builtin_clz(static_cast<unsigned int>(value))
+			     : width;
+	} else {
+		return static_cast<int>(x.bit_width());
+	}
+}
+
+// 2^e for e >= 0 in UIntT; class types by repeated squaring.
+template<typename UIntT>
+constexpr UIntT power_of_two(int e)
+{
+	if constexpr (is_builtin_integer<UIntT>::value) {
+		return static_cast<UIntT>(UIntT(1) << e);
+	} else {
+		UIntT result = 1, base = 2;
+		for (; e; e >>= 1) {
+			if (e & 1)
+				result *= base;
+			base *= base;
+		}
+		return result;
+	}
+}
+
+// x * 2^e, exact whenever the result is representable: every step
+// multiplies by a power of two no further from 1 than the final scale.
+template<typename F>
+constexpr F scale_by_power_of_two(F x, int e) noexcept
+{
+	while (e > 0) {
+		int const step = e < 60 ? e : 60;
+		x *= static_cast<F>(1ULL << step);
+		e -= step;
+	}
+	while (e < 0) {
+		int const step = -e < 60 ? -e : 60;
+		x /= static_cast<F>(1ULL << step);
+		e += step;
+	}
+	return x;
+}
+
+/**
+ * @brief n / d rounded to the nearest F, ties to even, for n, d > 0.
+ *
+ * Both operands are exact in F when they have at most digits bits and the
+ * quotient of the hardware is correctly rounded already. Otherwise the
+ * quotient is computed by long division, one bit of the significand at a
+ * time (fewer for subnormal results), and rounded by the next bit and the
+ * remainder. The remainder is doubled as r - (b - r), so no intermediate
+ * exceeds the operands. Built-in components of up to 64 bits take a single
+ * 128-bit division instead of the loop.
+ */
+template<typename F, typename UIntT>
+constexpr F round_quotient(UIntT n, UIntT d)
+{
+	typedef typename std::conditional<is_builtin_integer<UIntT>::value,
+					  widest_uint, UIntT>::type work_type;
+	int constexpr digits = std::numeric_limits<F>::digits;
+	static_assert(digits < std::numeric_limits<widest_uint>::digits,
+		      "The significand must fit into the widest integer.");
+
+	int const n_width = bit_width(n);
+	int const d_width = bit_width(d);
+	if (n_width <= digits && d_width <= digits) {
+		if constexpr (is_builtin_integer<UIntT>::value)
+			return static_cast<F>(n) / static_cast<F>(d);
+		else
+			return static_cast<F>(static_cast<long double>(n))
+			       / static_cast<F>(static_cast<long double>(d));
+	}
+
+	// align the leading bits: a / b == n / d * 2^-exp, in [1/2, 2)
+	int exp = n_width - d_width;
+	work_type a = n, b = d;
+	if (exp > 0)
+		b *= power_of_two<work_type>(exp);
+	else if (exp < 0)
+		a *= power_of_two<work_type>(-exp);
+	if (a < b) {
+		--exp;
+		a = a - (b - a);
+	} else {
+		a -= b;
+	}
+
+	// bits left to produce below the leading one
+	int bits = digits - 1;
+	int const min_exp = std::numeric_limits<F>::min_exponent - 1;
+	if (exp < min_exp)
+		bits -= min_exp - exp;
+
+	// below half the smallest subnormal, or at most a tie with zero
+	if (bits < 0)
+		return bits == -1 && a ? scale_by_power_of_two(F(1), exp + 1)
+				       : F(0);
+
+	widest_uint q = 1;
+	int i = 0;
+	if constexpr (is_builtin_integer<UIntT>::value) {
+		// all the bits from one division when a * 2^bits fits, as it
+		// does for components of up to 64 bits
+		if (bit_width(b) + bits
+		    <= std::numeric_limits<widest_uint>::digits) {
+			widest_uint const scaled = a << bits;
+			q = q << bits | scaled / b;
+			a = scaled % b;
+			i = bits;
+		}
+	}
+	for (; i != bits; ++i) {
+		if (a >= b - a) {
+			a = a - (b - a);
+			q = q << 1 | 1;
+		} else {
+			a += a;
+			q <<= 1;
+		}
+	}
+	// round to nearest, ties to even
+	bool const round = a >= b - a;
+	bool const sticky = round ? a != b - a : bool(a);
+	if (round && (sticky || (q & 1)))
+		++q;
+	return scale_by_power_of_two(static_cast<F>(q), exp - bits);
+}
+
+} // namespace detail
+
+} // namespace lab
+
+#endif // FLOATING_H
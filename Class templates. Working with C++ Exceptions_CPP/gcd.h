@@ -0,0 +1,94 @@
+#ifndef GCD_H
+#define GCD_H
+
+#include <type_traits>
+
+namespace lab {
+
+namespace detail {
+
+// std::make_unsigned, extended to __int128 in strict ISO modes.
+template<typename IntT>
+struct make_unsigned : std::make_unsigned<IntT> {};
+#ifdef __SIZEOF_INT128__
+template<>
+struct make_unsigned<__int128> { typedef unsigned __int128 type; };
+template<>
+struct make_unsigned<unsigned __int128> { typedef unsigned __int128 type; };
+#endif
+
+// Number of trailing zero bits of a non-zero unsigned value.
+template<typename UIntT>
+constexpr int ctz(UIntT x) noexcept
+{
+	if constexpr (sizeof(UIntT) <= sizeof(unsigned int))
+		return __builtin_ctz(static_cast<unsigned int>(x));
+	else if constexpr (sizeof(UIntT) <= sizeof(unsigned long))
+		return __builtin_ctzl(static_cast<unsigned long>(x));
+	else if constexpr (sizeof(UIntT) <= sizeof(unsigned long long))
+		return __builtin_ctzll(static_cast<unsigned long long>(x));
+	else {
+		unsigned long long const low = static_cast<unsigned long long>(x);
+		return low ? __builtin_ctzll(low)
+			   : 64 + ctz(static_cast<unsigned long long>(x >> 64));
+	}
+}
+
+// Stein's algorithm: only shifts and subtractions, no division.
+template<typename UIntT>
+constexpr UIntT binary_gcd(UIntT u, UIntT v) noexcept
+{
+	if (!u)
+		return v;
+	if (!v)
+		return u;
+	if constexpr (sizeof(UIntT) > sizeof(unsigned long long)) {
+		// wide operands are mostly small: the products and sums of
+		// narrower components
+		if (!((u | v) >> 64))
+			return binary_gcd(static_cast<unsigned long long>(u),
+					  static_cast<unsigned long long>(v));
+	}
+
+	int const shift = ctz(static_cast<UIntT>(u | v));
+	u >>= ctz(u);
+	do {
+		v >>= ctz(v);
+		// min and |v - u| without a branch: which operand is larger
+		// is as good as random
+		UIntT const diff = v - u;
+		u = u < v ? u : v;
+		v = diff > v ? static_cast<UIntT>(UIntT(0) - diff) : diff;
+	} while (v);
+	return static_cast<UIntT>(u << shift);
+}
+
+// |x| as an unsigned value, well defined for the most negative x too.
+template<typename UIntT, typename IntT>
+constexpr UIntT magnitude(IntT x) noexcept
+{
+	return x < 0 ? static_cast<UIntT>(UIntT(0) - static_cast<UIntT>(x))
+		     : static_cast<UIntT>(x);
+}
+
+} // namespace detail
+
+/**
+ * @brief Greatest common divisor of |a| and |b|; gcd(0, 0) == 0.
+ *
+ * Works on the unsigned counterpart of IntT, so the magnitude of the most
+ * negative value is handled too, as long as the result fits into IntT.
+ */
+template<typename IntT>
+constexpr IntT gcd(IntT a, IntT b) noexcept
+{
+	typedef typename detail::make_unsigned<IntT>::type unsigned_type;
+
+	return static_cast<IntT>(detail::binary_gcd(
+			detail::magnitude<unsigned_type>(a),
+			detail::magnitude<unsigned_type>(b)));
+}
+
+} // namespace lab
+
+#endif // GCD_H
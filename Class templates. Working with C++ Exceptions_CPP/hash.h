@@ -0,0 +1,84 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>           // std::hash
+
+#include "gcd.h"
+#include "overflow.h"
+
+namespace lab {
+
+namespace detail {
+
+// Seeds of wyhash: odd constants with balanced bits.
+constexpr std::uint64_t hash_seed0 = 0xa0761d6478bd642fULL;
+constexpr std::uint64_t hash_seed1 = 0xe7037ed1a0b428dbULL;
+constexpr std::uint64_t hash_seed2 = 0x8ebc6af09c88c6e3ULL;
+
+// The 128-bit product of a and b with its halves xored: every input bit
+// reaches every output bit in one multiplication.
+constexpr std::uint64_t hash_mix(std::uint64_t a, std::uint64_t b) noexcept
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 const p = static_cast<unsigned __int128>(a) * b;
+	return static_cast<std::uint64_t>(p)
+	       ^ static_cast<std::uint64_t>(p >> 64);
+#else
+	std::uint64_t const a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+	std::uint64_t const b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+	std::uint64_t const lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+	std::uint64_t const lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+	std::uint64_t const cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF)
+				    + lo_hi;
+	std::uint64_t const high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+	std::uint64_t const low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+	return low ^ high;
+#endif
+}
+
+// An integer as 64 bits of hash input; wider ones are folded.
+template<typename IntT>
+constexpr std::uint64_t hash_word(IntT x) noexcept
+{
+	if constexpr (sizeof(IntT) <= sizeof(std::uint64_t)) {
+		return static_cast<std::uint64_t>(x);
+	} else {
+		typedef typename make_unsigned<IntT>::type unsigned_type;
+		unsigned_type const u = static_cast<unsigned_type>(x);
+		std::uint64_t const low = static_cast<std::uint64_t>(u);
+		std::uint64_t const high = static_cast<std::uint64_t>(u >> 64);
+		return hash_mix(low ^ hash_seed0, high ^ hash_seed1);
+	}
+}
+
+/**
+ * @brief Hash of a pair of integers, e.g. the components of a reduced
+ * rational number.
+ *
+ * Built-in integers are mixed as in wyhash: two multiply-folds, the second
+ * one so that pairs differing in one component only still differ in all
+ * bits. Other types go through std::hash.
+ */
+template<typename IntT>
+constexpr std::uint64_t hash_pair(IntT const& a, IntT const& b) noexcept(
+	is_builtin_integer<IntT>::value)
+{
+	if constexpr (is_builtin_integer<IntT>::value) {
+		std::uint64_t const h = hash_mix(hash_word(a) ^ hash_seed0,
+						 hash_word(b) ^ hash_seed1);
+		return hash_mix(h ^ hash_seed2, hash_seed1);
+	} else {
+		std::hash<IntT> const hash;
+		std::uint64_t const ha = static_cast<std::uint64_t>(hash(a));
+		std::uint64_t const hb = static_cast<std::uint64_t>(hash(b));
+		return hash_mix(ha ^ hash_seed0, hb ^ hash_seed1);
+	}
+}
+
+} // namespace detail
+
+} // namespace lab
+
+#endif // HASH_H
@@ -11,12 +11,73 @@
   * Design a class template for a dynamic one-dimensional array.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "vector.h"
 #include "rational.h"
+#include "ring_buffer.h"
+#include "concurrent_queue.h"
+#include "rational_soa_vector.h"
+#include "rational_batch.h"
+#include "gcd.h"
+#include "bigint.h"
+#include "rational_expr.h"
+#include "rational_charconv.h"
+#include "rational_map.h"
+#include "packed_rational.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include "rational_numeric.h"
+#include "polynomial.h"
+#include "rational_filter.h"
+#include "radix_sort.h"
+#include "parallel_sort.h"
 using std::cout;
 
+int failures = 0;
+
+/**
+ * @brief check: Print the outcome of one behavior check and count the
+ * failed ones; main() returns non-zero if any check failed.
+ */
+void check(bool ok, const char* what)
+{
+	cout << (ok ? "	ok: " : "	FAILED: ") << what << "\n";
+	if (!ok)
+		++failures;
+}
+
+/**
+ * @brief check_throws: Check that f() throws an exception of type E.
+ */
+template<typename E, typename F>
+void check_throws(F f, const char* what)
+{
+	bool thrown = false;
+	try {
+		f();
+	} catch (E const&) {
+		thrown = true;
+	} catch (...) {
+	}
+	check(thrown, what);
+}
+
 void test_vector()
 {
 	int a[] = {9,8,7,6,5,4,3,2,1};
@@ -163,8 +224,1915 @@ void test_rational()
 
 }
 
+void test_ring_buffer()
+{
+	cout << "ring_buffer:\n";
+
+	lab::ring_buffer<int> r(5);
+	check(r.capacity() == 8 && r.empty(), "capacity rounded up to 8");
+	for (int i = 0; i < 10; i++)
+		r.push_back(i);
+	check(r.full() && r.front() == 2 && r.back() == 9,
+	      "push_back to a full buffer drops the oldest");
+
+	lab::ring_buffer<int>::array_range one = r.array_one();
+	lab::ring_buffer<int>::array_range two = r.array_two();
+	check(one.second == 6 && two.second == 2 && one.first[0] == 2
+	      && two.first[1] == 9, "two spans cover the wrapped contents");
+
+	r.pop_front(3);
+	r.pop_back();
+	check(r.size() == 4 && r[0] == 5 && r[3] == 8, "pop_front, pop_back");
+	r.pop_front(100);
+	check(r.empty() && r.array_one().second == 0
+	      && r.array_two().second == 0, "pop_front past the end empties");
+
+	int a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+	r.push_back(a, 11);
+	check(r.size() == 8 && r.front() == 4 && r.back() == 11,
+	      "bulk push keeps the last capacity() elements");
+
+	lab::ring_buffer<int> copy(r);
+	check(copy.size() == 8 && copy[7] == 11, "copy constructor");
+	lab::ring_buffer<int> moved(std::move(copy));
+	check(moved.size() == 8 && copy.capacity() == 0, "move constructor");
+
+	check_throws<std::out_of_range>([&] { return r[8]; },
+					"out of range subscript throws");
+	check_throws<std::invalid_argument>([] { lab::ring_buffer<int> z(0); },
+					    "zero capacity throws");
+	check_throws<std::length_error>([] {
+		lab::ring_buffer<int> z(std::numeric_limits<size_t>::max());
+	}, "capacity above the top bit throws");
+}
+
+template<typename Queue>
+void check_queue(const char* name, size_t pairs)
+{
+	cout << name << ":\n";
+
+	Queue q(5);
+	check(q.capacity() == 8, "capacity rounded up to 8");
+	int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	int out[10] = {};
+	check(q.try_push(in, 10) == 8, "batch push stops when full");
+	check(!q.try_push(in[0]), "push to a full queue fails");
+	check(q.try_pop(out, 3) == 3 && out[0] == 0 && out[2] == 2,
+	      "batch pop in order");
+	check(q.try_push(in + 8, 2) == 2, "push after pop wraps around");
+	check(q.try_pop(out, 10) == 7 && out[4] == 7 && out[6] == 9,
+	      "pop takes what is there");
+	int x = -1;
+	check(!q.try_pop(x) && x == -1, "pop from an empty queue fails");
+	check(q.try_push(in, 0) == 0 && q.try_pop(out, 0) == 0,
+	      "zero-length push and pop on an empty queue");
+	q.try_push(in, 2);
+	check(q.try_push(in, 0) == 0 && q.try_pop(out, 0) == 0
+	      && q.try_pop(out, 10) == 2,
+	      "zero-length push and pop on a queue with elements");
+	check_throws<std::invalid_argument>([] { Queue z(0); },
+					    "zero capacity throws");
+	check_throws<std::length_error>([] {
+		Queue z(std::numeric_limits<size_t>::max() / 2 + 2);
+	}, "capacity above the top bit throws");
+
+	// producers and consumers on threads: every element arrives once
+	int const count = 30000;
+	Queue shared(64);
+	std::vector<long long> sums(pairs, 0);
+	std::vector<std::thread> threads;
+	for (size_t p = 0; p < pairs; p++)
+		threads.emplace_back([&shared] {
+			for (int i = 1; i <= count;)
+				if (shared.try_push(i))
+					i++;
+		});
+	for (size_t c = 0; c < pairs; c++)
+		threads.emplace_back([&shared, &sums, c] {
+			int buf[16];
+			for (int got = 0; got < count;) {
+				size_t const k = shared.try_pop(buf, 16 <
+					count - got ? 16 : count - got);
+				for (size_t i = 0; i < k; i++)
+					sums[c] += buf[i];
+				got += static_cast<int>(k);
+			}
+		});
+	for (std::thread& t : threads)
+		t.join();
+	long long total = 0;
+	for (long long sum : sums)
+		total += sum;
+	check(total == static_cast<long long>(pairs) * count * (count + 1) / 2,
+	      "threads: every element popped exactly once");
+}
+
+void test_concurrent_queue()
+{
+	check_queue<lab::spsc_queue<int> >("spsc_queue", 1);
+	check_queue<lab::mpmc_queue<int> >("mpmc_queue", 3);
+}
+
+template<typename IntT>
+bool aligned_columns(lab::rational_soa_vector<IntT> const& v)
+{
+	return !(reinterpret_cast<uintptr_t>(v.num_data()) % 64)
+	       && !(reinterpret_cast<uintptr_t>(v.denom_data()) % 64);
+}
+
+void test_rational_soa_vector()
+{
+	cout << "rational_soa_vector:\n";
+	typedef lab::rational_t<int> rational;
+
+	lab::rational_soa_vector<int> v;
+	for (int i = 1; i <= 100; i++)
+		v.push_back(rational(i, 2 * i + 2));
+	check(v.size() == 100 && v[0] == rational(1, 4)
+	      && v.num_data()[1] == 1 && v.denom_data()[1] == 3,
+	      "push_back stores reduced components in two columns");
+	check(aligned_columns(v), "columns are cache-line aligned");
+
+	v[5] = rational(-3, 9);
+	v[6] = v[5];
+	check(v.num_data()[6] == -1 && v.denom_data()[6] == 3,
+	      "proxy assignment writes both columns");
+	v.pop_back();
+	check(v.size() == 99, "pop_back");
+
+	lab::rational_soa_vector<long long> z(3);
+	check(z.size() == 3 && z[2] == lab::rational_t<long long>(0, 1)
+	      && aligned_columns(z), "n zeros, long long components");
+
+	lab::vector<rational> aos{rational(1, 2), rational(2, 3)};
+	lab::rational_soa_vector<int> from(aos);
+	check(from.size() == 2 && from[1] == rational(2, 3),
+	      "split from an array of structures");
+
+	lab::rational_soa_vector<int> const& cv = from;
+	check_throws<std::out_of_range>([&] { return cv[2]; },
+					"const subscript out of range throws");
+	check_throws<std::out_of_range>([&] { from[2] = rational(1, 1); },
+					"subscript out of range throws");
+	check_throws<std::bad_array_new_length>([] {
+		lab::aligned_allocator<long long> a;
+		return a.allocate(std::numeric_limits<size_t>::max() / 4);
+	}, "an allocation whose size wraps throws");
+}
+
+void test_rational_batch()
+{
+	cout << "rational_batch:\n";
+	typedef lab::rational_t<int> rational;
+
+	// enough elements for the AVX2 and AVX-512 blocks and a scalar tail
+	lab::rational_soa_vector<int> a, b, out;
+	unsigned x = 12345;
+	for (int i = 0; i < 1000; i++) {
+		x = x * 1103515245u + 12345u;
+		int const n = static_cast<int>(x >> 8) % 60001 - 30000;
+		int const d = static_cast<int>(x >> 4) % 30000 + 1;
+		a.push_back(rational(n, d));
+		b.push_back(rational(d - 15000, n ? n : 1));
+	}
+
+	const lab::batch::operation ops[] = {lab::batch::op_add,
+		lab::batch::op_sub, lab::batch::op_mul, lab::batch::op_div};
+	const char* const names[] = {"add matches operator+",
+		"sub matches operator-", "mul matches operator*",
+		"div matches operator/"};
+	for (int k = 0; k < 4; k++) {
+		lab::batch::apply(ops[k], a, b, out);
+		bool same = out.size() == a.size();
+		for (size_t i = 0; same && i < a.size(); i++) {
+			rational const p = a[i], q = b[i];
+			rational const r = k == 0 ? p + q : k == 1 ? p - q
+					 : k == 2 ? p * q : p / q;
+			same = out[i] == r;
+		}
+		check(same, names[k]);
+	}
+
+	// 17 elements: 16 in vector lanes, one in the scalar tail
+	lab::rational_soa_vector<int> small, big;
+	for (int i = 0; i < 17; i++) {
+		small.push_back(rational(1, 65536));
+		big.push_back(rational(50000, 1));
+	}
+	lab::batch::add(small, small, out);
+	bool same = true;
+	for (size_t i = 0; i < out.size(); i++)
+		same = same && out[i] == rational(1, 32768);
+	check(same, "lanes whose denominator product overflows int are "
+	      "reduced like the scalar tail");
+	check_throws<std::overflow_error>([&] {
+		lab::batch::mul(big, big, out);
+	}, "overflow in a vector lane throws");
+
+	lab::rational_soa_vector<int> zero(1000);
+	check_throws<std::invalid_argument>([&] {
+		lab::batch::div(a, zero, out);
+	}, "division by a zero element throws");
+	check_throws<std::invalid_argument>([&] {
+		lab::batch::add(a, small, out);
+	}, "operands of different sizes throw");
+}
+
+template<typename IntT>
+bool gcd_matches_euclid(int count)
+{
+	unsigned long long x = 88172645463325252ull;
+	for (int i = 0; i < count; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		// small factors in common, so the gcds are not all 1
+		IntT const k = static_cast<IntT>(x % 7 + 1);
+		IntT const a = static_cast<IntT>(x >> 8) / 8 * k;
+		IntT const b = static_cast<IntT>(x >> 24) / 8 * k;
+		if (lab::gcd(a, b) != std::gcd(a, b))
+			return false;
+	}
+	return true;
+}
+
+void test_gcd()
+{
+	cout << "gcd:\n";
+
+	static_assert(lab::gcd(12, 18) == 6, "gcd is constexpr");
+	check(lab::gcd(0, 0) == 0 && lab::gcd(0, 7) == 7 && lab::gcd(7, 0) == 7,
+	      "zero operands");
+	check(lab::gcd(-12, 18) == 6 && lab::gcd(12, -18) == 6,
+	      "signs are ignored");
+	check(lab::gcd(INT_MIN, 6) == 2 && lab::gcd(INT_MIN, INT_MIN / 2)
+	      == INT_MIN / -2, "the most negative value");
+	check(lab::gcd<signed char>(-128, 96) == 32, "signed char");
+	check(gcd_matches_euclid<int>(10000)
+	      && gcd_matches_euclid<long long>(10000)
+	      && gcd_matches_euclid<unsigned>(10000), "agrees with std::gcd");
+#ifdef __SIZEOF_INT128__
+	__int128 const big = static_cast<__int128>(1) << 100;
+	check(lab::gcd(big * 3, big / 4 * 9) == big / 4 * 3, "__int128");
+#endif
+	check(lab::rational_t<long long>(6LL << 40, 9LL << 41)
+	      == lab::rational_t<long long>(1, 3), "rational_t reduces by gcd");
+}
+
+void test_rational_overflow()
+{
+	cout << "rational overflow:\n";
+	typedef lab::rational_t<long long> rational_ll;
+	typedef lab::rational_t<int, lab::overflow_saturate> saturating;
+	typedef lab::rational_t<int, lab::overflow_wrap> wrapping;
+
+	long long const big = LLONG_MAX / 3;
+	check(rational_ll(big, 7) * rational_ll(7, big) == rational_ll(1, 1),
+	      "long long products are exact in __int128");
+	check(rational_ll(big, big - 1) + rational_ll(-1, big - 1)
+	      == rational_ll(1, 1), "long long sums are exact in __int128");
+	check(lab::rational_t<signed char>(100, 1)
+	      + lab::rational_t<signed char>(-50, 1)
+	      == lab::rational_t<signed char>(50, 1),
+	      "signed char sums go through int16");
+
+	check_throws<std::overflow_error>([] {
+		return lab::rational_t<int>(INT_MAX, 1)
+		       + lab::rational_t<int>(1, 1);
+	}, "an int sum out of range throws");
+	check_throws<std::overflow_error>([] {
+		return lab::rational_t<int>(65536, 1)
+		       * lab::rational_t<int>(65536, 1);
+	}, "an int product out of range throws");
+	check(saturating(INT_MAX, 1) + saturating(1, 1)
+	      == saturating(INT_MAX, 1), "overflow_saturate clamps");
+	check(wrapping(INT_MAX, 1) + wrapping(1, 1) == wrapping(INT_MIN, 1),
+	      "overflow_wrap keeps the low bits");
+
+	// the sign moves to the numerator; the most negative value has no
+	// negation
+	check(lab::rational_t<int>(2, INT_MIN)
+	      == lab::rational_t<int>(-1, 1 << 30),
+	      "a reducible most negative denominator");
+	check(lab::rational_t<int>(INT_MIN, -2)
+	      == lab::rational_t<int>(1 << 30, 1),
+	      "a reducible most negative numerator");
+	check_throws<std::overflow_error>([] {
+		return lab::rational_t<signed char>(1, -128);
+	}, "1 / -128 as signed char throws");
+	check_throws<std::overflow_error>([] {
+		return lab::rational_t<int>(1, INT_MIN);
+	}, "1 / INT_MIN throws");
+	check_throws<std::overflow_error>([] {
+		return lab::rational_t<int>(INT_MIN, -1);
+	}, "INT_MIN / -1 throws");
+	check(saturating(INT_MIN, -1) == saturating(INT_MAX, 1),
+	      "INT_MIN / -1 saturates");
+	check(wrapping(INT_MIN, -1) == wrapping(INT_MIN, 1),
+	      "INT_MIN / -1 wraps");
+	check_throws<std::overflow_error>([] {
+		return -lab::rational_t<int>(INT_MIN, 1);
+	}, "negating INT_MIN throws");
+}
+
+void test_bigint()
+{
+	cout << "bigint:\n";
+	typedef lab::rational_t<lab::bigint> rational_big;
+
+	lab::bigint const two64 = lab::bigint(UINT64_MAX) + 1;
+	check(to_string(two64) == "18446744073709551616",
+	      "a carry out of the inline 64 bits");
+	check(two64 - 1 == lab::bigint(UINT64_MAX) && two64.bit_width() == 65,
+	      "a borrow back into them");
+	check(lab::bigint(LLONG_MIN) / -1 == lab::bigint(LLONG_MAX) + 1,
+	      "LLONG_MIN / -1 does not overflow");
+	check(lab::bigint(-7) / 2 == -3 && lab::bigint(-7) % 2 == -1,
+	      "division truncates toward zero");
+	check_throws<std::invalid_argument>([] {
+		return lab::bigint(1) / lab::bigint();
+	}, "division by zero throws");
+
+	// (2^k - 1)^2 == 2^2k - 2^(k+1) + 1, with k large enough for Karatsuba
+	lab::bigint p = 1;
+	for (int i = 0; i < 4096; i++)
+		p *= 2;
+	lab::bigint const m = p - 1;
+	check(m * m == p * p - 2 * p + 1, "a 4096-bit square");
+	check((m * m) / m == m && (m * m + 5) % m == 5,
+	      "long division undoes it");
+	check(gcd(m * 6, m * 9) == m * 3, "gcd of long operands");
+
+	// 1 + 1/2 + ... + 1/30 overflows long long; bigint is exact
+	rational_big h;
+	for (int k = 1; k <= 30; k++)
+		h += rational_big(1, k);
+	check(to_string(h.num()) == "9304682830147"
+	      && to_string(h.denom()) == "2329089562800", "H(30)");
+	rational_big e;
+	for (int k = 30; k >= 1; k--)
+		e += rational_big(1, k);
+	check(h == e && h - e == rational_big(), "the order of summation");
+
+	check(!std::numeric_limits<lab::bigint>::is_bounded,
+	      "bigint is unbounded");
+	// copies allocate and may throw; moves take the limbs
+	check(std::is_nothrow_move_constructible<rational_big>::value
+	      && std::is_nothrow_move_assignable<rational_big>::value
+	      && !std::is_nothrow_copy_assignable<rational_big>::value
+	      && std::is_trivially_copy_assignable<lab::rational_t<int> >::value,
+	      "rational_t<bigint> moves without copying");
+	check(rational_big::from_double(0.1)
+	      == rational_big(3602879701896397LL, 36028797018963968LL),
+	      "from_double is exact");
+	double const x[] = {0.1, -2.5, 1e30};
+	std::vector<lab::bigint> num(3), denom(3);
+	lab::batch::from_double(x, num.data(), denom.data(), 3);
+	check(num[1] == -5 && denom[1] == 2 && denom[2] == 1
+	      && static_cast<double>(num[2]) == 1e30,
+	      "batch::from_double without a bound");
+}
+
+void test_lazy_normalization()
+{
+	cout << "lazy normalization:\n";
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+
+	lazy const half(2, 4);
+	check(half.num() == 2 && half.denom() == 4, "components are kept");
+	check(lazy(3, -6).num() == -3 && lazy(3, -6).denom() == 6,
+	      "the sign still moves to the numerator");
+	lazy const q = half * lazy(2, 3);
+	check(q.num() == 4 && q.denom() == 12, "products are not reduced");
+	check(q.normalized().num() == 1 && q.normalized().denom() == 3,
+	      "normalized() reduces");
+	check(q == lazy(1, 3) && q != lazy(1, 4) && q < half && half == 0.5,
+	      "comparisons see the value");
+	check(lab::rational_t<int>(q) == lab::rational_t<int>(1, 3),
+	      "conversion to eager reduces");
+	check(lazy(6, 4) == 1.5 && lazy(6, 3) == 2 && lazy(6, 3) != 3,
+	      "integer and floating operands");
+
+	// 1/2 + 1/4 + ... + 1/2^20 with terms stored as 2^i / 4^i: they
+	// outgrow int after 15 steps
+	lazy s, term(1, 1);
+	for (int i = 0; i < 20; i++) {
+		term *= lazy(2, 4);
+		s += term;
+	}
+	check(s == lazy((1 << 20) - 1, 1 << 20) && term == lazy(1, 1 << 20),
+	      "chains reduce only when they would overflow");
+	check_throws<std::overflow_error>([] {
+		return lazy(65536, 1) * lazy(65536, 1);
+	}, "an overflow after reduction still throws");
+
+#ifdef __SIZEOF_INT128__
+	// no wider type: the integer and ratio paths retry the reduced form
+	typedef lab::rational_t<__int128, lab::overflow_throw,
+				lab::lazy_normalization> lazy_128;
+	__int128 const big = static_cast<__int128>(1) << 100;
+	lazy_128 const one(big, big);
+	check(one + (1LL << 40) == lazy_128((1LL << 40) + 1, 1),
+	      "r + k reduces an unreduced r on overflow");
+	check(one * std::ratio<(1LL << 40), 3>()
+	      == lazy_128(1LL << 40, 3), "r * ratio reduces on overflow");
+#endif
+}
+
+template<typename IntT>
+bool fused_matches_operators(int count, int bits)
+{
+	typedef lab::rational_t<IntT> rational;
+	unsigned long long x = 88172645463325252ull;
+	int compared = 0;
+	auto next = [&x, bits] {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return static_cast<IntT>(static_cast<long long>(x >> 20)
+					 % (1LL << bits));
+	};
+	for (int i = 0; i < count; i++) {
+		IntT const n[4] = {next(), next(), next(), next()};
+		IntT const d[4] = {next(), next(), next(), next()};
+		rational r[4];
+		for (int k = 0; k < 4; k++)
+			r[k] = rational(n[k], d[k] ? d[k] : IntT(1));
+		if (!r[3].num())
+			r[3] = rational(1, 1);
+		// where the operators overflow in between, fused evaluation
+		// may still succeed
+		rational expected;
+		try {
+			expected = r[0] * r[1] + r[2] / r[3] - r[0];
+		} catch (std::overflow_error const&) {
+			continue;
+		}
+		rational const actual = fused(r[0]) * r[1]
+					+ fused(r[2]) / r[3] - r[0];
+		if (actual != expected)
+			return false;
+		++compared;
+	}
+	return compared > count / 2;
+}
+
+void test_rational_expr()
+{
+	cout << "rational_expr:\n";
+	typedef lab::rational_t<int> rational;
+	typedef lab::rational_t<long long> rational_ll;
+
+	rational const a(1, 2), b(-2, 3), c(5, 7), d(-3, 4);
+	rational const r = fused(a) * b + fused(c) / d - a;
+	check(r == a * b + c / d - a, "a * b + c / d - a");
+	check(fused_matches_operators<int>(10000, 7)
+	      && fused_matches_operators<long long>(10000, 15),
+	      "agrees with the operators");
+
+	// three long long factors need 189 bits: the outer node falls back
+	// to the operators on a fused product
+	rational_ll const big(LLONG_MAX / 5, 3);
+	typedef decltype(fused(big) * big * big) product3;
+	check(!product3::fusable
+	      && decltype(fused(big) * big)::fusable,
+	      "bit bounds decide what is fused");
+	check(rational_ll(fused(big) * rational_ll(3, LLONG_MAX / 5)
+			  * rational_ll(2, 1)) == rational_ll(2, 1),
+	      "a fallback node on a fused operand");
+
+	// intermediate results that do not fit into int
+	rational const m(1 << 20, 3);
+	check(rational(fused(m) * m / m) == m,
+	      "fused products do not overflow in between");
+	check_throws<std::overflow_error>([&] {
+		return rational(fused(m) * m);
+	}, "a result out of range throws");
+	check_throws<std::invalid_argument>([&] {
+		return rational(fused(a) / (fused(a) - a));
+	}, "division by a zero subexpression throws");
+
+	// operands are copied into the expression
+	rational x(1, 3);
+	auto const e = fused(x) + x;
+	x = rational(1, 1);
+	check(rational(e) == rational(2, 3), "expressions hold copies");
+
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	lazy const l = fused(lazy(1, 2)) + lazy(1, 2);
+	check(l == 1 && l.denom() == 2, "lazy results are not reduced");
+}
+
+void test_rational_compare()
+{
+	cout << "rational comparison:\n";
+	typedef lab::rational_t<int> rational;
+
+	check(rational(1, 3) < rational(1, 2)
+	      && rational(-1, 2) < rational(-1, 3)
+	      && rational(-1, 2) < rational(0, 1)
+	      && rational(2, 1) > rational(3, 2),
+	      "signs, integers and fractions");
+	// a / (a - 1) falls as a grows
+	check(rational(INT_MAX, INT_MAX - 1) < rational(INT_MAX - 1, INT_MAX - 2)
+	      && rational(-INT_MAX, INT_MAX - 1)
+		 > rational(1 - INT_MAX, INT_MAX - 2),
+	      "products beyond int are exact");
+#ifdef __cpp_impl_three_way_comparison
+	check((rational(1, 3) <=> rational(2, 6)) == 0
+	      && (rational(1, 3) <=> rational(1, 2)) < 0,
+	      "operator<=>");
+#endif
+
+#ifdef __SIZEOF_INT128__
+	// no wider type than unsigned long long: the continued fraction
+	// expansions against the exact products in __int128
+	typedef unsigned __int128 uint128;
+	unsigned long long x = 88172645463325252ull;
+	bool same = true;
+	for (int i = 0; same && i < 100000; i++) {
+		unsigned long long v[4];
+		for (unsigned long long& y : v) {
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			y = (x >> (i % 40)) | 1;
+		}
+		if (i % 3 == 0) {	// equal values
+			v[2] = v[0] * 3;
+			v[3] = v[1] * 3;
+		}
+		uint128 const l = static_cast<uint128>(v[0]) * v[3];
+		uint128 const r = static_cast<uint128>(v[2]) * v[1];
+		same = lab::detail::compare_fractions(v[0], v[1], v[2], v[3])
+		       == (l > r) - (l < r);
+	}
+	check(same, "compare_fractions matches the exact products");
+
+	typedef lab::rational_t<__int128> rational_128;
+	__int128 const big = static_cast<__int128>(~uint128(0) >> 1);
+	check(rational_128(big, big - 1) < rational_128(big - 1, big - 2)
+	      && rational_128(-big, big - 1) > rational_128(1 - big, big - 2)
+	      && !(rational_128(big - 1, big) < rational_128(big - 1, big)),
+	      "__int128 compares without a wider type");
+#endif
+}
+
+void test_rational_constexpr()
+{
+	cout << "constexpr rational:\n";
+	using namespace lab::literals;
+	typedef lab::rational_t<int> rational;
+
+	// these fail to compile rather than fail a check
+	constexpr rational a = 0.25_r, b = 3_r / 4;
+	static_assert(a + b == 1 && a * b == rational(3, 16)
+		      && -a < a && a - b == -0.5_r, "constexpr operators");
+	static_assert(1'000.5_r == rational(2001, 2)
+		      && 2147483647_r == INT_MAX, "literals");
+	static_assert(rational(6, -4).num() == -3
+		      && rational(6, -4).denom() == 2,
+		      "constexpr reduction and sign");
+	static_assert(static_cast<double>(a) == 0.25, "constexpr conversion");
+	constexpr rational c = [] {
+		rational x(1, 2);
+		x += rational(1, 3);
+		++x;
+		x *= 2_r;
+		return x;
+	}();
+	static_assert(c == rational(11, 3), "constexpr compound assignment");
+	typedef lab::rational_t<long long, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	static_assert(lazy(2, 4) * lazy(2, 4) == lazy(1, 4)
+		      && lab::rational_t<long long>(lazy(2, 4)).denom() == 2,
+		      "constexpr lazy normalization");
+
+	constexpr rational table[] = {3_r / 4, 1_r / 3, 0.125_r};
+	static_assert(table[0] + table[1] + table[2] == rational(29, 24),
+		      "a table of constants");
+	volatile int one = 1;
+	check(rational(3 * one, 4) + rational(one, 3) + rational(one, 8)
+	      == table[0] + table[1] + table[2],
+	      "compile-time and run-time results agree");
+}
+
+void test_rational_ratio()
+{
+	cout << "std::ratio:\n";
+	typedef lab::rational_t<int> rational;
+
+	rational const r(3, 10);
+	check(r * std::milli() == rational(3, 10000)
+	      && std::kilo() * r == rational(300, 1),
+	      "products with a ratio");
+	check(r / std::ratio<-3, 5>() == rational(-1, 2)
+	      && r / std::ratio<3, 10>() == 1, "quotients, negative ratios");
+	check(std::ratio<2, 4>() * r == rational(3, 20)
+	      && rational(std::ratio<6, -4>()) == rational(-3, 2),
+	      "ratios are reduced");
+	check(r + std::milli() == rational(301, 1000)
+	      && r == std::ratio<3, 10>() && r < std::ratio<1, 2>(),
+	      "other operations convert the ratio");
+
+	rational t(1500, 1);
+	t *= std::chrono::milliseconds::period();
+	check(t == rational(3, 2), "scaling by a duration period");
+	check_throws<std::overflow_error>([] {
+		return rational(1 << 20, 1) * std::kilo() * std::kilo();
+	}, "an overflowing product throws");
+
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	lazy const l = lazy(5, 1) * std::ratio<2, 5>();
+	check(l.num() == 10 && l.denom() == 5 && l == 2,
+	      "lazy products are not reduced");
+}
+
+void test_rational_integer()
+{
+	cout << "integer operands:\n";
+	typedef lab::rational_t<int> rational;
+	typedef lab::rational_t<signed char> rational_sc;
+
+	rational const r(7, 2);
+	check(r + 1 == rational(9, 2) && 1 - r == rational(-5, 2)
+	      && r * 4 == 14 && r / -7 == rational(-1, 2)
+	      && 3 / rational(-6, 5) == rational(-5, 2),
+	      "arithmetic on either side");
+	rational t(1, 3);
+	++t;
+	t++;
+	--t;
+	t += 2;
+	t *= 3;
+	t /= 2;
+	check(t == rational(5, 1), "increments and compound assignment");
+	check(rational(1, 3) * INT_MIN == rational(INT_MIN, 3)
+	      && rational(1, 2) * 0 == 0 && 0 / rational(1, 2) == 0,
+	      "extreme and zero operands");
+
+	// operands beyond the range of IntT
+	check(rational_sc(-100, 1) + 200 == 100
+	      && rational_sc(1, 2) * 200LL / 150 == rational_sc(2, 3),
+	      "signed char results of operands beyond signed char");
+	check(rational(1, 2) * 4000000000LL == 2000000000
+	      && rational(4, 1) / 4000000000LL == rational(1, 1000000000),
+	      "int results of long long operands");
+	check_throws<std::overflow_error>([] {
+		return rational(7, 2) - 4000000000LL;
+	}, "a result beyond int throws");
+	check_throws<std::overflow_error>([] {
+		return INT_MIN / rational(-1, 1);
+	}, "INT_MIN / -1 throws");
+	check_throws<std::invalid_argument>([] {
+		return rational(1, 2) / 0;
+	}, "division by zero throws");
+
+	check(rational(INT_MAX, 1) == INT_MAX && rational(1, 1) != 4294967297ULL
+	      && rational(1, 2) < 1u && rational(-1, 2) < 0ULL
+	      && ULLONG_MAX > rational(INT_MAX, 1) && rational(5, 1) >= 5
+	      && rational(9, 2) > 4 && 5 > rational(9, 2),
+	      "comparisons with any signedness and width");
+}
+
+/**
+ * @brief nearest: Check that f is x rounded to the nearest F, ties to even,
+ * by exact comparison with both neighbours of f.
+ */
+template<typename F>
+bool nearest(lab::rational_t<lab::bigint> const& x, F f)
+{
+	typedef lab::rational_t<lab::bigint> rational_big;
+
+	if (!std::isfinite(f))
+		return false;
+	auto const distance = [&x](F g) {
+		rational_big const d = x - rational_big::from_double(g);
+		return d < 0 ? -d : d;
+	};
+	int exp = 0;
+	std::frexp(f, &exp);
+	F const ulp = std::max(std::ldexp(F(1), exp - std::numeric_limits<F>::digits),
+			       std::numeric_limits<F>::denorm_min());
+	bool const even = std::fmod(f / ulp, F(2)) == 0;
+
+	rational_big const here = distance(f);
+	for (F const to : {std::numeric_limits<F>::infinity(),
+			   -std::numeric_limits<F>::infinity()}) {
+		F const g = std::nextafter(f, to);
+		if (!std::isfinite(g))
+			continue;
+		rational_big const there = distance(g);
+		if (there < here || (there == here && !even))
+			return false;
+	}
+	return true;
+}
+
+template<typename F>
+bool converts_to_nearest(int count)
+{
+	typedef lab::rational_t<long long> rational_ll;
+	typedef lab::rational_t<lab::bigint> rational_big;
+
+	unsigned long long x = 88172645463325252ull;
+	for (int i = 0; i < count; i++) {
+		long long c[2];
+		for (long long& y : c) {
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			// widths from 1 to 63 bits
+			y = static_cast<long long>(x >> (1 + i % 63));
+		}
+		rational_ll const r(i % 2 ? -c[0] : c[0], c[1] ? c[1] : 1);
+		if (!r.num())
+			continue;
+		if (!nearest(rational_big(r), r.template to_floating<F>()))
+			return false;
+	}
+	return true;
+}
+
+void test_rational_floating()
+{
+	cout << "rational to floating:\n";
+	typedef lab::rational_t<long long> rational_ll;
+	typedef lab::rational_t<lab::bigint> rational_big;
+
+	check(converts_to_nearest<double>(20000)
+	      && converts_to_nearest<float>(20000),
+	      "long long components round to the nearest double and float");
+	check(static_cast<double>(rational_ll((1LL << 53) + 1, 1))
+	      == 9007199254740992.0
+	      && static_cast<double>(rational_ll((1LL << 53) + 3, 1))
+	      == 9007199254740996.0, "ties go to even");
+	check(static_cast<double>(rational_ll(1, 3)) == 1.0 / 3
+	      && static_cast<float>(rational_ll(-2, 3)) == -2.0f / 3,
+	      "exact components take one division");
+	check(static_cast<long double>(rational_ll(LLONG_MAX, 3))
+	      == static_cast<long double>(LLONG_MAX) / 3,
+	      "long double holds 64-bit components");
+#ifdef __SIZEOF_INT128__
+	// too wide for the single 128-bit division
+	typedef lab::rational_t<__int128> rational_128;
+	__int128 const big = static_cast<__int128>(~0ULL) << 62 | 12345;
+	rational_128 const wide[] = {rational_128(big, 3),
+		rational_128(-big / 7, big / 5 + 2), rational_128(3, big)};
+	bool all = true;
+	for (rational_128 const& r : wide)
+		all = all && nearest(rational_big(r), static_cast<double>(r))
+		      && nearest(rational_big(r), static_cast<float>(r));
+	check(all, "__int128 components");
+#endif
+
+	// 2^-1074 is the smallest subnormal double
+	rational_big tiny(1, 1);
+	for (int i = 0; i < 1074; i++)
+		tiny /= 2;
+	check(static_cast<double>(tiny) == std::numeric_limits<double>::denorm_min()
+	      && static_cast<double>(tiny * rational_big(3, 4))
+		 == std::numeric_limits<double>::denorm_min()
+	      && static_cast<double>(tiny / 2) == 0
+	      && static_cast<double>(tiny * rational_big(-3, 2)) == -2 * tiny,
+	      "subnormal results and a tie with zero");
+	rational_big huge(1, 1);
+	for (int i = 0; i < 1024; i++)
+		huge *= 2;
+	// the largest double is 2^1024 - 2^971, half an ulp above it rounds
+	// to infinity
+	check(std::isinf(static_cast<double>(huge))
+	      && std::isinf(static_cast<double>(huge - huge / (1LL << 54)))
+	      && static_cast<double>(huge - huge / (1LL << 53))
+		 == std::numeric_limits<double>::max(),
+	      "infinite results and the largest finite one");
+
+	// the vector lanes and the scalar tail
+	lab::rational_soa_vector<int> v;
+	for (int i = 1; i <= 37; i++)
+		v.push_back(lab::rational_t<int>(i * 7919 - 150000, i * 104729));
+	lab::vector<double> out;
+	lab::batch::to_double(v, out);
+	bool same = out.size() == v.size();
+	for (size_t i = 0; same && i < v.size(); i++)
+		same = out[i] == static_cast<double>(v.num_data()[i])
+				 / v.denom_data()[i];
+	check(same, "batch::to_double");
+}
+
+/**
+ * @brief best_by_search: Check that r is a closest fraction to x >= 0 with a
+ * denominator of at most max_denom, the one with the smallest denominator
+ * among equally close ones, by trying every denominator.
+ */
+bool best_by_search(double x, int max_denom, lab::rational_t<int> const& r)
+{
+	typedef lab::rational_t<lab::bigint> rational_big;
+
+	rational_big const exact = rational_big::from_double(x);
+	auto const distance = [&exact](rational_big const& y) {
+		rational_big const d = exact - y;
+		return d < 0 ? -d : d;
+	};
+	rational_big const found = distance(rational_big(r));
+	for (int q = 1; q <= max_denom; q++) {
+		long long const p = static_cast<long long>(x * q);
+		for (long long k = p - 1; k <= p + 1; k++) {
+			if (k < 0)
+				continue;
+			rational_big const d = distance(rational_big(k, q));
+			if (d < found || (d == found && q < r.denom()))
+				return false;
+		}
+	}
+	return r.denom() <= max_denom;
+}
+
+void test_rational_from_double()
+{
+	cout << "rational from double:\n";
+	typedef lab::rational_t<int> rational;
+	typedef lab::rational_t<long long> rational_ll;
+
+	check(rational::from_double(M_PI, 1000) == rational(355, 113)
+	      && rational::from_double(M_PI, 100) == rational(311, 99)
+	      && rational::from_double(-M_PI, 7) == rational(-22, 7),
+	      "approximations of pi");
+	check(rational::from_double(0.5, 1) == 0
+	      && rational::from_double(1.5, 1) == 1
+	      && rational::from_double(0.75, 2) == 1,
+	      "halfway values keep the smaller denominator");
+
+	unsigned long long z = 88172645463325252ull;
+	bool best = true;
+	for (int i = 0; best && i < 2000; i++) {
+		z ^= z << 13;
+		z ^= z >> 7;
+		z ^= z << 17;
+		double const x = static_cast<double>(z >> 11) / (1ULL << 49);
+		int const max_denom = static_cast<int>(z % 60) + 1;
+		rational const r = rational::from_double(x, max_denom);
+		best = best_by_search(x, max_denom, r)
+		       && rational::from_double(-x, max_denom) == -r;
+	}
+	check(best, "the closest fraction, by search over denominators");
+
+	check(rational_ll::from_double(0.1)
+	      == rational_ll(3602879701896397LL, 36028797018963968LL)
+	      && static_cast<double>(rational::from_double(0.1)) == 0.1
+	      && static_cast<double>(rational_ll::from_double(3e-19)) == 3e-19,
+	      "doubles round-trip");
+	check(rational::from_double(1e-300, 1000) == 0
+	      && rational::from_double(std::numeric_limits<double>::denorm_min(),
+				       1000) == 0
+	      && rational_ll::from_double(-1e-300) == 0
+	      && rational::from_double(-0.0, 1000) == 0,
+	      "tiny values and zeros");
+	check(rational::from_double(-2147483648.0) == rational(INT_MIN, 1)
+	      && rational::from_double(-2147483648.0, 10) == rational(INT_MIN, 1)
+	      && rational::from_double(-2147483647.75, 1) == rational(INT_MIN, 1)
+	      && rational_ll::from_double(-9223372036854775808.0)
+		 == rational_ll(LLONG_MIN, 1),
+	      "the most negative integer");
+	check_throws<std::overflow_error>([] {
+		return rational::from_double(2147483648.0);
+	}, "its negation throws");
+	check_throws<std::overflow_error>([] {
+		return rational::from_double(-2147483650.0, 10);
+	}, "one further below throws");
+	check_throws<std::overflow_error>([] {
+		return rational::from_double(1e10, 100);
+	}, "an integer part out of range throws");
+	check_throws<std::invalid_argument>([] {
+		return rational::from_double(std::nan(""), 100);
+	}, "NaN throws");
+	check_throws<std::invalid_argument>([] {
+		return rational::from_double(0.5, 0);
+	}, "a denominator bound of 0 throws");
+
+	double const x[] = {M_PI, -0.75, 1e-9, 2.0};
+	lab::rational_soa_vector<int> out;
+	lab::batch::from_double(x, 4, out, 1000);
+	check(out.size() == 4 && out[0] == rational(355, 113)
+	      && out[1] == rational(-3, 4) && out[2] == rational()
+	      && out[3] == rational(2, 1),
+	      "batch::from_double");
+}
+
+/**
+ * @brief parses: Check that from_chars reads text as num / denom and stops
+ * after used characters; an error code other than errc() must leave the
+ * value as it was.
+ */
+template<typename IntT>
+bool parses(const char* text, IntT num, IntT denom, size_t used,
+	    std::errc ec = std::errc())
+{
+	typedef lab::rational_t<IntT> rational_type;
+
+	rational_type value(42, 1);
+	std::from_chars_result const r = lab::from_chars(
+		text, text + std::strlen(text), value);
+	rational_type const expected = ec == std::errc()
+				       ? rational_type(num, denom)
+				       : rational_type(42, 1);
+	return r.ec == ec && r.ptr == text + used && value == expected;
+}
+
+void test_from_chars()
+{
+	cout << "from_chars:\n";
+	typedef lab::rational_t<long long> rational_ll;
+	std::errc const invalid = std::errc::invalid_argument;
+	std::errc const range = std::errc::result_out_of_range;
+
+	check(parses("22/7", 22, 7, 4) && parses("-6 / 4", -3, 2, 6)
+	      && parses("12\t/\t8", 3, 2, 6) && parses("-7", -7, 1, 2)
+	      && parses("-0", 0, 1, 2) && parses("0/5", 0, 1, 3),
+	      "fractions and integers");
+	check(parses("0.125", 1, 8, 5) && parses("-.5", -1, 2, 3)
+	      && parses("3.", 3, 1, 2)
+	      && parses("1.50000000000000000000000000000000", 3, 2, 34),
+	      "decimals");
+	check(parses("5/", 5, 1, 1) && parses("5 /x", 5, 1, 1)
+	      && parses("1e5", 1, 1, 1) && parses("1.5/2", 3, 2, 3),
+	      "the number ends where the syntax does");
+	check(parses(".", 0, 1, 0, invalid) && parses("-", 0, 1, 0, invalid)
+	      && parses("+5", 0, 1, 0, invalid)
+	      && parses(" 5", 0, 1, 0, invalid)
+	      && parses("5/0", 0, 1, 0, invalid), "invalid input");
+	check(parses("-2147483648", INT_MIN, 1, 11)
+	      && parses("2147483648", 0, 1, 10, range)
+	      && parses("2147483648/2", 1 << 30, 1, 12)
+	      && parses("4294967296/4294967297", 0, 1, 21, range)
+	      && parses("0.0000000001", 0, 1, 12, range),
+	      "the range is checked after the reduction");
+	check(parses("0000000000000000000000000000000000001"
+		     "/0000000000000000000003", 1, 3, 60)
+	      && parses("12345678901234567/123456789012345670", 1LL, 10LL, 36),
+	      "leading zeros and long digit strings");
+#ifdef __SIZEOF_INT128__
+	__int128 const max_128 = static_cast<__int128>(~static_cast<
+		unsigned __int128>(0) >> 1);
+	check(parses("170141183460469231731687303715884105727/3",
+		     max_128, static_cast<__int128>(3), 41)
+	      && parses("170141183460469231731687303715884105728",
+			__int128(0), __int128(1), 39, range),
+	      "__int128");
+#endif
+
+	// against std::from_chars, with runs of eight digits in any position
+	unsigned long long x = 88172645463325252ull;
+	bool same = true;
+	for (int i = 0; same && i < 20000; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		char text[64];
+		int const zeros = static_cast<int>(x % 12);
+		std::memset(text, '0', zeros);
+		long long const n = static_cast<long long>(x >> (x % 60 + 1));
+		char* end = std::to_chars(text + zeros, text + 40, n).ptr;
+		long long expected = 0;
+		std::from_chars(text, end, expected);
+		std::memcpy(end, "/1", 3);
+		rational_ll value;
+		std::from_chars_result const r = lab::from_chars(text, end + 2,
+								 value);
+		same = r.ec == std::errc() && r.ptr == end + 2
+		       && value == rational_ll(expected, 1);
+	}
+	check(same, "integers agree with std::from_chars");
+
+	const char buffer[] = "1 / 2\n-3/4\n\n  5\t0.25\n7 / 8";
+	lab::vector<rational_ll> out;
+	std::from_chars_result r = lab::parse_rationals(
+		buffer, buffer + sizeof(buffer) - 1, out);
+	check(r.ec == std::errc() && out.size() == 5
+	      && out[1] == rational_ll(-3, 4) && out[3] == rational_ll(1, 4)
+	      && out[4] == rational_ll(7, 8), "parse_rationals");
+	const char bad[] = "1/2\n3/x\n";
+	out.clear();
+	r = lab::parse_rationals(bad, bad + sizeof(bad) - 1, out);
+	check(r.ec == invalid && r.ptr == bad + 4 && out.size() == 1,
+	      "parse_rationals stops at a bad field");
+}
+
+/**
+ * @brief formats: Check that to_chars writes number as operator<< does
+ * into a buffer of exactly the needed size, and fails one character short.
+ */
+template<typename Rational>
+bool formats(Rational const& number, const char* text)
+{
+	size_t const size = std::strlen(text);
+	char buffer[128];
+	std::to_chars_result r = lab::to_chars(buffer, buffer + size, number);
+	if (r.ec != std::errc() || r.ptr != buffer + size
+	    || std::memcmp(buffer, text, size))
+		return false;
+	r = lab::to_chars(buffer, buffer + size - 1, number);
+	return r.ec == std::errc::value_too_large && r.ptr == buffer + size - 1;
+}
+
+void test_to_chars()
+{
+	cout << "to_chars:\n";
+	typedef lab::rational_t<int> rational;
+	typedef lab::rational_t<long long> rational_ll;
+
+	check(formats(rational(-22, 7), "-22 / 7") && formats(rational(), "0 / 1")
+	      && formats(rational(INT_MIN, INT_MAX), "-2147483648 / 2147483647")
+	      && lab::max_rational_chars<int> == 24,
+	      "the longest int text fills max_rational_chars");
+	check(formats(rational_ll(LLONG_MIN, 3),
+		      "-9223372036854775808 / 3"), "long long");
+#ifdef __SIZEOF_INT128__
+	__int128 const max_128 = static_cast<__int128>(~static_cast<
+		unsigned __int128>(0) >> 1);
+	check(formats(lab::rational_t<__int128>(-max_128 - 1, max_128),
+		      "-170141183460469231731687303715884105728 / "
+		      "170141183460469231731687303715884105727")
+	      && formats(lab::rational_t<__int128>(10000000000000000000ULL, 1),
+			 "10000000000000000000 / 1"),
+	      "__int128 in 19-digit chunks");
+#endif
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	check(formats(lazy(6, 4), "3 / 2")
+	      && formats(lab::rational_t<lab::bigint>(
+				 lab::bigint(1LL << 62) * lab::bigint(256), 6),
+			 "590295810358705651712 / 3"),
+	      "lazy and bigint numbers are reduced");
+
+	// against operator<< at every digit count
+	unsigned long long x = 88172645463325252ull;
+	bool same = true;
+	for (int i = 0; same && i < 20000; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		rational_ll const r(static_cast<long long>(x) >> (x % 63),
+				    static_cast<long long>(x >> 1 >> (x % 61)) + 1);
+		std::ostringstream os;
+		os << r;
+		same = formats(r, os.str().c_str());
+	}
+	check(same, "matches operator<<");
+
+	lab::rational_soa_vector<int> v;
+	v.push_back(rational(1, 2));
+	v.push_back(rational(INT_MIN, 3));
+	v.push_back(rational(7, 1));
+	char const expected[] = "1 / 2;-2147483648 / 3;7 / 1;";
+	char buffer[64];
+	std::to_chars_result r = lab::batch::to_chars(
+		v.num_data(), v.denom_data(), v.size(), buffer, buffer + 64, ';');
+	check(r.ec == std::errc() && r.ptr == buffer + sizeof(expected) - 1
+	      && !std::memcmp(buffer, expected, sizeof(expected) - 1),
+	      "batch::to_chars of columns");
+	r = lab::batch::to_chars(v.num_data(), v.denom_data(), v.size(),
+				 buffer, buffer + sizeof(expected) - 2, ';');
+	check(r.ec == std::errc::value_too_large,
+	      "batch::to_chars without room for the last separator");
+	rational const a[] = {rational(1, 2), rational(-3, 4)};
+	r = lab::batch::to_chars(a, 2, buffer, buffer + 64);
+	check(r.ec == std::errc() && r.ptr == buffer + 13
+	      && !std::memcmp(buffer, "1 / 2\n-3 / 4\n", 13),
+	      "batch::to_chars of rational_t");
+#ifdef __cpp_lib_format
+	check(std::format("[{:>9}]", rational(-22, 7)) == "[  -22 / 7]",
+	      "std::format");
+#endif
+}
+
+void test_rational_map()
+{
+	cout << "rational_map:\n";
+	typedef lab::rational_t<int> rational;
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	std::hash<lazy> const hash;
+
+	check(hash(lazy(2, 4)) == hash(lazy(1, 2))
+	      && hash(lazy(-3, -6)) == hash(lazy(1, 2))
+	      && hash(lazy(1, 2)) != hash(lazy(2, 1))
+	      && hash(lazy(0, 5)) == hash(lazy(0, 1)),
+	      "equal values hash equally");
+	std::unordered_set<lab::rational_t<lab::bigint> > big;
+	big.insert(lab::rational_t<lab::bigint>(lab::bigint(1LL << 62)
+						* lab::bigint(12), 6));
+	check(big.count(lab::rational_t<lab::bigint>(lab::bigint(1LL << 62)
+						     * lab::bigint(2), 1))
+	      && !big.count(lab::rational_t<lab::bigint>(lab::bigint(1LL << 62)
+							 * lab::bigint(-2), 1)),
+	      "std::hash<rational_t<bigint> >");
+
+	lab::rational_map<lazy, int> map;
+	check(map.empty() && !map.find(lazy(1, 2)) && !map.erase(lazy(1, 2)),
+	      "empty map");
+	check(map.insert(lazy(2, 4), 1).second
+	      && !map.insert(lazy(1, 2), 2).second && map.at(lazy(3, 6)) == 1
+	      && map.size() == 1, "keys are reduced");
+	check_throws<std::out_of_range>([&] { map.at(lazy(1, 3)); },
+					"at() of a missing key");
+	map[lazy(-1, 3)] += 5;
+	check(map[lazy(2, -6)] == 5, "operator[]");
+
+	// random inserts and erases on a table small enough to wrap around,
+	// against std::unordered_map
+	lab::rational_map<rational, int> m;
+	std::unordered_map<rational, int> reference;
+	std::mt19937 gen(5);
+	std::uniform_int_distribution<int> component(1, 40);
+	bool same = true;
+	for (int i = 0; same && i < 100000; i++) {
+		rational const key(component(gen) - 20, component(gen));
+		if (gen() % 3) {
+			same = m.insert(key, i).second
+			       == reference.emplace(key, i).second;
+		} else {
+			same = m.erase(key) == (reference.erase(key) == 1);
+		}
+		same = same && m.size() == reference.size();
+	}
+	for (auto const& entry : reference)
+		same = same && m.find(entry.first)
+		       && *m.find(entry.first) == entry.second;
+	size_t visited = 0;
+	m.for_each([&](rational const& key, int value) {
+		visited++;
+		same = same && reference.at(key) == value;
+	});
+	check(same && visited == reference.size(),
+	      "matches std::unordered_map");
+
+	lab::rational_map<rational, int> copy(m);
+	m.clear();
+	check(m.empty() && !m.contains(reference.begin()->first)
+	      && copy.size() == reference.size()
+	      && copy.contains(reference.begin()->first),
+	      "copy and clear");
+	lab::rational_map<rational, int> reserved(1000);
+	size_t const capacity = reserved.capacity();
+	for (int i = 0; i < 1000; i++)
+		reserved[rational(i, 7)] = i;
+	check(reserved.capacity() == capacity && reserved.size() == 1000,
+	      "reserve(n) holds n entries");
+	check_throws<std::length_error>([&] {
+		reserved.reserve(std::numeric_limits<size_t>::max() / 2);
+	}, "reserving past the top bit throws");
+}
+
+void test_packed_rational()
+{
+	cout << "packed_rational:\n";
+	typedef lab::rational_t<short> rational_s;
+	typedef lab::packed_rational<short> packed_s;
+
+	// every reduced rational_t<short> near the 8-bit halves: those in
+	// range pack, and words are equal exactly when values are
+	bool same = true;
+	std::vector<packed_s> all;
+	for (int p = -200; same && p <= 200; p++) {
+		for (int q = 1; same && q <= 200; q++) {
+			if (std::gcd(p, q) != 1)
+				continue;
+			bool const in_range = -128 <= p && p <= 127 && q <= 128;
+			same = packed_s::fits(static_cast<short>(p),
+					      static_cast<short>(q)) == in_range;
+			if (!in_range)
+				continue;
+			rational_s const r(static_cast<short>(p),
+					   static_cast<short>(q));
+			packed_s const packed(r);
+			same = same && !packed_s::spilled(packed.word())
+			       && packed.num() == p && packed.denom() == q
+			       && packed.unpack() == r;
+			all.push_back(packed);
+		}
+	}
+	check(same && all.size() == 20023, "every value that fits");
+	same = true;
+	for (size_t i = 0; same && i < all.size(); i += 97)
+		for (size_t j = 0; same && j < all.size(); j += 89)
+			same = (all[i] == all[j])
+			       == (all[i].unpack() == all[j].unpack());
+	check(same && sizeof(packed_s) == sizeof(rational_s) / 2
+	      && sizeof(lab::packed_rational<long long>)
+		 == sizeof(lab::rational_t<long long>) / 2,
+	      "equal words for equal values, in half the space");
+
+	typedef lab::packed_rational<long long> packed;
+	typedef lab::rational_t<long long> rational;
+	typedef lab::rational_t<long long, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	check(packed().word() == 0 && packed().unpack() == rational()
+	      && packed(lazy(6, -4)) == packed(rational(-3, 2))
+	      && packed(rational(INT32_MIN, INT32_MAX)).num() == INT32_MIN
+	      && packed(rational(INT32_MIN, INT32_MAX)).denom() == INT32_MAX
+	      && packed(rational(-1, 1LL << 31)).denom() == 1LL << 31
+	      && packed(rational(INT32_MAX, 1)).num() == INT32_MAX,
+	      "zero word, lazy values and extremes");
+	check(!packed::fits(INT32_MAX + 1LL, 1) && !packed::fits(-1, 3LL << 30)
+	      && !packed::fits(INT32_MIN - 1LL, 1) && !packed::fits(1, 0),
+	      "components past the halves do not fit");
+	check_throws<std::overflow_error>([] {
+		return packed(rational(1, (1LL << 31) + 1));
+	}, "packing a number that does not fit throws");
+
+	lab::packed_rational_vector<long long> v(3);
+	v[1] = rational(2, -6);
+	v.push_back(rational(5, 1));
+	v[2] = v[1];
+	check(v.size() == 4 && v[0] == rational() && v[2] == rational(-1, 3)
+	      && static_cast<rational>(v[3]) == 5 && v.spill_count() == 0,
+	      "packed_rational_vector");
+	check_throws<std::out_of_range>([&] { v[4]; },
+					"packed_rational_vector index check");
+
+	rational const big(LLONG_MIN, 1), tiny(1, 3000000001LL);
+	v.push_back(big);
+	v[0] = tiny;
+	v[1] = v[4];
+	check(v.spill_count() == 3 && v[0] == tiny && v[1] == big
+	      && v[4] == big && packed::spilled(v.data()[1])
+	      && v.data()[1] != v.data()[4],
+	      "numbers that do not fit are spilled");
+	v[1] = tiny;
+	v[0] = rational(7, 2);
+	lab::packed_rational_vector<long long> copy(v);
+	v[4] = rational(-1, 5);
+	check(v.spill_count() == 3 && v[1] == tiny && v[4] == rational(-1, 5)
+	      && v.data()[0] == packed(rational(7, 2)).word()
+	      && copy[4] == big && copy[1] == tiny,
+	      "spilled entries are reused and copied");
+	v.pop_back();
+	v.push_back(big);
+	v.pop_back();
+	lab::packed_rational_vector<long long> none;
+	none.pop_back();
+	check(v.size() == 4 && v.spill_count() == 3 && v[1] == tiny
+	      && none.empty(), "pop_back");
+
+	lab::rational_soa_vector<long long> columns;
+	for (int i = 0; i < 100; i++)
+		columns.push_back(rational(i - 50, 2 * i + 1));
+	std::vector<packed::word_type> words(100);
+	std::vector<long long> num(100), denom(100);
+	bool const fit = lab::batch::pack(columns.num_data(),
+					  columns.denom_data(), words.data(),
+					  100);
+	lab::batch::unpack<long long>(words.data(), num.data(), denom.data(),
+				      100);
+	check(fit && std::equal(num.begin(), num.end(), columns.num_data())
+	      && std::equal(denom.begin(), denom.end(), columns.denom_data())
+	      && packed::from_word(words[7]).unpack() == rational(-43, 15),
+	      "batch::pack and batch::unpack");
+	columns[60] = big;
+	check(!lab::batch::pack(columns.num_data(), columns.denom_data(),
+				words.data(), 100),
+	      "batch::pack reports a number that does not fit");
+}
+
+void test_thread_pool()
+{
+	cout << "thread_pool:\n";
+	lab::thread_pool pool(3);
+	std::vector<int> hits(10000, 0);
+	pool.parallel_for(0, hits.size(), [&](size_t lo, size_t hi) {
+		for (size_t i = lo; i != hi; ++i)
+			hits[i]++;
+	}, 100);
+	check(std::count(hits.begin(), hits.end(), 1) == 10000,
+	      "parallel_for covers the range once");
+
+	std::atomic<long long> sum(0);
+	pool.parallel_for(0, 64, [&](size_t lo, size_t hi) {
+		for (size_t i = lo; i != hi; ++i)
+			pool.parallel_for(0, 100, [&](size_t a, size_t b) {
+				for (size_t j = a; j != b; ++j)
+					sum += static_cast<long long>(j);
+			});
+	});
+	check(sum == 64 * 4950, "nested parallel_for");
+
+	check_throws<std::runtime_error>([&] {
+		pool.parallel_for(0, 1000, [](size_t lo, size_t hi) {
+			if (lo <= 500 && 500 < hi)
+				throw std::runtime_error("chunk failed");
+		});
+	}, "parallel_for rethrows");
+
+	std::atomic<int> done(0);
+	{
+		lab::thread_pool local(2);
+		for (int i = 0; i < 100; i++)
+			local.submit([&done] { done++; });
+	}
+	check(done == 100, "queued tasks finish before the pool is destroyed");
+
+	// tasks a worker submits go to its own deque; the others steal them
+	std::atomic<int> stolen(0);
+	{
+		lab::thread_pool local(3);
+		local.submit([&local, &stolen] {
+			for (int i = 0; i < 1000; i++)
+				local.submit([&stolen] { stolen++; });
+		});
+	}
+	check(stolen == 1000, "tasks submitted by a worker finish");
+}
+
+void test_matrix()
+{
+	cout << "matrix:\n";
+	typedef lab::rational_t<long long> rational;
+	typedef lab::matrix<rational> matrix;
+	lab::thread_pool pool(3);
+
+	// sizes that are not multiples of the block size
+	matrix a(70, 90), b(90, 65);
+	std::mt19937 gen(7);
+	std::uniform_int_distribution<int> num(-9, 9), den(1, 6);
+	for (size_t i = 0; i < a.rows() * a.cols(); i++)
+		a.data()[i] = rational(num(gen), den(gen));
+	for (size_t i = 0; i < b.rows() * b.cols(); i++)
+		b.data()[i] = gen() % 3 ? rational(num(gen), den(gen)) : rational();
+	matrix naive(70, 65);
+	for (size_t i = 0; i < 70; i++)
+		for (size_t j = 0; j < 65; j++)
+			for (size_t k = 0; k < 90; k++)
+				naive(i, j) += a(i, k) * b(k, j);
+	check(multiply(a, b, pool) == naive && a * b == naive,
+	      "blocked product");
+	check(matrix::identity(70) * a == a && a + a - a == a
+	      && a * matrix::identity(90) == a, "identity, sum and difference");
+	check_throws<std::invalid_argument>([&] { a * a; },
+					    "product of mismatched sizes");
+	check_throws<std::out_of_range>([&] { a.at(70, 0); },
+					"matrix index check");
+
+	// Hilbert matrices: det H(n) = 1 / 1, 12, 2160, 6048000, ...
+	long long const inverse[] = {1, 12, 2160, 6048000, 266716800000LL,
+				     186313420339200000LL};
+	bool same = true;
+	for (size_t n = 1; n <= 6; n++) {
+		matrix h(n, n);
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = 0; j < n; j++)
+				h(i, j) = rational(1, static_cast<long long>(
+							   i + j + 1));
+		same = same && lab::determinant(h, pool)
+			       == rational(1, inverse[n - 1]);
+	}
+	check(same, "determinant of Hilbert matrices");
+	typedef lab::rational_t<lab::bigint> big;
+	lab::matrix<big> h(10, 10);
+	for (int i = 0; i < 10; i++)
+		for (int j = 0; j < 10; j++)
+			h(i, j) = big(lab::bigint(1), lab::bigint(i + j + 1));
+	char text[80];
+	char const expected[] =
+		"1 / 46206893947914691316295628839036278726983680000000000";
+	check(lab::to_chars(text, text + 80, lab::determinant(h, pool)).ptr
+	      == text + sizeof(expected) - 1
+	      && !std::memcmp(text, expected, sizeof(expected) - 1),
+	      "determinant with bigint components");
+
+	matrix p(3, 3);		// needs a row exchange
+	p(0, 1) = rational(2, 1);
+	p(1, 0) = rational(3, 1);
+	p(2, 2) = rational(1, 2);
+	matrix singular(3, 3);
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 3; j++)
+			singular(i, j) = rational(static_cast<long long>(i * j), 1);
+	check(lab::determinant(p) == -3 && lab::determinant(singular) == 0
+	      && lab::determinant(matrix()) == 1, "pivoting and singular");
+
+	// after the row exchange the last pivot is LLONG_MIN: the true
+	// determinant is 2^63, and 2^62 once the second row is halved
+	matrix extreme(2, 2);
+	extreme(0, 1) = rational(LLONG_MIN, 1);
+	extreme(1, 0) = rational(1, 1);
+	check_throws<std::overflow_error>([&] {
+		return lab::determinant(extreme);
+	}, "a determinant of 2^63 throws");
+	extreme(1, 0) = rational(1, 2);
+	check(lab::determinant(extreme) == rational(1LL << 62, 1),
+	      "a negated pivot of LLONG_MIN that the scale brings into range");
+
+	size_t const n = 8;
+	matrix m(n, n);
+	lab::vector<rational> x0(n), rhs(n), x;
+	for (size_t i = 0; i < n * n; i++)
+		m.data()[i] = rational(num(gen), den(gen));
+	for (size_t i = 0; i < n; i++)
+		x0.data()[i] = rational(num(gen), den(gen));
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++)
+			rhs.data()[i] += m(i, j) * x0.data()[j];
+	lab::solve(m, rhs, x, pool);
+	same = x.size() == n;
+	for (size_t i = 0; same && i < n; i++)
+		same = x.data()[i] == x0.data()[i];
+	check(same, "solve");
+
+	typedef lab::rational_t<lab::bigint> big;
+	lab::matrix<big> mb(n, n);
+	lab::vector<big> x0b(n), rhsb(n), xb;
+	for (size_t i = 0; i < n * n; i++)
+		mb.data()[i] = big(lab::bigint(num(gen)), lab::bigint(den(gen)));
+	for (size_t i = 0; i < n; i++)
+		x0b.data()[i] = big(lab::bigint(num(gen)), lab::bigint(den(gen)));
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++)
+			rhsb.data()[i] += mb(i, j) * x0b.data()[j];
+	lab::solve(mb, rhsb, xb, pool);
+	same = xb.size() == n;
+	for (size_t i = 0; same && i < n; i++)
+		same = xb.data()[i] == x0b.data()[i];
+	check(same, "solve with bigint components");
+	check_throws<std::invalid_argument>([&] {
+		lab::vector<rational> b3(3);
+		lab::solve(singular, b3, x);
+	}, "solve of a singular system");
+}
+
+void test_rational_numeric()
+{
+	cout << "rational_numeric:\n";
+	typedef lab::rational_t<long long> rational;
+	lab::thread_pool pool(3);
+
+	// more than a chunk per task, denominators with common factors
+	size_t const n = 100000;
+	lab::vector<rational> v(n);
+	std::mt19937 gen(3);
+	std::uniform_int_distribution<int> num(-100, 100), den(1, 8);
+	for (size_t i = 0; i < n; i++)
+		v.data()[i] = rational(num(gen), den(gen));
+	rational serial, squares;
+	for (size_t i = 0; i < n; i++) {
+		serial += v.data()[i];
+		squares += v.data()[i] * v.data()[i];
+	}
+	check(lab::reduce(v, pool) == serial && lab::reduce(v) == serial
+	      && lab::reduce(v.data(), 10, pool)
+		 == std::accumulate(v.data(), v.data() + 10, rational())
+	      && lab::reduce(v.data(), 0, pool) == 0,
+	      "reduce");
+	check(lab::transform_reduce(v, [](rational const& x) {
+		return x * x;
+	}, pool) == squares, "transform_reduce");
+
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	lazy const halves[] = {lazy(2, 4), lazy(3, 6), lazy(-4, 8)};
+	check(lab::reduce(halves, 3, pool) == lazy(1, 2),
+	      "lazy operands");
+	lab::rational_t<int> const big[] = {lab::rational_t<int>(INT_MAX, 1),
+					    lab::rational_t<int>(1, 1)};
+	check_throws<std::overflow_error>([&] { lab::reduce(big, 2, pool); },
+					  "a sum out of range throws");
+#ifdef __SIZEOF_INT128__
+	// no wider type: the running sum is moved into the total on overflow
+	typedef lab::rational_t<__int128> rational_128;
+	__int128 const half = static_cast<__int128>(1) << 126;
+	rational_128 const wide[] = {rational_128(half, 1), rational_128(half, 1),
+				     rational_128(-half, 1)};
+	check(lab::reduce(wide, 3, pool) == rational_128(half, 1),
+	      "an overflowing running sum is flushed unchanged");
+#endif
+
+	lab::vector<rational> inclusive(n), exclusive(n);
+	lab::inclusive_scan(v.data(), n, inclusive.data(), pool);
+	lab::exclusive_scan(v.data(), n, exclusive.data(), rational(1, 3), pool);
+	bool same = true;
+	rational running;
+	for (size_t i = 0; same && i < n; i++) {
+		same = exclusive.data()[i] == running + rational(1, 3);
+		running += v.data()[i];
+		same = same && inclusive.data()[i] == running;
+	}
+	check(same, "inclusive_scan and exclusive_scan");
+	lab::inclusive_scan(v.data(), n, v.data(), pool);
+	same = true;
+	for (size_t i = 0; same && i < n; i++)
+		same = v.data()[i] == inclusive.data()[i];
+	check(same, "scan in place");
+}
+
+/**
+ * @brief evaluates_as_horner: Check batch::evaluate against Horner's
+ * scheme with the rational_t operators at up to n random points with
+ * components of the given magnitude, those where the operators succeed.
+ */
+template<typename IntT>
+bool evaluates_as_horner(lab::polynomial<lab::rational_t<IntT> > const& p,
+			 int magnitude, size_t n, std::mt19937& gen)
+{
+	typedef lab::rational_t<IntT> rational;
+	std::uniform_int_distribution<int> num(-magnitude, magnitude);
+	std::uniform_int_distribution<int> den(1, magnitude);
+	lab::rational_soa_vector<IntT> x, y;
+	lab::vector<rational> expected;
+	for (size_t i = 0; i < n; i++) {
+		rational const point(static_cast<IntT>(num(gen)),
+				     static_cast<IntT>(den(gen)));
+		try {
+			expected.push_back(p(point));
+			x.push_back(point);
+		} catch (std::overflow_error const&) {
+		}
+	}
+	lab::batch::evaluate(p, x, y);
+	if (y.size() != x.size())
+		return false;
+	for (size_t i = 0; i < x.size(); i++)
+		if (!(rational(y[i]) == expected.data()[i]))
+			return false;
+	return true;
+}
+
+void test_polynomial()
+{
+	cout << "polynomial:\n";
+	typedef lab::rational_t<int> rational;
+	typedef lab::polynomial<rational> polynomial;
+
+	polynomial const p = {rational(1, 2), rational(-3, 4), rational(),
+			      rational(5, 6), rational(), rational()};
+	check(p.degree() == 3 && p.size() == 4 && p[2] == 0 && p[9] == 0
+	      && polynomial({rational(), rational()}).is_zero()
+	      && p != polynomial() && p == polynomial(lab::vector<rational>{
+			rational(1, 2), rational(-3, 4), rational(),
+			rational(5, 6)}),
+	      "trailing zeros are dropped");
+	// 1/2 - 3/4 x + 5/6 x^3 at -2/3: 1/2 + 1/2 - 20/81
+	check(p(rational(-2, 3)) == rational(61, 81) && polynomial()(rational(
+		7, 1)) == 0, "Horner's scheme");
+
+	std::mt19937 gen(11);
+	std::uniform_int_distribution<int> coefficient(-20, 20), den(1, 12);
+	bool same = true;
+	for (int degree = 0; same && degree <= 8; degree++) {
+		lab::vector<rational> c;
+		for (int k = 0; k <= degree; k++)
+			c.push_back(rational(coefficient(gen), den(gen)));
+		polynomial const q(c);
+		// small points take the kernel, large ones the bound check
+		// and the operators
+		same = evaluates_as_horner(q, 10, 200, gen)
+		       && evaluates_as_horner(q, 1000, 200, gen)
+		       && evaluates_as_horner(
+			       lab::polynomial<lab::rational_t<long long> >(
+				       lab::vector<lab::rational_t<long long> >{
+					       lab::rational_t<long long>(
+						       c.data()[0].num(),
+						       c.data()[0].denom()),
+					       lab::rational_t<long long>(
+						       degree, 7)}),
+			       100000, 200, gen);
+	}
+	check(same, "batch::evaluate matches the operators");
+
+	lab::rational_soa_vector<int> x;
+	x.push_back(rational(-2, 3));
+	x.push_back(rational(46341, 1));
+	x.push_back(rational(0, 1));
+	lab::vector<int> num(3), denom(3);
+	lab::batch::evaluate(polynomial{rational(), rational(), rational(1, 1)},
+			     x.num_data(), x.denom_data(), num.data(),
+			     denom.data(), 1);
+	check(num.data()[0] == 4 && denom.data()[0] == 9,
+	      "squares in range");
+	check_throws<std::overflow_error>([&] {
+		lab::batch::evaluate(polynomial{rational(), rational(),
+						rational(1, 1)},
+				     x.num_data() + 1, x.denom_data() + 1,
+				     num.data(), denom.data(), 1);
+	}, "a value out of range throws");
+	lab::batch::evaluate(p, x.num_data(), x.denom_data(), x.num_data(),
+			     x.denom_data(), 1);
+	check(x[0] == rational(61, 81), "outputs may alias the points");
+	lab::batch::evaluate(polynomial(), x.num_data(), x.denom_data(),
+			     num.data(), denom.data(), 3);
+	check(num.data()[2] == 0 && denom.data()[2] == 1,
+	      "the zero polynomial");
+}
+
+/**
+ * @brief filters_exactly: Check filtered_compare, filtered_sort and the
+ * filtered extremes against the exact operators on n values, half of them
+ * random and half next to another value: p / q against (p k + 1) / (q k),
+ * closer than the doubles resolve for wide components.
+ */
+template<typename Rational>
+bool filters_exactly(size_t n, int bits, std::mt19937_64& gen)
+{
+	typedef typename Rational::int_type IntT;
+	// below 2^(b - 1), b <= 64
+	auto const random = [&](int b) {
+		return static_cast<IntT>(gen() & ((1ULL << (b - 1)) - 1));
+	};
+	std::vector<Rational> v;
+	while (v.size() < n) {
+		IntT const p = static_cast<IntT>(random(bits / 2) - random(
+						       bits / 2));
+		IntT const q = static_cast<IntT>(random(bits / 2) + 1);
+		IntT const k = static_cast<IntT>(random(bits / 2 - 1) + 1);
+		v.push_back(Rational(p, q));
+		v.push_back(Rational(static_cast<IntT>(p * k + 1),
+				     static_cast<IntT>(q * k)));
+	}
+	for (size_t i = 0; i + 1 < v.size(); i++) {
+		Rational const& a = v[i];
+		Rational const& b = v[i + 1];
+		int const exact = a < b ? -1 : b < a ? 1 : 0;
+		if (lab::filtered_compare(a, b) != exact
+		    || lab::filtered_compare(b, a) != -exact
+		    || lab::filtered_compare(a, a) != 0
+		    || compare(lab::filtered_rational<Rational>(a),
+			       lab::filtered_rational<Rational>(b)) != exact)
+			return false;
+	}
+
+	std::vector<Rational> sorted = v;
+	lab::filtered_sort(sorted.data(), sorted.size());
+	std::vector<Rational> expected = v;
+	std::sort(expected.begin(), expected.end());
+	for (size_t i = 0; i < v.size(); i++)
+		if (!(sorted[i] == expected[i]))
+			return false;
+	return *lab::filtered_min_element(v.data(), v.size()) == expected[0]
+	       && *lab::filtered_max_element(v.data(), v.size())
+		  == expected.back()
+	       && lab::filtered_min_element(v.data(), 0) == nullptr;
+}
+
+void test_rational_filter()
+{
+	cout << "rational_filter:\n";
+	std::mt19937_64 gen(13);
+	check(filters_exactly<lab::rational_t<int> >(2000, 31, gen)
+	      && filters_exactly<lab::rational_t<long long> >(2000, 63, gen),
+	      "int and long long");
+#ifdef __SIZEOF_INT128__
+	check(filters_exactly<lab::rational_t<__int128> >(2000, 127, gen),
+	      "__int128");
+#endif
+	typedef lab::rational_t<long long, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	check(lab::filtered_compare(lazy(2, 4), lazy(1, 2)) == 0
+	      && lab::filtered_compare(lazy(-1, 3), lazy(-2, 7)) == -1
+	      && lab::filtered_less()(lazy(0, 5), lazy(1, 1000000007)),
+	      "lazy values");
+	typedef lab::rational_t<lab::bigint> big;
+	lab::bigint const large = lab::bigint(1LL << 62) * lab::bigint(1LL << 62);
+	big const a(large + lab::bigint(1), large), b(large, large - lab::bigint(1));
+	check(lab::filtered_compare(a, b) == -1
+	      && lab::filtered_compare(b, a) == 1
+	      && lab::filtered_compare(a, a) == 0,
+	      "bigint components compare exactly");
+	// 1 + 2^-124 and 1 + 1/(2^124 - 1) are the same double
+	big values[] = {b, a, big(lab::bigint(1), lab::bigint(1))};
+	lab::filtered_sort(values, 3);
+	check(values[0] == big(lab::bigint(1), lab::bigint(1)) && values[1] == a
+	      && values[2] == b, "filtered_sort of bigint values");
+}
+
+/**
+ * @brief radix_sorts: Check radix_sort against std::sort on n integers
+ * drawn by next(), serially and on a pool that cuts every pass into
+ * chunks.
+ */
+template<typename IntT, typename Next>
+bool radix_sorts(size_t n, Next next, lab::thread_pool& pool)
+{
+	lab::vector<IntT> v(n);
+	for (size_t i = 0; i < n; i++)
+		v.data()[i] = static_cast<IntT>(next());
+	std::vector<IntT> expected(v.data(), v.data() + n);
+	std::sort(expected.begin(), expected.end());
+	lab::vector<IntT> w(v);
+	lab::radix_sort(v);
+	lab::radix_sort(w, pool);
+	return std::equal(expected.begin(), expected.end(), v.data())
+	       && std::equal(expected.begin(), expected.end(), w.data());
+}
+
+void test_radix_sort()
+{
+	cout << "radix_sort:\n";
+	lab::thread_pool pool(3);
+	std::mt19937_64 gen(17);
+	size_t const n = 300000;	// several chunks per pass
+
+	check(radix_sorts<int>(n, gen, pool)
+	      && radix_sorts<long long>(n, gen, pool)
+	      && radix_sorts<unsigned>(n, gen, pool)
+	      && radix_sorts<short>(n, gen, pool)
+	      && radix_sorts<int>(100, gen, pool),
+	      "random integers");
+	// the high bytes are the same in all elements and their passes are
+	// skipped, but not the bytes of the sign
+	check(radix_sorts<int>(n, [&] { return gen() % 1000; }, pool)
+	      && radix_sorts<long long>(n, [&] {
+		      return static_cast<long long>(gen() % 2000) - 1000;
+	      }, pool)
+	      && radix_sorts<int>(n, [] { return 7; }, pool)
+	      && radix_sorts<long long>(n, [&] {
+		      return gen() % 2 ? LLONG_MIN : LLONG_MAX;
+	      }, pool), "small values, equal values and extremes");
+	// 1000 + i % 3: only the low byte differs
+	std::vector<int> src(n), dst(n, 0);
+	for (size_t i = 0; i < n; i++)
+		src[i] = 1000 + static_cast<int>(i % 3);
+	auto const key = [](int x) { return static_cast<unsigned>(x); };
+	bool const skipped = !lab::detail::radix_pass(src.data(), dst.data(), n,
+						      key, 8, pool);
+	check(skipped && std::count(dst.begin(), dst.end(), 0) == long(n)
+	      && lab::detail::radix_pass(src.data(), dst.data(), n, key, 0, pool)
+	      && std::is_sorted(dst.begin(), dst.end()),
+	      "a byte shared by all chunks is skipped");
+
+	typedef lab::rational_t<long long> rational;
+	std::vector<rational> values;
+	while (values.size() < n) {
+		long long const p = static_cast<long long>(gen() % 2000000) - 1000000;
+		long long const q = static_cast<long long>(gen() % 1000000) + 1;
+		long long const k = static_cast<long long>(gen() % 1000000000000LL)
+				    + 1;
+		// p / q and (p k + 1) / (q k) often have the same double
+		values.push_back(rational(p, q));
+		values.push_back(rational(p * k + 1, q * k));
+		values.push_back(rational(-p, q));
+	}
+	std::vector<rational> sorted = values, expected = values;
+	lab::radix_sort(sorted.data(), sorted.size(), pool);
+	std::sort(expected.begin(), expected.end());
+	check(sorted == expected, "rational_t, with ties broken exactly");
+
+	typedef lab::rational_t<int, lab::overflow_throw,
+				lab::lazy_normalization> lazy;
+	lab::vector<lazy> lazies;
+	for (int i = 0; i < 5000; i++)
+		lazies.push_back(lazy(static_cast<int>(gen() % 200) - 100,
+				      static_cast<int>(gen() % 50) + 1) * lazy(2, 2));
+	lab::radix_sort(lazies, pool);
+	bool ordered = true;
+	for (size_t i = 1; i < lazies.size(); i++)
+		ordered = ordered && !(lazies.data()[i] < lazies.data()[i - 1]);
+	check(ordered, "lazy rational_t");
+
+	typedef lab::rational_t<lab::bigint> big;
+	std::vector<big> bigs;
+	for (int i = 0; i < 2000; i++)
+		bigs.push_back(big(lab::bigint(static_cast<long long>(gen() % 1000)),
+				   lab::bigint(static_cast<long long>(gen() % 7) + 1)));
+	lab::radix_sort(bigs.data(), bigs.size(), pool);
+	check(std::is_sorted(bigs.begin(), bigs.end()),
+	      "bigint components fall back to std::sort");
+}
+
+/**
+ * @brief parallel_sorts: Check parallel_sort against std::sort on n
+ * values drawn by next(), serially and on a pool.
+ */
+template<typename T, typename Next>
+bool parallel_sorts(size_t n, Next next, lab::thread_pool& pool)
+{
+	lab::vector<T> v(n);
+	for (size_t i = 0; i < n; i++)
+		v.data()[i] = next(i);
+	std::vector<T> expected(v.data(), v.data() + n);
+	std::sort(expected.begin(), expected.end());
+	lab::vector<T> w(v);
+	lab::thread_pool serial(0);
+	lab::parallel_sort(v, serial);
+	lab::parallel_sort(w, pool);
+	return std::equal(expected.begin(), expected.end(), v.data())
+	       && std::equal(expected.begin(), expected.end(), w.data());
+}
+
+void test_parallel_sort()
+{
+	cout << "parallel_sort:\n";
+	lab::thread_pool pool(3);
+	std::mt19937_64 gen(19);
+	size_t const n = 300000;	// several buckets per thread
+
+	auto const random = [&](size_t) { return static_cast<int>(gen()); };
+	check(parallel_sorts<int>(n, random, pool)
+	      && parallel_sorts<long long>(n, [&](size_t) {
+		      return static_cast<long long>(gen());
+	      }, pool)
+	      && parallel_sorts<double>(n, [&](size_t) {
+		      return static_cast<double>(gen()) / 3;
+	      }, pool),
+	      "random values");
+	lab::vector<int> none;
+	lab::parallel_sort(none, pool);
+	check(none.empty() && parallel_sorts<int>(1, random, pool)
+	      && parallel_sorts<int>(2, random, pool)
+	      && parallel_sorts<int>(17, random, pool)
+	      && parallel_sorts<int>(1000, random, pool),
+	      "short arrays");
+	check(parallel_sorts<int>(n, [](size_t i) { return int(i); }, pool)
+	      && parallel_sorts<int>(n, [](size_t i) { return -int(i); }, pool)
+	      && parallel_sorts<int>(n, [](size_t i) {
+		      return int(i < n / 2 ? i : n - i);
+	      }, pool)
+	      && parallel_sorts<int>(n, [](size_t i) { return int(i % 64); },
+				     pool),
+	      "sorted, reversed, organ pipe and sawtooth input");
+	// every splitter is the same value and all goes into one bucket
+	check(parallel_sorts<int>(n, [](size_t) { return 5; }, pool)
+	      && parallel_sorts<int>(n, [&](size_t) { return int(gen() % 3); },
+				     pool),
+	      "equal values");
+
+	typedef lab::rational_t<long long> rational;
+	check(parallel_sorts<rational>(n / 4, [&](size_t) {
+		return rational(static_cast<long long>(gen() % 2001) - 1000,
+				static_cast<long long>(gen() % 1000) + 1);
+	}, pool), "rational_t");
+	typedef lab::rational_t<lab::bigint> big;
+	check(parallel_sorts<big>(40000, [&](size_t) {
+		return big(lab::bigint(static_cast<long long>(gen() % 1000)),
+			   lab::bigint(static_cast<long long>(gen() % 7) + 1));
+	}, pool), "bigint components");
+
+	// sizes 0, 1 and some not a multiple of anything, with duplicates
+	size_t const sizes[] = { 90001, 0, 1, 120000, 33333, 77 };
+	size_t const k = sizeof(sizes) / sizeof(sizes[0]);
+	std::vector<lab::vector<int> > ranges;
+	std::vector<int> all;
+	for (size_t s = 0; s < k; s++) {
+		lab::vector<int> r;
+		for (size_t i = 0; i < sizes[s]; i++)
+			r.push_back(static_cast<int>(gen() % 100000));
+		std::sort(r.data(), r.data() + r.size());
+		all.insert(all.end(), r.data(), r.data() + r.size());
+		ranges.push_back(std::move(r));
+	}
+	std::sort(all.begin(), all.end());
+	lab::vector<int> merged(3), serial_merged;	// resized by the merge
+	lab::thread_pool serial(0);
+	lab::parallel_merge(ranges.data(), k, merged, pool);
+	lab::parallel_merge(ranges.data(), k, serial_merged, serial);
+	check(merged.size() == all.size() && serial_merged.size() == all.size()
+	      && std::equal(all.begin(), all.end(), merged.data())
+	      && std::equal(all.begin(), all.end(), serial_merged.data()),
+	      "multiway merge");
+
+	lab::vector<int> twice[2] = { lab::vector<int>(n), lab::vector<int>(n) };
+	for (size_t i = 0; i < n; i++)
+		twice[0].data()[i] = twice[1].data()[i] = 42;
+	lab::parallel_merge(twice, 2, merged, pool);
+	check(merged.size() == 2 * n
+	      && std::count(merged.data(), merged.data() + 2 * n, 42)
+		 == long(2 * n),
+	      "merge of equal values");
+	lab::parallel_merge(ranges.data() + 1, 1, merged, pool);
+	lab::parallel_merge(ranges.data(), 0, serial_merged, pool);
+	check(merged.size() == 0 && serial_merged.size() == 0,
+	      "merge of nothing");
+}
+
 int main()
 {
 	test_vector();
-	return 0;
+	test_ring_buffer();
+	test_concurrent_queue();
+	test_rational_soa_vector();
+	test_rational_batch();
+	test_gcd();
+	test_rational_overflow();
+	test_bigint();
+	test_lazy_normalization();
+	test_rational_expr();
+	test_rational_compare();
+	test_rational_constexpr();
+	test_rational_ratio();
+	test_rational_integer();
+	test_rational_floating();
+	test_rational_from_double();
+	test_from_chars();
+	test_to_chars();
+	test_rational_map();
+	test_packed_rational();
+	test_thread_pool();
+	test_matrix();
+	test_rational_numeric();
+	test_polynomial();
+	test_rational_filter();
+	test_radix_sort();
+	test_parallel_sort();
+	return failures ? 1 : 0;
 }
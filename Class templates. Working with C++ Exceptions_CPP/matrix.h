@@ -0,0 +1,432 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "gcd.h"
+#include "overflow.h"
+#include "rational.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+namespace lab {
+
+/**
+ * @brief matrix is a dense row-major matrix backed by a lab::vector.
+ *
+ * Elements are value-initialized (0 for numbers). The operators run on
+ * default_thread_pool(); multiply() takes a pool explicitly.
+ */
+template<typename T>
+class matrix {
+public:
+	typedef size_t		size_type;
+	typedef T		value_type;
+	typedef T&		reference;
+	typedef const T&	const_reference;
+private:
+	size_type rows_;
+	size_type cols_;
+	vector<T> data_;
+public:
+	/**
+	 *  @brief  Creates a 0 x 0 matrix.
+	 */
+	matrix() : rows_(0), cols_(0) {}
+
+	/**
+	 *  @brief  Creates a rows x cols matrix of zeros.
+	 */
+	matrix(size_type rows, size_type cols)
+		: rows_(rows), cols_(cols),
+		  data_(rows * cols != 0 ? vector<T>(rows * cols) : vector<T>())
+	{}
+
+	static matrix identity(size_type n)
+	{
+		matrix result(n, n);
+		T const one = T() + 1;	// rational_t has no converting constructor
+		for (size_type i = 0; i != n; ++i)
+			result(i, i) = one;
+		return result;
+	}
+
+	size_type rows() const noexcept { return rows_; }
+	size_type cols() const noexcept { return cols_; }
+
+	/**
+	 *  @brief  Unchecked element access.
+	 */
+	reference operator()(size_type i, size_type j) noexcept
+	{
+		return data_.data()[i * cols_ + j];
+	}
+	const_reference operator()(size_type i, size_type j) const noexcept
+	{
+		return data_.data()[i * cols_ + j];
+	}
+
+	/**
+	 *  @brief  Checked element access.
+	 */
+	reference at(size_type i, size_type j) noexcept(false)
+	{
+		if (i >= rows_ || j >= cols_)
+			throw std::out_of_range("No such element.");
+		return (*this)(i, j);
+	}
+	const_reference at(size_type i, size_type j) const noexcept(false)
+	{
+		if (i >= rows_ || j >= cols_)
+			throw std::out_of_range("No such element.");
+		return (*this)(i, j);
+	}
+
+	/**
+	 * Returns the elements row by row; row i starts at
+	 * data() + i * cols().
+	 */
+	T* data() noexcept { return data_.data(); }
+	const T* data() const noexcept { return data_.data(); }
+
+	friend bool operator==(matrix const& lhs, matrix const& rhs)
+	{
+		if (lhs.rows_ != rhs.rows_ || lhs.cols_ != rhs.cols_)
+			return false;
+		for (size_type i = 0; i != lhs.rows_ * lhs.cols_; ++i)
+			if (!(lhs.data()[i] == rhs.data()[i]))
+				return false;
+		return true;
+	}
+	friend bool operator!=(matrix const& lhs, matrix const& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	friend matrix operator+(matrix const& lhs, matrix const& rhs)
+	{
+		return combine(lhs, rhs, false);
+	}
+	friend matrix operator-(matrix const& lhs, matrix const& rhs)
+	{
+		return combine(lhs, rhs, true);
+	}
+	friend matrix operator*(matrix const& lhs, matrix const& rhs)
+	{
+		return multiply(lhs, rhs, default_thread_pool());
+	}
+
+	/**
+	 *  @brief  lhs * rhs, computed by blocks of block_size x block_size
+	 *  elements, with row blocks spread over pool.
+	 *
+	 *  Within a block the loops run i, k, j: the row of rhs and the row
+	 *  of the result are walked contiguously while they are in cache, and
+	 *  a zero lhs(i, k) skips its whole row of products.
+	 */
+	friend matrix multiply(matrix const& lhs, matrix const& rhs,
+			       thread_pool& pool)
+	{
+		if (lhs.cols_ != rhs.rows_)
+			throw std::invalid_argument(
+				"Matrix sizes don't match.");
+
+		matrix result(lhs.rows_, rhs.cols_);
+		size_type const row_blocks = (lhs.rows_ + block_size - 1)
+					     / block_size;
+		auto const rows = [&](size_type lo, size_type hi) {
+			for (size_type b = lo; b != hi; ++b)
+				multiply_rows(lhs, rhs, result, b * block_size);
+		};
+		pool.parallel_for(0, row_blocks, rows);
+		return result;
+	}
+
+	/**
+	 * @brief print: Print the matrix row by row using std::cout
+	 */
+	void print() const
+	{
+		for (size_type i = 0; i != rows_; ++i) {
+			for (size_type j = 0; j != cols_; ++j)
+				std::cout << (*this)(i, j) << "; ";
+			std::cout << "\n";
+		}
+	}
+private:
+	static matrix combine(matrix const& lhs, matrix const& rhs,
+			      bool subtract)
+	{
+		if (lhs.rows_ != rhs.rows_ || lhs.cols_ != rhs.cols_)
+			throw std::invalid_argument(
+				"Matrix sizes don't match.");
+		matrix result(lhs.rows_, lhs.cols_);
+		const T* const x = lhs.data();
+		const T* const y = rhs.data();
+		for (size_type i = 0; i != lhs.rows_ * lhs.cols_; ++i)
+			result.data()[i] = subtract ? x[i] - y[i] : x[i] + y[i];
+		return result;
+	}
+
+	enum : size_type { block_size = 64 };
+
+	static size_type block_end(size_type start, size_type n) noexcept
+	{
+		return n - start < block_size ? n : start + block_size;
+	}
+
+	// the rows [i0, i0 + block_size) of lhs * rhs, block by block
+	static void multiply_rows(matrix const& lhs, matrix const& rhs,
+				  matrix& result, size_type i0)
+	{
+		size_type const i1 = block_end(i0, lhs.rows_);
+		for (size_type k0 = 0; k0 < lhs.cols_; k0 += block_size) {
+			size_type const k1 = block_end(k0, lhs.cols_);
+			for (size_type j0 = 0; j0 < rhs.cols_; j0 += block_size)
+				multiply_block(lhs, rhs, result, i0, i1, k0, k1,
+					       j0, block_end(j0, rhs.cols_));
+		}
+	}
+
+	static void multiply_block(matrix const& lhs, matrix const& rhs,
+				   matrix& result,
+				   size_type i0, size_type i1,
+				   size_type k0, size_type k1,
+				   size_type j0, size_type j1)
+	{
+		T const zero = T();
+		for (size_type i = i0; i != i1; ++i) {
+			T* const out = result.data() + i * result.cols_;
+			for (size_type k = k0; k != k1; ++k) {
+				T const a = lhs(i, k);
+				if (a == zero)
+					continue;
+				const T* const row = rhs.data() + k * rhs.cols_;
+				for (size_type j = j0; j != j1; ++j)
+					out[j] += a * row[j];
+			}
+		}
+	}
+};
+
+namespace detail {
+
+// Integer form of the rows of a rational matrix for fraction-free
+// elimination: every row is scaled by the lcm of its denominators.
+// Overflows throw std::overflow_error: the elimination is exact, there is
+// no approximation to fall back to.
+template<typename IntT>
+inline IntT checked_mul(IntT a, IntT b)
+{
+	IntT r = 0;
+	if (mul_overflow(a, b, r))
+		throw std::overflow_error("Rational overflow.");
+	return r;
+}
+
+template<typename Rational>
+void scale_rows(matrix<Rational> const& a, const Rational* rhs,
+		vector<typename Rational::int_type>& out, size_t width,
+		vector<typename Rational::int_type>& scales)
+{
+	typedef typename Rational::int_type IntT;
+	size_t const n = a.rows();
+
+	for (size_t i = 0; i != n; ++i) {
+		IntT lcm = 1;
+		for (size_t j = 0; j != width; ++j) {
+			Rational const x = (j < a.cols() ? a(i, j) : rhs[i])
+					   .normalized();
+			using lab::gcd;	// or the one found by ADL
+			IntT const d = x.denom();
+			lcm = checked_mul(IntT(lcm / gcd(lcm, d)), d);
+		}
+		for (size_t j = 0; j != width; ++j) {
+			Rational const x = (j < a.cols() ? a(i, j) : rhs[i])
+					   .normalized();
+			out.data()[i * width + j] = checked_mul(x.num(),
+							IntT(lcm / x.denom()));
+		}
+		scales.data()[i] = lcm;
+	}
+}
+
+// (a * d - b * c) / e, exact by Sylvester's identity
+template<typename IntT>
+IntT bareiss_update(IntT a, IntT d, IntT b, IntT c, IntT e)
+{
+	typedef typename widen<IntT>::type wide_type;
+
+	if constexpr (!std::is_same<wide_type, IntT>::value) {
+		wide_type const r = (wide_type(a) * d - wide_type(b) * c) / e;
+		if (!fits<IntT>(r))
+			throw std::overflow_error("Rational overflow.");
+		return static_cast<IntT>(r);
+	} else {
+		IntT p = 0, q = 0, r = 0;
+		if (mul_overflow(a, d, p) || mul_overflow(b, c, q) ||
+		    sub_overflow(p, q, r))
+			throw std::overflow_error("Rational overflow.");
+		return r / e;
+	}
+}
+
+/**
+ * @brief Bareiss' fraction-free elimination of the n x width integer
+ * matrix m to upper triangular form, in place, over the first n columns.
+ *
+ * Each step replaces m(i, j) by (m(k, k) m(i, j) - m(i, k) m(k, j)) /
+ * m(k - 1, k - 1); the division is exact, so entries stay integers no
+ * larger than the minors of the input and no gcd is needed. The rows of a
+ * step are independent and are updated in parallel. Returns the sign of
+ * the row permutation, or 0 if the matrix is singular.
+ */
+template<typename IntT>
+int bareiss(vector<IntT>& m, size_t n, size_t width, thread_pool& pool)
+{
+	IntT* const a = m.data();
+	IntT prev = 1;
+	int sign = 1;
+
+	for (size_t k = 0; k != n; ++k) {
+		size_t p = k;
+		while (p != n && a[p * width + k] == IntT(0))
+			++p;
+		if (p == n)
+			return 0;
+		if (p != k) {
+			for (size_t j = k; j != width; ++j) {
+				IntT const t = a[k * width + j];
+				a[k * width + j] = a[p * width + j];
+				a[p * width + j] = t;
+			}
+			sign = -sign;
+		}
+
+		IntT const pivot = a[k * width + k];
+		size_t const grain = 4096 / (width - k) + 1;
+		pool.parallel_for(k + 1, n, [&](size_t lo, size_t hi) {
+			const IntT* const top = a + k * width;
+			for (size_t i = lo; i != hi; ++i) {
+				IntT* const row = a + i * width;
+				IntT const factor = row[k];
+				for (size_t j = k + 1; j != width; ++j)
+					row[j] = bareiss_update(pivot, row[j],
+								factor, top[j],
+								prev);
+				row[k] = IntT(0);
+			}
+		}, grain);
+		prev = pivot;
+	}
+	return sign;
+}
+
+} // namespace detail
+
+/**
+ *  @brief  The determinant of a square rational matrix.
+ *
+ *  The rows are scaled to integers and reduced by Bareiss' fraction-free
+ *  elimination; the determinant is the last pivot divided by the scales.
+ *  Intermediate integers that leave IntT throw std::overflow_error.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+rational_t<IntT, OverflowPolicy, NormalizationPolicy>
+determinant(matrix<rational_t<IntT, OverflowPolicy,
+			      NormalizationPolicy> > const& a,
+	    thread_pool& pool = default_thread_pool())
+{
+	typedef rational_t<IntT, OverflowPolicy, NormalizationPolicy> rational;
+
+	if (a.rows() != a.cols())
+		throw std::invalid_argument("Matrix must be square.");
+	size_t const n = a.rows();
+	if (!n)
+		return rational(IntT(1), IntT(1));
+
+	vector<IntT> m(n * n, IntT(0)), scales(n, IntT(1));
+	detail::scale_rows(a, static_cast<const rational*>(nullptr), m, n,
+			   scales);
+	int const sign = detail::bareiss(m, n, n, pool);
+	if (!sign)
+		return rational();
+
+	rational result(m.data()[n * n - 1], IntT(1));
+	for (size_t i = 0; i != n; ++i)
+		result /= rational(scales.data()[i], IntT(1));
+	// the last pivot may be the most negative IntT: negate the quotient,
+	// through OverflowPolicy
+	return sign < 0 ? -result : result;
+}
+
+/**
+ *  @brief  Stores in x the solution of a x = b for a square, non-singular a.
+ *
+ *  The augmented matrix [a | b] is scaled to integers and brought to upper
+ *  triangular form by Bareiss' elimination; x follows by rational back
+ *  substitution, or for unbounded components by integer back substitution
+ *  of the numerators over the last pivot. Throws std::invalid_argument if
+ *  a is singular.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+void solve(matrix<rational_t<IntT, OverflowPolicy,
+			     NormalizationPolicy> > const& a,
+	   vector<rational_t<IntT, OverflowPolicy,
+			     NormalizationPolicy> > const& b,
+	   vector<rational_t<IntT, OverflowPolicy, NormalizationPolicy> >& x,
+	   thread_pool& pool = default_thread_pool())
+{
+	typedef rational_t<IntT, OverflowPolicy, NormalizationPolicy> rational;
+
+	if (a.rows() != a.cols())
+		throw std::invalid_argument("Matrix must be square.");
+	if (b.size() != a.rows())
+		throw std::invalid_argument("Matrix sizes don't match.");
+	size_t const n = a.rows();
+	if (!n) {
+		x.clear();
+		return;
+	}
+
+	size_t const width = n + 1;
+	vector<IntT> m(n * width, IntT(0)), scales(n, IntT(1));
+	detail::scale_rows(a, b.data(), m, width, scales);
+	if (!detail::bareiss(m, n, width, pool))
+		throw std::invalid_argument("Matrix is singular.");
+
+	const IntT* const u = m.data();
+	vector<rational> result(n);
+	if constexpr (std::numeric_limits<IntT>::is_bounded) {
+		for (size_t i = n; i-- != 0;) {
+			rational sum(u[i * width + n], IntT(1));
+			for (size_t j = i + 1; j != n; ++j)
+				if (u[i * width + j] != IntT(0))
+					sum -= result.data()[j] * u[i * width + j];
+			result.data()[i] = sum / u[i * width + i];
+		}
+	} else {
+		// by Cramer's rule x = y / d for the last pivot d and integers
+		// y, so the back substitution divides exactly and only the
+		// results are reduced
+		IntT const& d = u[n * width - 2];
+		vector<IntT> y(n, IntT(0));
+		for (size_t i = n; i-- != 0;) {
+			IntT sum = d * u[i * width + n];
+			for (size_t j = i + 1; j != n; ++j)
+				if (u[i * width + j] != IntT(0))
+					sum -= u[i * width + j] * y.data()[j];
+			y.data()[i] = sum / u[i * width + i];
+			result.data()[i] = rational(y.data()[i], d);
+		}
+	}
+	x = std::move(result);
+}
+
+} // namespace lab
+
+#endif // MATRIX_H
@@ -0,0 +1,210 @@
+#ifndef OVERFLOW_H
+#define OVERFLOW_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>            // std::overflow_error
+#include <type_traits>
+
+namespace lab {
+
+namespace detail {
+
+// std::is_integral, extended to __int128 in strict ISO modes.
+template<typename T>
+struct is_builtin_integer : std::is_integral<T> {};
+#ifdef __SIZEOF_INT128__
+template<>
+struct is_builtin_integer<__int128> : std::true_type {};
+template<>
+struct is_builtin_integer<unsigned __int128> : std::true_type {};
+#endif
+
+template<size_t Bytes>
+struct int_of_size { typedef void type; };
+template<>
+struct int_of_size<2> { typedef std::int16_t type; };
+template<>
+struct int_of_size<4> { typedef std::int32_t type; };
+template<>
+struct int_of_size<8> { typedef std::int64_t type; };
+#ifdef __SIZEOF_INT128__
+template<>
+struct int_of_size<16> { typedef __int128 type; };
+#endif
+
+#ifdef __SIZEOF_INT128__
+typedef __int128 widest_int;
+typedef unsigned __int128 widest_uint;
+#else
+typedef long long widest_int;
+typedef unsigned long long widest_uint;
+#endif
+
+} // namespace detail
+
+/**
+ * @brief widen<IntT>::type is a signed integer twice as wide as IntT
+ * (int8 -> int16, ..., int64 -> __int128), or IntT itself when there is no
+ * wider built-in type.
+ *
+ * A product of two IntT values always fits into the widened type, so the
+ * overflow checks below compile away when a wider type exists.
+ */
+template<typename IntT, typename = void>
+struct widen { typedef IntT type; };
+
+template<typename IntT>
+struct widen<IntT, typename std::enable_if<
+	detail::is_builtin_integer<IntT>::value &&
+	!std::is_void<typename detail::int_of_size<2 * sizeof(IntT)>::type>::value
+	>::type>
+{
+	typedef typename detail::int_of_size<2 * sizeof(IntT)>::type type;
+};
+
+namespace detail {
+
+// r = a op b; return true if the exact result did not fit into T, in which
+// case r holds the wrapped value. Types without a fixed width never
+// overflow.
+template<typename T>
+constexpr bool add_overflow(T a, T b, T& r) noexcept
+{
+	if constexpr (is_builtin_integer<T>::value) {
+		return __builtin_add_overflow(a, b, &r);
+	} else {
+		r = a + b;
+		return false;
+	}
+}
+
+template<typename T>
+constexpr bool sub_overflow(T a, T b, T& r) noexcept
+{
+	if constexpr (is_builtin_integer<T>::value) {
+		return __builtin_sub_overflow(a, b, &r);
+	} else {
+		r = a - b;
+		return false;
+	}
+}
+
+template<typename T>
+constexpr bool mul_overflow(T a, T b, T& r) noexcept
+{
+	if constexpr (is_builtin_integer<T>::value) {
+		return __builtin_mul_overflow(a, b, &r);
+	} else {
+		r = a * b;
+		return false;
+	}
+}
+
+// true if x is representable as IntT
+template<typename IntT, typename WideT>
+constexpr bool fits(WideT x) noexcept
+{
+	if constexpr (!std::numeric_limits<IntT>::is_bounded ||
+		      std::is_same<IntT, WideT>::value ||
+		      (std::numeric_limits<IntT>::is_signed ==
+		       std::numeric_limits<WideT>::is_signed &&
+		       std::numeric_limits<IntT>::digits >=
+		       std::numeric_limits<WideT>::digits)) {
+		// also a narrower x, e.g. a std::ratio for __int128
+		return true;
+	} else {
+		return x >= static_cast<WideT>(std::numeric_limits<IntT>::min())
+		    && x <= static_cast<WideT>(std::numeric_limits<IntT>::max());
+	}
+}
+
+// true if the integer k is representable as IntT, for any signedness
+template<typename IntT, typename I>
+constexpr bool in_range(I k) noexcept
+{
+	if constexpr (!std::numeric_limits<IntT>::is_bounded) {
+		return true;
+	} else {
+		if (k < I(0))
+			return static_cast<widest_int>(k) >= static_cast<widest_int>(
+					std::numeric_limits<IntT>::min());
+		return static_cast<widest_uint>(k) <= static_cast<widest_uint>(
+				std::numeric_limits<IntT>::max());
+	}
+}
+
+} // namespace detail
+
+// Overflow policies of rational_t.
+//
+// When the exact reduced result of an operation does not fit into the
+// component type, rational_t calls Policy::on_overflow<Rational>(value,
+// num, den) with an approximation of the exact value and the (possibly
+// wrapped) wide numerator and denominator, and returns what it returns.
+
+/**
+ * @brief Report the overflow by throwing std::overflow_error.
+ */
+struct overflow_throw {
+	template<typename Rational, typename WideT>
+	static constexpr Rational on_overflow(long double, WideT, WideT)
+	{
+		throw std::overflow_error("Rational overflow.");
+	}
+};
+
+/**
+ * @brief Clamp the result to [-max / 1, max / 1]; values inside the range
+ * are rounded to the nearest k / q with the largest q keeping k in range.
+ */
+struct overflow_saturate {
+	template<typename Rational, typename WideT>
+	static Rational on_overflow(long double value, WideT, WideT)
+	{
+		typedef typename Rational::int_type int_type;
+
+		int_type const max = std::numeric_limits<int_type>::max();
+		long double const max_ld = static_cast<long double>(max);
+		if (value >= max_ld)
+			return Rational(max, 1);
+		if (value <= -max_ld)
+			return Rational(-max, 1);
+
+		long double const q = std::fabs(value) < 1 ? max_ld
+				      : std::floor(max_ld / std::fabs(value));
+		long double const k = std::round(value * q);
+		int_type const denom = q >= max_ld ? max
+				       : static_cast<int_type>(q);
+		int_type const num = k >= max_ld ? max
+				     : k <= -max_ld ? -max
+				     : static_cast<int_type>(k);
+		return Rational(num, denom);
+	}
+};
+
+/**
+ * @brief No check: keep the low bits of the exact components, like plain
+ * integer arithmetic does. A wrapped zero denominator still throws
+ * std::invalid_argument, and one that wraps to the most negative value,
+ * which has no positive counterpart, std::overflow_error.
+ */
+struct overflow_wrap {
+	template<typename Rational, typename WideT>
+	static constexpr Rational on_overflow(long double, WideT num,
+					      WideT den)
+	{
+		typedef typename Rational::int_type int_type;
+
+		int_type const denom = static_cast<int_type>(den);
+		if (std::numeric_limits<int_type>::is_signed &&
+		    denom == std::numeric_limits<int_type>::min())
+			throw std::overflow_error("Rational overflow.");
+		return Rational(static_cast<int_type>(num), denom);
+	}
+};
+
+} // namespace lab
+
+#endif // OVERFLOW_H
@@ -0,0 +1,364 @@
+#ifndef PACKED_RATIONAL_H
+#define PACKED_RATIONAL_H
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "aligned_allocator.h"
+#include "overflow.h"
+#include "rational.h"
+#include "vector.h"
+
+namespace lab {
+
+/**
+ * @brief packed_rational stores a reduced rational_t<IntT> whose
+ * components fit half of IntT in one unsigned word as wide as IntT: the
+ * numerator in the low half (two's complement) and the denominator minus
+ * one in the high half, below a spill flag.
+ *
+ * The footprint is half that of rational_t<IntT>, so twice as many values
+ * fit into a cache line: 8 bytes instead of 16 for long long, 4 instead
+ * of 8 for int. Numerators in [-2^(h-1), 2^(h-1)) and denominators up to
+ * 2^(h-1) fit, for h half the bits of IntT. A value is a single integer:
+ * loads, stores and tests for equality are one word wide. The all-zero
+ * word is 0 / 1, so zero-filled memory is an array of zeros. Packing and
+ * unpacking are a shift, a mask and an increment, without branches.
+ *
+ * A word with the spill flag set holds no value but the index of one
+ * that did not fit, in the table of its packed_rational_vector.
+ */
+template<typename IntT>
+class packed_rational {
+public:
+	typedef IntT					int_type;
+	typedef typename std::make_unsigned<IntT>::type	word_type;
+	typedef rational_t<IntT>			value_type;
+private:
+	static_assert(detail::is_builtin_integer<IntT>::value &&
+		      std::is_signed<IntT>::value &&
+		      sizeof(IntT) >= 2 && sizeof(IntT) <= 8,
+		      "Signed built-in components of 16 to 64 bits required.");
+
+	typedef typename std::conditional<sizeof(IntT) == 2, std::int8_t,
+		typename detail::int_of_size<sizeof(IntT) / 2>::type>::type
+		half_type;
+	typedef typename std::make_unsigned<half_type>::type uhalf_type;
+	static constexpr int half_bits = 4 * sizeof(IntT);
+	static constexpr word_type spill_flag =
+		static_cast<word_type>(word_type(1) << (2 * half_bits - 1));
+
+	word_type word_;
+public:
+	// the number of spilled values a word can index
+	static constexpr size_t max_spills = spill_flag;
+
+	// true if the reduced num / denom packs into one word; num is biased
+	// to an unsigned half and denom - 1 must leave the flag bit clear
+	static constexpr bool fits(IntT num, IntT denom) noexcept
+	{
+		word_type const biased = static_cast<word_type>(
+			static_cast<word_type>(num)
+			+ (word_type(1) << (half_bits - 1)));
+		word_type const denom_1 = static_cast<word_type>(
+			static_cast<word_type>(denom) - 1);
+		return !(biased >> half_bits) & !(denom_1 >> (half_bits - 1));
+	}
+	static constexpr word_type pack(IntT num, IntT denom) noexcept
+	{
+		return static_cast<word_type>(static_cast<uhalf_type>(num))
+		       | static_cast<word_type>(static_cast<word_type>(
+				static_cast<uhalf_type>(denom - 1)) << half_bits);
+	}
+	static constexpr IntT num(word_type word) noexcept
+	{
+		half_type const half = static_cast<uhalf_type>(word);
+		return static_cast<IntT>(half);
+	}
+	static constexpr IntT denom(word_type word) noexcept
+	{
+		IntT const denom_1 = static_cast<uhalf_type>(word >> half_bits);
+		return static_cast<IntT>(denom_1 + 1);
+	}
+
+	static constexpr bool spilled(word_type word) noexcept
+	{
+		return (word & spill_flag) != 0;
+	}
+	static constexpr word_type spill(size_t index) noexcept
+	{
+		return static_cast<word_type>(spill_flag | index);
+	}
+	static constexpr size_t spill_index(word_type word) noexcept
+	{
+		return static_cast<size_t>(word & ~spill_flag);
+	}
+
+	constexpr packed_rational() noexcept : word_(0) {}
+	/**
+	 *  @brief  Packs a number; throws std::overflow_error if its reduced
+	 *  components do not fit.
+	 */
+	template <typename OverflowPolicy, typename NormalizationPolicy>
+	constexpr packed_rational(rational_t<IntT, OverflowPolicy,
+				  NormalizationPolicy> const& number)
+		: word_(0)
+	{
+		auto const reduced = number.normalized();
+		if (!fits(reduced.num(), reduced.denom()))
+			throw std::overflow_error("Rational overflow.");
+		word_ = pack(reduced.num(), reduced.denom());
+	}
+
+	static constexpr packed_rational from_word(word_type word) noexcept
+	{
+		packed_rational result;
+		result.word_ = word;
+		return result;
+	}
+	constexpr word_type word() const noexcept { return word_; }
+
+	constexpr IntT num() const noexcept { return num(word_); }
+	constexpr IntT denom() const noexcept { return denom(word_); }
+
+	constexpr value_type unpack() const noexcept
+	{
+		return detail::rational_access::make<value_type>(num(), denom());
+	}
+	constexpr operator value_type() const noexcept { return unpack(); }
+
+	// reduced forms are unique, so equal values have equal words
+	friend constexpr bool operator==(packed_rational const& lhs,
+					 packed_rational const& rhs) noexcept
+	{
+		return lhs.word_ == rhs.word_;
+	}
+	friend constexpr bool operator!=(packed_rational const& lhs,
+					 packed_rational const& rhs) noexcept
+	{
+		return lhs.word_ != rhs.word_;
+	}
+
+	friend inline std::ostream& operator<<(std::ostream& os,
+					       packed_rational const& number)
+	{
+		return os << number.unpack();
+	}
+};
+
+/**
+ * @brief packed_rational_vector is a sequence of rational numbers stored
+ * as packed_rational words in one cache-line aligned array.
+ *
+ * Numbers that do not fit a word go to a table of rational_t<IntT>, and
+ * their word holds its index with the spill flag set. A number is packed
+ * whenever it fits, so a word is equal to the word of a number that fits
+ * exactly when the values are equal. Overwriting a spilled number with
+ * one that fits leaves its table entry unused until clear().
+ */
+template<typename IntT = int>
+class packed_rational_vector {
+public:
+	typedef size_t					size_type;
+	typedef rational_t<IntT>			value_type;
+	typedef packed_rational<IntT>			packed_type;
+	typedef typename packed_type::word_type		word_type;
+	typedef aligned_allocator<word_type>		allocator_type;
+	typedef vector<word_type, allocator_type>	storage_type;
+
+	/**
+	 * @brief Proxy returned by the non-const subscript: reads and writes
+	 * one word, and the table for numbers that do not fit.
+	 */
+	class reference {
+		packed_rational_vector& vec;
+		size_type pos;
+
+		friend class packed_rational_vector;
+		reference(packed_rational_vector& v, size_type p) noexcept
+			: vec(v), pos(p) {}
+	public:
+		operator value_type() const
+		{
+			return vec.load(vec.words.data()[pos]);
+		}
+		reference& operator=(value_type const& value)
+		{
+			word_type& word = vec.words.data()[pos];
+			word = vec.store(value, word);
+			return *this;
+		}
+		// copies the value: a table entry belongs to one word
+		reference& operator=(reference const& other)
+		{
+			return *this = static_cast<value_type>(other);
+		}
+	};
+private:
+	storage_type words;
+	std::vector<value_type> spills;
+
+	value_type load(word_type word) const
+	{
+		if (packed_type::spilled(word))
+			return spills[packed_type::spill_index(word)];
+		return packed_type::from_word(word).unpack();
+	}
+
+	// the word for value, reusing the table entry of old if it has one
+	word_type store(value_type const& value, word_type old)
+	{
+		if (packed_type::fits(value.num(), value.denom()))
+			return packed_type::pack(value.num(), value.denom());
+		if (packed_type::spilled(old)) {
+			size_type const index = packed_type::spill_index(old);
+			spills[index] = value;
+			return old;
+		}
+		if (spills.size() == packed_type::max_spills)
+			throw std::length_error("Too many spilled numbers.");
+		spills.push_back(value);
+		return packed_type::spill(spills.size() - 1);
+	}
+public:
+	/**
+	 * @brief Returns the number of elements in the container
+	 */
+	size_type size() const noexcept { return words.size(); }
+	size_type capacity() const noexcept { return words.capacity(); }
+	bool empty() const noexcept { return words.empty(); }
+
+	/**
+	 * @brief Returns the number of table entries for numbers that do
+	 * not fit a word, including unused ones.
+	 */
+	size_type spill_count() const noexcept { return spills.size(); }
+
+	/**
+	 *  @brief  Creates a %packed_rational_vector with no elements.
+	 */
+	packed_rational_vector() {}
+
+	/**
+	 *  @brief  Creates a %packed_rational_vector with n zeros.
+	 */
+	explicit packed_rational_vector(size_type n) : words(n, word_type(0)) {}
+
+	/**
+	 *  @brief  Packs a vector of rational numbers.
+	 */
+	explicit packed_rational_vector(vector<value_type> const& vec)
+	{
+		reserve(vec.size());
+		for (size_type i = 0; i != vec.size(); ++i)
+			push_back(vec.data()[i]);
+	}
+
+	void reserve(size_type new_capacity)
+	{
+		if (new_capacity > capacity())
+			words.reserve(new_capacity);
+	}
+
+	void clear()
+	{
+		words.clear();
+		spills.clear();
+	}
+
+	/**
+	 *  @brief  Add a rational number to the end of the vector.
+	 */
+	void push_back(value_type const& value)
+	{
+		words.push_back(store(value, word_type(0)));
+	}
+
+	void pop_back()
+	{
+		if (empty())
+			return;
+		word_type const word = words.data()[size() - 1];
+		if (packed_type::spilled(word)
+		    && packed_type::spill_index(word) + 1 == spills.size())
+			spills.pop_back();
+		words.pop_back();
+	}
+
+	/**
+	 *  @brief  Subscript access to the data contained in the vector.
+	 *  @param pos The index of the element.
+	 *  @return  A proxy in the non-const case, a copy otherwise.
+	 */
+	reference operator[](size_type pos) noexcept(false)
+	{
+		if (pos >= size()) throw std::out_of_range("No such element.");
+		return reference(*this, pos);
+	}
+	value_type operator[](size_type pos) const noexcept(false)
+	{
+		if (pos >= size()) throw std::out_of_range("No such element.");
+		return load(words.data()[pos]);
+	}
+
+	/**
+	 * Returns the aligned words; [data(), data() + size()) is a valid
+	 * range. Words written through data() must hold reduced numbers
+	 * that fit, or the index of an entry of this vector's table.
+	 */
+	word_type* data() noexcept { return words.data(); }
+	const word_type* data() const noexcept { return words.data(); }
+
+	/**
+	 * @brief print: Print all elements of the vector using std::cout
+	 */
+	void print() const
+	{
+		for (size_type i = 0; i != size(); i++)
+			std::cout << operator[](i) << "; ";
+		std::cout << "\n";
+	}
+};
+
+namespace batch {
+
+/**
+ * @brief Packs the columns num[i] / denom[i] (reduced, denom > 0, as stored
+ * by rational_soa_vector) into out[i] for i in [0, n). Returns false if
+ * some number does not fit a word; its word is then meaningless.
+ *
+ * The loop has no branches and vectorizes.
+ */
+template<typename IntT>
+bool pack(const IntT* num, const IntT* denom,
+	  typename packed_rational<IntT>::word_type* out, size_t n) noexcept
+{
+	bool all_fit = true;
+	for (size_t i = 0; i != n; ++i) {
+		all_fit &= packed_rational<IntT>::fits(num[i], denom[i]);
+		out[i] = packed_rational<IntT>::pack(num[i], denom[i]);
+	}
+	return all_fit;
+}
+
+/**
+ * @brief Splits the words in[i], none of them spilled, into the columns
+ * num[i] and denom[i].
+ */
+template<typename IntT>
+void unpack(const typename packed_rational<IntT>::word_type* in,
+	    IntT* num, IntT* denom, size_t n) noexcept
+{
+	for (size_t i = 0; i != n; ++i) {
+		num[i] = packed_rational<IntT>::num(in[i]);
+		denom[i] = packed_rational<IntT>::denom(in[i]);
+	}
+}
+
+} // namespace batch
+
+} // namespace lab
+
+#endif // PACKED_RATIONAL_H
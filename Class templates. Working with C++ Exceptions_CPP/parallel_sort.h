@@ -0,0 +1,299 @@
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "distribute.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+namespace lab {
+
+namespace detail {
+
+enum : size_t {
+	insertion_cutoff = 16,		// shorter ranges: insertion sort
+	parallel_sort_cutoff = 1 << 15,	// shorter arrays: one thread
+	sort_grain = 1 << 14,		// elements per parallel chunk
+	oversampling = 32		// samples per bucket
+};
+
+template<typename T>
+void insertion_sort(T* first, T* last)
+{
+	if (last - first < 2)
+		return;
+	for (T* i = first + 1; i != last; ++i) {
+		T value = std::move(*i);
+		T* j = i;
+		for (; j != first && value < *(j - 1); --j)
+			*j = std::move(*(j - 1));
+		*j = std::move(value);
+	}
+}
+
+/**
+ * @brief Quicksort with a median-of-three pivot and Hoare's partition,
+ * recursing into the smaller part only; short ranges are finished by
+ * insertion sort and, after depth bad splits, a heap sort bounds the
+ * worst case.
+ */
+template<typename T>
+void quick_sort(T* first, T* last, int depth)
+{
+	while (last - first > static_cast<ptrdiff_t>(insertion_cutoff)) {
+		if (depth-- == 0) {
+			std::make_heap(first, last);
+			std::sort_heap(first, last);
+			return;
+		}
+
+		T* const mid = first + (last - first - 1) / 2;
+		if (*mid < *first)
+			std::swap(*mid, *first);
+		if (*(last - 1) < *mid) {
+			std::swap(*(last - 1), *mid);
+			if (*mid < *first)
+				std::swap(*mid, *first);
+		}
+		T const pivot = *mid;
+
+		// [first, j] <= pivot <= (j, last)
+		T* i = first - 1;
+		T* j = last;
+		for (;;) {
+			do ++i; while (*i < pivot);
+			do --j; while (pivot < *j);
+			if (i >= j)
+				break;
+			std::swap(*i, *j);
+		}
+		++j;
+		if (j - first < last - j) {
+			quick_sort(first, j, depth);
+			first = j;
+		} else {
+			quick_sort(j, last, depth);
+			last = j;
+		}
+	}
+	insertion_sort(first, last);
+}
+
+template<typename T>
+void quick_sort(T* first, T* last)
+{
+	int depth = 0;
+	for (ptrdiff_t n = last - first; n > 1; n >>= 1)
+		depth += 2;
+	quick_sort(first, last, depth);
+}
+
+// k-way merge of the sorted ranges [begin[s], end[s]) into out, by a heap
+// of the range heads: the head taken from the top is replaced by the next
+// element of its range and sifted down, one pass per element
+template<typename T>
+void multiway_merge(std::vector<std::pair<const T*, const T*> >& ranges,
+		    T* out)
+{
+	typedef std::pair<const T*, const T*> range;
+	auto const later = [](range const& a, range const& b) {
+		return *b.first < *a.first;
+	};
+
+	ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+				    [](range const& r) {
+					    return r.first == r.second;
+				    }), ranges.end());
+	std::make_heap(ranges.begin(), ranges.end(), later);
+	range* const heap = ranges.data();
+	size_t size = ranges.size();
+	while (size > 1) {
+		*out++ = *heap[0].first++;
+		if (heap[0].first == heap[0].second)
+			heap[0] = heap[--size];
+
+		range const top = heap[0];
+		size_t i = 0;
+		for (size_t child = 1; child < size; child = 2 * i + 1) {
+			if (child + 1 < size && later(heap[child],
+						      heap[child + 1]))
+				++child;
+			if (!later(top, heap[child]))
+				break;
+			heap[i] = heap[child];
+			i = child;
+		}
+		heap[i] = top;
+	}
+	if (size)
+		std::copy(heap[0].first, heap[0].second, out);
+}
+
+} // namespace detail
+
+/**
+ *  @brief  Sorts first[0], ..., first[n - 1] in ascending order by
+ *  operator<, on pool.
+ *
+ *  A sample sort: splitters drawn from a sorted sample cut the value range
+ *  into a few buckets per thread. The elements are counted and scattered
+ *  into their buckets chunk by chunk in parallel by detail::distribute(),
+ *  the pass of radix_sort(), and the buckets are then sorted in parallel
+ *  by quicksort. The work-stealing
+ *  pool balances buckets of uneven size. Takes a buffer of n elements;
+ *  short arrays and pools without workers sort on the calling thread.
+ */
+template<typename T>
+void parallel_sort(T* first, size_t n,
+		   thread_pool& pool = default_thread_pool())
+{
+	if (n < detail::parallel_sort_cutoff || !pool.size()) {
+		detail::quick_sort(first, first + n);
+		return;
+	}
+
+	size_t const buckets = 4 * (pool.size() + 1);
+	size_t const samples = buckets * detail::oversampling;
+	vector<T> sample(samples);
+	for (size_t i = 0; i != samples; ++i)
+		sample.data()[i] = first[(2 * i + 1) * n / (2 * samples)];
+	detail::quick_sort(sample.data(), sample.data() + samples);
+	// splitter b - 1 is the lower bound of bucket b
+	const T* const splitters = sample.data();
+	for (size_t b = 1; b != buckets; ++b)
+		sample.data()[b - 1] =
+			sample.data()[b * detail::oversampling];
+	auto const bucket = [splitters, buckets](T const& x) {
+		return static_cast<size_t>(
+			std::upper_bound(splitters, splitters + buckets - 1,
+					 x) - splitters);
+	};
+
+	vector<size_t> begin(buckets + 1, size_t(0));
+	vector<T> buffer(n);
+	T* const out = buffer.data();
+	if (!detail::distribute(first, out, n, bucket, buckets,
+				detail::sort_grain, pool, begin.data())) {
+		// a single bucket: nothing to split
+		detail::quick_sort(first, first + n);
+		return;
+	}
+
+	const size_t* const b = begin.data();
+	pool.parallel_for(0, buckets, [&](size_t lo, size_t hi) {
+		for (size_t k = lo; k != hi; ++k) {
+			detail::quick_sort(out + b[k], out + b[k + 1]);
+			std::copy(out + b[k], out + b[k + 1], first + b[k]);
+		}
+	});
+}
+
+template<typename T>
+void parallel_sort(vector<T>& vec, thread_pool& pool = default_thread_pool())
+{
+	parallel_sort(vec.data(), vec.size(), pool);
+}
+
+/**
+ *  @brief  Merges the k sorted ranges [first[s], first[s] + size[s]) into
+ *  out, which must hold their total size, on pool.
+ *
+ *  Splitters sampled from the ranges cut every range by binary search
+ *  into parts of about the same total size; the parts are independent
+ *  k-way merges written to consecutive slices of out, in parallel.
+ */
+template<typename T>
+void parallel_merge(const T* const* first, const size_t* size, size_t k,
+		    T* out, thread_pool& pool = default_thread_pool())
+{
+	typedef std::pair<const T*, const T*> range;
+
+	size_t total = 0;
+	for (size_t s = 0; s != k; ++s)
+		total += size[s];
+	size_t parts = total / detail::parallel_sort_cutoff;
+	if (parts > 4 * (pool.size() + 1))
+		parts = 4 * (pool.size() + 1);
+	if (parts <= 1 || !pool.size()) {
+		std::vector<range> ranges;
+		for (size_t s = 0; s != k; ++s)
+			ranges.push_back(range(first[s], first[s] + size[s]));
+		detail::multiway_merge(ranges, out);
+		return;
+	}
+
+	// samples in proportion to the size of each range, at least one from
+	// each range that is not empty
+	size_t const samples = parts * detail::oversampling;
+	std::vector<T> sample;
+	sample.reserve(samples + k);
+	for (size_t s = 0; s != k; ++s) {
+		size_t const count = size[s] && size[s] * samples < total
+				     ? 1 : size[s] * samples / total;
+		for (size_t i = 0; i != count; ++i)
+			sample.push_back(
+				first[s][(2 * i + 1) * size[s] / (2 * count)]);
+	}
+	std::sort(sample.begin(), sample.end());
+
+	// cut[p * k + s]: where part p starts in range s
+	std::vector<size_t> cut((parts + 1) * k);
+	for (size_t s = 0; s != k; ++s) {
+		cut[s] = 0;
+		cut[parts * k + s] = size[s];
+	}
+	for (size_t p = 1; p != parts; ++p) {
+		T const& splitter = sample[p * sample.size() / parts];
+		for (size_t s = 0; s != k; ++s)
+			cut[p * k + s] = static_cast<size_t>(
+				std::lower_bound(first[s], first[s] + size[s],
+						 splitter) - first[s]);
+	}
+
+	pool.parallel_for(0, parts, [&](size_t lo, size_t hi) {
+		std::vector<range> ranges;
+		for (size_t p = lo; p != hi; ++p) {
+			size_t offset = 0;
+			ranges.clear();
+			for (size_t s = 0; s != k; ++s) {
+				offset += cut[p * k + s];
+				ranges.push_back(range(
+					first[s] + cut[p * k + s],
+					first[s] + cut[(p + 1) * k + s]));
+			}
+			detail::multiway_merge(ranges, out + offset);
+		}
+	});
+}
+
+/**
+ *  @brief  Merges the k sorted vectors sequences[0], ..., sequences[k - 1]
+ *  into out, which is resized to match.
+ */
+template<typename T>
+void parallel_merge(vector<T> const* sequences, size_t k, vector<T>& out,
+		    thread_pool& pool = default_thread_pool())
+{
+	std::vector<const T*> first;
+	std::vector<size_t> size;
+	size_t total = 0;
+	for (size_t s = 0; s != k; ++s) {
+		first.push_back(sequences[s].data());
+		size.push_back(sequences[s].size());
+		total += sequences[s].size();
+	}
+	if (!total) {
+		out.clear();
+		return;
+	}
+	if (out.size() != total)
+		out = vector<T>(total);
+	parallel_merge(first.data(), size.data(), k, out.data(), pool);
+}
+
+} // namespace lab
+
+#endif // PARALLEL_SORT_H
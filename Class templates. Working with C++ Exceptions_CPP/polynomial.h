@@ -0,0 +1,338 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+
+#include "floating.h"
+#include "gcd.h"
+#include "overflow.h"
+#include "rational.h"
+#include "rational_soa_vector.h"
+#include "vector.h"
+
+namespace lab {
+
+/**
+ * @brief polynomial is a polynomial in one variable with coefficients of
+ * type T, lowest degree first.
+ *
+ * Trailing zero coefficients are dropped, so the zero polynomial has no
+ * coefficients and degree 0.
+ */
+template<typename T>
+class polynomial {
+public:
+	typedef size_t		size_type;
+	typedef T		value_type;
+private:
+	vector<T> coeffs;
+
+	void trim()
+	{
+		T const zero = T();
+		while (!coeffs.empty() &&
+		       coeffs.data()[coeffs.size() - 1] == zero)
+			coeffs.pop_back();
+	}
+public:
+	/**
+	 *  @brief  Creates the zero polynomial.
+	 */
+	polynomial() {}
+
+	/**
+	 *  @brief  Creates c[0] + c[1] x + ... + c[n - 1] x^(n - 1).
+	 */
+	explicit polynomial(vector<T> const& c) : coeffs(c)
+	{
+		trim();
+	}
+	polynomial(std::initializer_list<T> const& c) : coeffs(c)
+	{
+		trim();
+	}
+
+	/**
+	 * @brief Returns the number of coefficients, degree() + 1 unless the
+	 * polynomial is zero.
+	 */
+	size_type size() const noexcept { return coeffs.size(); }
+	size_type degree() const noexcept
+	{
+		return coeffs.empty() ? 0 : coeffs.size() - 1;
+	}
+	bool is_zero() const noexcept { return coeffs.empty(); }
+
+	/**
+	 *  @brief  The coefficient of x^k, zero beyond the degree.
+	 */
+	T operator[](size_type k) const
+	{
+		return k < coeffs.size() ? coeffs.data()[k] : T();
+	}
+
+	/**
+	 * Returns the coefficients; [data(), data() + size()) is a valid
+	 * range.
+	 */
+	const T* data() const noexcept { return coeffs.data(); }
+
+	/**
+	 *  @brief  The value at x, by Horner's scheme.
+	 */
+	T operator()(T const& x) const
+	{
+		if (coeffs.empty())
+			return T();
+		T result = coeffs.data()[coeffs.size() - 1];
+		for (size_type k = coeffs.size() - 1; k-- != 0;)
+			result = result * x + coeffs.data()[k];
+		return result;
+	}
+
+	friend bool operator==(polynomial const& lhs, polynomial const& rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+		for (size_type k = 0; k != lhs.size(); ++k)
+			if (!(lhs.coeffs.data()[k] == rhs.coeffs.data()[k]))
+				return false;
+		return true;
+	}
+	friend bool operator!=(polynomial const& lhs, polynomial const& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	friend inline std::ostream& operator<<(std::ostream& os,
+					       polynomial const& p)
+	{
+		if (p.is_zero())
+			return os << T();
+		for (size_type k = p.size(); k-- != 0;) {
+			os << "(" << p.coeffs.data()[k] << ")";
+			if (k)
+				os << " x^" << k << " + ";
+		}
+		return os;
+	}
+
+	/**
+	 * @brief print: Print the polynomial using std::cout
+	 */
+	void print() const
+	{
+		std::cout << *this << "\n";
+	}
+};
+
+namespace batch {
+
+namespace detail {
+
+// Horner's scheme for many points over one common denominator.
+//
+// With the coefficients scaled to integers A[k] by the lcm L of their
+// denominators, the value at u / v is
+//
+//	(A[d] u^d + A[d - 1] u^(d - 1) v + ... + A[0] v^d) / (L v^d),
+//
+// and the numerator is a Horner recurrence on integers:
+// h = h u + A[k] v^(d - k). Each point costs 3 multiplications per
+// degree and a single gcd at the end, instead of a rational
+// multiplication and addition, each with its gcd, per degree.
+//
+// Every partial h is below (|A[0]| + ... + |A[d]|) max(|u|, v)^d, so a
+// point whose bound, counted in bits, fits the wide type is evaluated
+// without overflow checks: the recurrence runs on the unsigned wide type,
+// lane by lane over a block of points, and vectorizes. The other points,
+// and results that do not fit IntT once reduced, are evaluated by the
+// rational_t operators and so by their overflow policy.
+template<typename IntT>
+struct horner_kernel {
+	typedef typename widen<IntT>::type			wide_type;
+	typedef typename lab::detail::make_unsigned<wide_type>::type
+								unsigned_type;
+	typedef rational_t<IntT>				rational;
+
+	enum : size_t { block = 64 };
+
+	vector<wide_type> coeffs;	// A[k]
+	wide_type denom;		// L
+	int bound_bits;			// of max(|A[0]| + ... + |A[d]|, L)
+	size_t degree;
+
+	static int magnitude_bits(wide_type x) noexcept
+	{
+		return lab::detail::bit_width(
+			lab::detail::magnitude<unsigned_type>(x));
+	}
+
+	// false if the scaled coefficients overflow the wide type
+	bool prepare(polynomial<rational> const& p)
+	{
+		using lab::gcd;	// or the one found by ADL
+		degree = p.degree();
+		denom = 1;
+		for (size_t k = 0; k != p.size(); ++k) {
+			wide_type const d = p.data()[k].denom();
+			if (lab::detail::mul_overflow(
+				    wide_type(denom / gcd(denom, d)), d, denom))
+				return false;
+		}
+
+		int max_bits = 0;
+		coeffs.reserve(p.size());
+		for (size_t k = 0; k != p.size(); ++k) {
+			rational const& c = p.data()[k];
+			wide_type const factor = denom / c.denom();
+			wide_type a = 0;
+			if (lab::detail::mul_overflow(wide_type(c.num()),
+						      factor, a))
+				return false;
+			coeffs.push_back(a);
+			if (magnitude_bits(a) > max_bits)
+				max_bits = magnitude_bits(a);
+		}
+		// a sum of d + 1 terms below 2^max_bits
+		bound_bits = max_bits + lab::detail::bit_width(p.size());
+		if (magnitude_bits(denom) > bound_bits)
+			bound_bits = magnitude_bits(denom);
+		return true;
+	}
+
+	// the bound of the point is below 2^digits
+	bool safe(IntT u, IntT v) const noexcept
+	{
+		int const u_bits = magnitude_bits(u);
+		int const v_bits = magnitude_bits(v);
+		int const m = u_bits > v_bits ? u_bits : v_bits;
+		return static_cast<unsigned long long>(bound_bits)
+		       + static_cast<unsigned long long>(degree) * m
+		       <= static_cast<unsigned long long>(
+				std::numeric_limits<wide_type>::digits);
+	}
+
+	void evaluate(polynomial<rational> const& p, const IntT* num,
+		      const IntT* den, IntT* out_num, IntT* out_den,
+		      size_t n) const
+	{
+		unsigned_type h[block], power[block];
+		unsigned_type u[block], v[block];
+
+		for (size_t first = 0; first < n; first += block) {
+			size_t const count = n - first < block ? n - first
+							       : block;
+			for (size_t j = 0; j != count; ++j) {
+				u[j] = static_cast<unsigned_type>(
+					wide_type(num[first + j]));
+				v[j] = static_cast<unsigned_type>(
+					wide_type(den[first + j]));
+				h[j] = static_cast<unsigned_type>(
+					coeffs.data()[degree]);
+				power[j] = 1;
+			}
+			for (size_t k = degree; k-- != 0;) {
+				unsigned_type const a =
+					static_cast<unsigned_type>(
+						coeffs.data()[k]);
+				for (size_t j = 0; j != count; ++j) {
+					power[j] *= v[j];
+					h[j] = h[j] * u[j] + a * power[j];
+				}
+			}
+			for (size_t j = 0; j != count; ++j)
+				finish(p, num[first + j], den[first + j],
+				       static_cast<wide_type>(h[j]),
+				       static_cast<wide_type>(power[j]),
+				       out_num[first + j],
+				       out_den[first + j]);
+		}
+	}
+
+	// stores h / (L v^d) reduced, or falls back to the rational operators
+	void finish(polynomial<rational> const& p, IntT u, IntT v,
+		    wide_type h, wide_type power, IntT& out_num,
+		    IntT& out_den) const
+	{
+		using lab::gcd;	// or the one found by ADL
+		if (safe(u, v)) {
+			wide_type d = denom * power;
+			wide_type const gcd_ = gcd(h, d);
+			h /= gcd_;
+			d /= gcd_;
+			if (lab::detail::fits<IntT>(h) &&
+			    lab::detail::fits<IntT>(d)) {
+				out_num = static_cast<IntT>(h);
+				out_den = static_cast<IntT>(d);
+				return;
+			}
+		}
+		rational const value = p(rational(u, v));
+		out_num = value.num();
+		out_den = value.denom();
+	}
+};
+
+} // namespace detail
+
+/**
+ * @brief Computes out[i] = p(num[i] / denom[i]) for i in [0, n).
+ *
+ * The points must be reduced with positive denominators, as stored by
+ * rational_soa_vector; the results are too. Outputs may alias inputs.
+ * For built-in components with a wider built-in type (long long included,
+ * through __int128) the points are evaluated over a common denominator,
+ * many at a time (see detail::horner_kernel); other component types use
+ * the rational_t operators.
+ */
+template<typename IntT>
+void evaluate(polynomial<rational_t<IntT> > const& p, const IntT* num,
+	      const IntT* denom, IntT* out_num, IntT* out_denom, size_t n)
+{
+	typedef rational_t<IntT> rational;
+
+	if (p.is_zero()) {
+		for (size_t i = 0; i != n; ++i) {
+			out_num[i] = IntT(0);
+			out_denom[i] = IntT(1);
+		}
+		return;
+	}
+	if constexpr (lab::detail::is_builtin_integer<IntT>::value &&
+		      !std::is_same<typename widen<IntT>::type, IntT>::value) {
+		detail::horner_kernel<IntT> kernel;
+		if (kernel.prepare(p)) {
+			kernel.evaluate(p, num, denom, out_num, out_denom, n);
+			return;
+		}
+	}
+	for (size_t i = 0; i != n; ++i) {
+		rational const value = p(rational(num[i], denom[i]));
+		out_num[i] = value.num();
+		out_denom[i] = value.denom();
+	}
+}
+
+/**
+ * @brief Evaluates p at every point of x; out is resized to match.
+ */
+template<typename IntT>
+void evaluate(polynomial<rational_t<IntT> > const& p,
+	      rational_soa_vector<IntT> const& x,
+	      rational_soa_vector<IntT>& out)
+{
+	if (out.size() != x.size())
+		out = rational_soa_vector<IntT>(x.size());
+	evaluate(p, x.num_data(), x.denom_data(), out.num_data(),
+		 out.denom_data(), x.size());
+}
+
+} // namespace batch
+
+} // namespace lab
+
+#endif // POLYNOMIAL_H
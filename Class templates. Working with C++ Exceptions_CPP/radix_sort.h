@@ -0,0 +1,204 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "distribute.h"
+#include "gcd.h"
+#include "overflow.h"
+#include "rational.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+namespace lab {
+
+namespace detail {
+
+// The unsigned key of an integer with the same order: the sign bit of
+// signed types is flipped.
+template<typename IntT>
+struct radix_key {
+	typedef typename make_unsigned<IntT>::type type;
+
+	static constexpr type sign_bit = std::numeric_limits<IntT>::is_signed
+					 ? type(1) << (8 * sizeof(IntT) - 1)
+					 : type(0);
+
+	static constexpr type of(IntT x) noexcept
+	{
+		return static_cast<type>(static_cast<type>(x) ^ sign_bit);
+	}
+};
+
+enum : size_t {
+	radix_size = 256,		// buckets of one 8-bit digit
+	radix_cutoff = 1024,		// shorter arrays go to std::sort
+	radix_grain = size_t(1) << 16	// elements per parallel chunk
+};
+
+/**
+ * @brief One stable counting pass of an LSD radix sort, by the digit
+ * (key(x) >> shift) & 0xFF, from src into dst, chunk by chunk in
+ * parallel (see distribute()). Returns false, with dst untouched, if all
+ * elements have the same digit.
+ */
+template<typename T, typename Key>
+bool radix_pass(const T* src, T* dst, size_t n, Key const& key, int shift,
+		thread_pool& pool)
+{
+	auto const digit = [&key, shift](T const& x) {
+		return static_cast<size_t>((key(x) >> shift) & 0xFF);
+	};
+	return distribute(src, dst, n, digit, radix_size, radix_grain, pool);
+}
+
+// Sorts trivially copyable records by the unsigned key(x) of key_bits
+// bits, 8 bits per pass, skipping the digits all keys share.
+template<typename T, typename Key>
+void radix_sort_by_key(T* first, size_t n, Key const& key, int key_bits,
+		       thread_pool& pool)
+{
+	vector<T> buffer(n);
+	T* src = first;
+	T* dst = buffer.data();
+
+	for (int shift = 0; shift < key_bits; shift += 8)
+		if (radix_pass(src, dst, n, key, shift, pool))
+			std::swap(src, dst);
+	if (src != first)
+		std::copy(src, src + n, first);
+}
+
+// A 64-bit key with the order of the value of a rational number: its
+// nearest double (monotone, so equal keys only hold close numbers) with
+// the sign bit flipped for positive numbers and all bits for negative
+// ones.
+template<typename Rational>
+std::uint64_t rational_key(Rational const& x)
+{
+	typedef typename Rational::int_type int_type;
+
+	// with exact components the division rounds once, and rounding is
+	// monotone; the narrowing of a long double quotient is too
+	double value;
+	if constexpr (is_builtin_integer<int_type>::value &&
+		      std::numeric_limits<int_type>::digits
+		      <= std::numeric_limits<double>::digits)
+		value = static_cast<double>(x.num())
+			/ static_cast<double>(x.denom());
+	else if constexpr (is_builtin_integer<int_type>::value &&
+			   std::numeric_limits<int_type>::digits
+			   <= std::numeric_limits<long double>::digits)
+		value = static_cast<double>(
+			static_cast<long double>(x.num())
+			/ static_cast<long double>(x.denom()));
+	else
+		value = x.template to_floating<double>();
+
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits >> 63 ? ~bits : bits | (std::uint64_t(1) << 63);
+}
+
+} // namespace detail
+
+/**
+ *  @brief  Sorts the integers first[0], ..., first[n - 1] in ascending
+ *  order by an LSD radix sort.
+ *
+ *  One pass per byte of the type; a byte that is the same in all elements
+ *  (the high bytes of small values) costs a counting pass only. Takes a
+ *  buffer of n elements. Arrays shorter than 1024 elements go to
+ *  std::sort.
+ */
+template<typename IntT>
+void radix_sort(IntT* first, size_t n,
+		thread_pool& pool = default_thread_pool())
+{
+	static_assert(detail::is_builtin_integer<IntT>::value,
+		      "Built-in integer elements required.");
+
+	if (n < detail::radix_cutoff) {
+		std::sort(first, first + n);
+		return;
+	}
+	detail::radix_sort_by_key(first, n, &detail::radix_key<IntT>::of,
+				  int(8 * sizeof(IntT)), pool);
+}
+
+template<typename IntT>
+void radix_sort(vector<IntT>& vec, thread_pool& pool = default_thread_pool())
+{
+	radix_sort(vec.data(), vec.size(), pool);
+}
+
+/**
+ *  @brief  Sorts the rational numbers first[0], ..., first[n - 1] in
+ *  ascending order.
+ *
+ *  Every number gets a 64-bit key from its nearest double; the (key,
+ *  index) pairs are radix sorted, runs of equal keys are ordered by the
+ *  exact comparison, and the numbers are then gathered in that order.
+ *  Class-type components such as bigint go to std::sort: computing their
+ *  keys costs more than the comparisons it saves.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+void radix_sort(rational_t<IntT, OverflowPolicy, NormalizationPolicy>* first,
+		size_t n, thread_pool& pool = default_thread_pool())
+{
+	typedef rational_t<IntT, OverflowPolicy, NormalizationPolicy> rational;
+	struct record {
+		std::uint64_t key;
+		size_t index;
+	};
+
+	if (n < detail::radix_cutoff ||
+	    !detail::is_builtin_integer<IntT>::value) {
+		std::sort(first, first + n);
+		return;
+	}
+
+	vector<record> records(n);
+	record* const r = records.data();
+	pool.parallel_for(0, n, [&](size_t lo, size_t hi) {
+		for (size_t i = lo; i != hi; ++i) {
+			r[i].key = detail::rational_key(first[i]);
+			r[i].index = i;
+		}
+	}, detail::radix_grain);
+	detail::radix_sort_by_key(r, n, [](record const& x) {
+		return x.key;
+	}, 64, pool);
+
+	auto const exact_less = [first](record const& a, record const& b) {
+		return first[a.index] < first[b.index];
+	};
+	for (size_t i = 0, j = 1; i != n; i = j++) {
+		while (j != n && r[j].key == r[i].key)
+			++j;
+		if (j - i > 1)
+			std::sort(r + i, r + j, exact_less);
+	}
+
+	std::vector<rational> sorted;
+	sorted.reserve(n);
+	for (size_t i = 0; i != n; ++i)
+		sorted.push_back(first[r[i].index]);
+	std::move(sorted.begin(), sorted.end(), first);
+}
+
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+void radix_sort(vector<rational_t<IntT, OverflowPolicy,
+				  NormalizationPolicy> >& vec,
+		thread_pool& pool = default_thread_pool())
+{
+	radix_sort(vec.data(), vec.size(), pool);
+}
+
+} // namespace lab
+
+#endif // RADIX_SORT_H
@@ -1,9 +1,19 @@
 #ifndef RATIONAL_H
 #define RATIONAL_H
 
+#include <cmath>
+#include <cstdint>
 #include <ostream>
-#include <experimental/numeric> // std::gcd
+#include <ratio>
 #include <stdexcept>            // std::invalid_argument
+#ifdef __cpp_impl_three_way_comparison
+#include <compare>
+#endif
+
+#include "floating.h"
+#include "gcd.h"
+#include "hash.h"
+#include "overflow.h"
 
 namespace lab {
 // three constructors: default constructor, constructor with parameters, copy constructor.
@@ -32,214 +42,1262 @@ namespace lab {
 // output a rational number to the display screen. check
 // Note. After performing arithmetic operations, the result should be
 // converted to reduced form.
+//
+// Intermediate products are computed exactly in widen<IntT>::type (or with
+// overflow checks when there is no wider type). If the reduced result does
+// not fit into IntT, OverflowPolicy decides what happens: overflow_throw
+// (std::overflow_error, the default), overflow_saturate or overflow_wrap.
+//
+// NormalizationPolicy chooses when the result is reduced.
+
+namespace detail {
+// Lets other headers of the library (rational_expr.h) build a rational_t
+// from components they have already reduced, and compare without the
+// operators (rational_filter.h).
+struct rational_access;
+
+// a / b <=> c / d for unsigned a, c and b, d > 0 as -1, 0 or 1, without
+// products: equal integer parts are dropped and the remainders compared
+// through the reciprocals, as in the continued fraction expansions.
+template<typename UIntT>
+constexpr int compare_fractions(UIntT a, UIntT b, UIntT c, UIntT d) noexcept
+{
+	int sign = 1;
+
+	for (;;) {
+		UIntT const q1 = a / b;
+		UIntT const q2 = c / d;
+		if (q1 != q2)
+			return q1 < q2 ? -sign : sign;
+		a -= q1 * b;
+		c -= q2 * d;
+		if (!a)
+			return c ? -sign : 0;
+		if (!c)
+			return sign;
+		// a / b < c / d <=> d / c < b / a
+		UIntT const t1 = a, t2 = c;
+		a = b;
+		b = t1;
+		c = d;
+		d = t2;
+		sign = -sign;
+	}
+}
+
+/**
+ * @brief The best rational approximation num / denom of p / q (p >= 0,
+ * q > 0) with num <= max_num and 0 < denom <= max_denom.
+ *
+ * Walks the continued fraction expansion of p / q, one partial quotient per
+ * step, so the loop runs at most about 1.44 times per bit of q. When the
+ * next convergent leaves the bounds, the candidates are the last convergent
+ * and the largest semiconvergent that stays within them; the
+ * semiconvergent wins only if it is strictly closer, which is decided by
+ * the remaining tail p / q of the expansion. Returns false if even
+ * floor(p / q) exceeds max_num.
+ */
+template<typename UIntT>
+constexpr bool best_approximation(UIntT p, UIntT q, UIntT const& max_num,
+				  UIntT const& max_denom,
+				  UIntT& num, UIntT& denom)
+{
+	// the last two convergents h0 / k0 and h1 / k1
+	UIntT h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+
+	for (;;) {
+		UIntT const a = p / q;
+		UIntT const r = p - a * q;
 
-template <typename IntT = int>
+		// the largest multiple t <= a of h1 / k1 that stays in bounds;
+		// the divisions are needed only once a bound is reached
+		UIntT t = a;
+		UIntT product = 0;
+		if (h1 != UIntT(0) && (mul_overflow(t, h1, product) ||
+				       product > max_num - h0))
+			t = (max_num - h0) / h1;
+		if (k1 != UIntT(0) && (mul_overflow(t, k1, product) ||
+				       product > max_denom - k0))
+			t = (max_denom - k0) / k1;
+
+		if (t < a) {
+			if (k1 == UIntT(0))
+				return false;
+			// (h0 + t h1) / (k0 + t k1) is closer than h1 / k1 iff
+			// the tail p / q < 2t + k0 / k1
+			bool closer = false;
+			if (t != UIntT(0)) {
+				if (a - t < t) {
+					closer = true;
+				} else if (a - t == t) {
+					if constexpr (is_builtin_integer<UIntT>::value)
+						closer = compare_fractions(r, q, k0,
+									   k1) < 0;
+					else
+						closer = r * k1 < k0 * q;
+				}
+			}
+			if (closer) {
+				h1 = h0 + t * h1;
+				k1 = k0 + t * k1;
+			}
+			break;
+		}
+
+		UIntT const h2 = a * h1 + h0;
+		UIntT const k2 = a * k1 + k0;
+		h0 = h1;
+		h1 = h2;
+		k0 = k1;
+		k1 = k2;
+		if (r == UIntT(0))
+			break;
+		p = q;
+		q = r;
+	}
+	num = h1;
+	denom = k1;
+	return true;
+}
+} // namespace detail
+
+/**
+ * @brief Reduce after every operation (the default).
+ */
+struct eager_normalization {
+	static constexpr bool lazy = false;
+};
+
+/**
+ * @brief Keep results unreduced while they fit into the component type.
+ *
+ * Long chains of arithmetic skip the gcd per step; the value is reduced
+ * when it would otherwise overflow, and on comparison for equality and
+ * output. num() and denom() return the stored, possibly unreduced, form;
+ * normalized() returns the reduced one.
+ */
+struct lazy_normalization {
+	static constexpr bool lazy = true;
+};
+
+template <typename IntT = int, typename OverflowPolicy = overflow_throw,
+	  typename NormalizationPolicy = eager_normalization>
 class rational_t {
+public:
+	typedef IntT			int_type;
+	typedef OverflowPolicy		overflow_policy;
+	typedef NormalizationPolicy	normalization_policy;
 private:
-	static_assert(std::is_integral<IntT>::value, "Integral required.");
+	static_assert(std::numeric_limits<IntT>::is_integer,
+		      "Integral required.");
+
+	typedef typename widen<IntT>::type wide_type;
+
+	static constexpr bool lazy = NormalizationPolicy::lazy;
 
-	// N = num / denom; denom != 0.
+	// N = num / denom; denom > 0.
 	IntT num_, denom_;
 
-	void check() noexcept
+	struct raw_tag {};
+
+	// stored as given: denom > 0 and, unless normalization is lazy,
+	// num and denom are coprime
+	constexpr rational_t(IntT num, IntT denom, raw_tag) noexcept
+		: num_(num), denom_(denom) {}
+
+	friend struct detail::rational_access;
+
+	static constexpr long double approx(rational_t const& number) noexcept
+	{
+		return static_cast<long double>(number.num_)
+		       / static_cast<long double>(number.denom_);
+	}
+
+	static constexpr rational_t overflowed(long double value,
+					       wide_type num, wide_type denom)
+	{
+		return OverflowPolicy::template on_overflow<rational_t>(value,
+									num,
+									denom);
+	}
+
+	// Builds the exact result num / denom, denom > 0, computed in
+	// wide_type: reduces it unless it is known to be reduced already (or
+	// normalization is lazy and it fits as is) and narrows it to IntT.
+	static constexpr rational_t narrow(wide_type num, wide_type denom,
+					   bool reduced)
+	{
+		if (lazy && detail::fits<IntT>(num) && detail::fits<IntT>(denom))
+			return rational_t(static_cast<IntT>(num),
+					  static_cast<IntT>(denom), raw_tag());
+		if (!reduced) {
+			using lab::gcd;	// or the one found by ADL
+			wide_type const gcd_ = gcd(num, denom);
+			num /= gcd_;
+			denom /= gcd_;
+		}
+		if (!detail::fits<IntT>(num) || !detail::fits<IntT>(denom))
+			return overflowed(static_cast<long double>(num)
+					  / static_cast<long double>(denom),
+					  num, denom);
+		return rational_t(static_cast<IntT>(num),
+				  static_cast<IntT>(denom), raw_tag());
+	}
+
+	// lhs + rhs or lhs - rhs over the least common denominator; without
+	// cancel only equal denominators are merged
+	static constexpr rational_t add(rational_t const& lhs,
+					rational_t const& rhs, bool subtract,
+					bool cancel = !lazy)
+	{
+		IntT const gcd_ = cancel ? gcd(lhs.denom_, rhs.denom_)
+				  : lhs.denom_ == rhs.denom_ ? lhs.denom_
+				  : IntT(1);
+		wide_type const lhs_factor = rhs.denom_ / gcd_;
+		wide_type const rhs_factor = lhs.denom_ / gcd_;
+		wide_type lhs_num = 0, rhs_num = 0, num = 0, denom = 0;
+
+		bool overflow = detail::mul_overflow(wide_type(lhs.num_),
+						     lhs_factor, lhs_num);
+		overflow |= detail::mul_overflow(wide_type(rhs.num_),
+						 rhs_factor, rhs_num);
+		overflow |= subtract
+			    ? detail::sub_overflow(lhs_num, rhs_num, num)
+			    : detail::add_overflow(lhs_num, rhs_num, num);
+		overflow |= detail::mul_overflow(rhs_factor,
+						 wide_type(rhs.denom_), denom);
+		if (overflow && !cancel)
+			return add(lhs.normalized(), rhs.normalized(), subtract,
+				   true);
+		if (overflow)
+			return overflowed(subtract ? approx(lhs) - approx(rhs)
+						   : approx(lhs) + approx(rhs),
+					  num, denom);
+		if (!cancel)
+			return narrow(num, denom, false);
+		// Knuth 4.5.1: with reduced operands every common factor of
+		// num and denom divides gcd_, so the long gcd(num, denom) is
+		// not needed
+		if (!num)
+			return rational_t();
+		if (gcd_ == IntT(1))
+			return narrow(num, denom, true);
+		using lab::gcd;	// or the one found by ADL
+		wide_type const gcd_2 = gcd(num, wide_type(gcd_));
+		return narrow(num / gcd_2, denom / gcd_2, true);
+	}
+
+	// lhs * (num / denom), denom != 0 of either sign. Cancelling common
+	// factors crosswise first leaves a reduced result.
+	static constexpr rational_t multiply(rational_t const& lhs, IntT num,
+					     IntT denom, bool cancel = !lazy)
 	{
-		if (denom_ < 0) {
-			denom_ = -denom_;
-			num_ = -num_;
+		if (!lhs.num_ || !num)
+			return rational_t();
+
+		IntT const gcd_1 = cancel && denom != 1 ? gcd(lhs.num_, denom)
+					   : IntT(1);
+		IntT const gcd_2 = cancel && num != 1 ? gcd(num, lhs.denom_)
+					  : IntT(1);
+		wide_type res_num = 0, res_denom = 0;
+
+		bool overflow = detail::mul_overflow(
+					wide_type(lhs.num_ / gcd_1),
+					wide_type(num / gcd_2), res_num);
+		overflow |= detail::mul_overflow(
+					wide_type(lhs.denom_ / gcd_2),
+					wide_type(denom / gcd_1), res_denom);
+		if (!overflow && res_denom < 0) {
+			overflow |= detail::sub_overflow(wide_type(0), res_num,
+							 res_num);
+			overflow |= detail::sub_overflow(wide_type(0), res_denom,
+							 res_denom);
 		}
-		int const gcd_ = gcd(num_, denom_);
+		if (overflow && !cancel) {
+			rational_t const rhs = rational_t(num, denom).normalized();
+			return multiply(lhs.normalized(), rhs.num_, rhs.denom_,
+					true);
+		}
+		if (overflow)
+			return overflowed(approx(lhs) * static_cast<long double>(num)
+					  / static_cast<long double>(denom),
+					  res_num, res_denom);
+		return narrow(res_num, res_denom, cancel);
+	}
+
+	constexpr void reduce() noexcept
+	{
+		IntT const gcd_ = gcd(num_, denom_);
 		denom_ /= gcd_;
 		num_ /= gcd_;
 	}
+
+	// Moves the sign to the numerator. The most negative value has no
+	// negation in IntT: such a component is reduced first, and if that
+	// does not help, the value goes to OverflowPolicy.
+	constexpr void check_sign()
+	{
+		if (!(denom_ < IntT(0)))
+			return;
+		IntT num = 0, denom = 0;
+		bool overflow = detail::sub_overflow(IntT(0), num_, num);
+		overflow |= detail::sub_overflow(IntT(0), denom_, denom);
+		if (overflow) {
+			reduce();
+			overflow = detail::sub_overflow(IntT(0), num_, num);
+			overflow |= detail::sub_overflow(IntT(0), denom_, denom);
+		}
+		if (overflow) {
+			*this = overflowed(approx(*this), wide_type(num),
+					   wide_type(denom));
+			return;
+		}
+		num_ = num;
+		denom_ = denom;
+	}
+
+	constexpr void check()
+	{
+		reduce();
+		check_sign();
+	}
+
+	// from_double(): the best approximation of x with a denominator of at
+	// most max_denom, or x itself when exact (unbounded IntT only)
+	static rational_t approximate(double x, IntT const& max_denom,
+				      bool exact)
+	{
+		typedef typename std::conditional<
+			detail::is_builtin_integer<IntT>::value,
+			detail::widest_uint, IntT>::type work_type;
+
+		if (!std::isfinite(x))
+			throw std::invalid_argument("Not a finite number.");
+		if (!exact && !(max_denom > IntT(0)))
+			throw std::invalid_argument(
+				"Denominator bound must be positive.");
+		if (x == 0)
+			return rational_t();
+
+		// |x| == mantissa * 2^exp exactly, with an odd mantissa
+		int exp = 0;
+		std::uint64_t mantissa = static_cast<std::uint64_t>(
+			std::ldexp(std::frexp(std::fabs(x), &exp), 53));
+		int const zeros = __builtin_ctzll(mantissa);
+		mantissa >>= zeros;
+		exp += zeros - 53;
+		bool const negative = x < 0;
+		// the numerator with the sign of x, negated in the unsigned
+		// work type: -2^digits has no positive counterpart in IntT
+		auto const with_sign = [negative](work_type magnitude) {
+			return static_cast<IntT>(negative
+				? work_type(0) - magnitude : magnitude);
+		};
+
+		work_type p = mantissa, q = 1;
+		if constexpr (std::numeric_limits<IntT>::is_bounded) {
+			// -2^digits is the one value that takes an extra bit
+			int const max_width = std::numeric_limits<IntT>::digits
+					      + (negative && mantissa == 1);
+			if (exp >= 0 && detail::bit_width(mantissa) + exp
+					> max_width) {
+				// keep the low bits for overflow_wrap
+				work_type low = exp < std::numeric_limits<
+							work_type>::digits
+						? p << exp : work_type(0);
+				if (negative)
+					low = -low;
+				return overflowed(x, static_cast<wide_type>(low),
+						  wide_type(1));
+			}
+			// the bits below 2^-126 are beyond the resolution of
+			// any bounded denominator but __int128's
+			int constexpr max_shift =
+				std::numeric_limits<work_type>::digits - 2;
+			if (-exp > max_shift) {
+				int const shift = -exp - max_shift;
+				p = shift < std::numeric_limits<
+						work_type>::digits
+					? p >> shift : work_type(0);
+				exp = -max_shift;
+				if (p == work_type(0))
+					return rational_t();
+			}
+		}
+		if (exp >= 0) {
+			p *= detail::power_of_two<work_type>(exp);
+			return rational_t(with_sign(p), IntT(1), raw_tag());
+		}
+		q = detail::power_of_two<work_type>(-exp);
+
+		// builtin numerators are bounded by IntT, one further below
+		// zero, unbounded ones by the best approximation itself
+		work_type max_num = 0;
+		if constexpr (std::numeric_limits<IntT>::is_bounded)
+			max_num = static_cast<work_type>(
+				std::numeric_limits<IntT>::max())
+				  + work_type(negative);
+		else if (!exact)
+			max_num = (p / q + work_type(1)) * max_denom;
+
+		// an odd numerator over a power of two is reduced already, and
+		// within the bounds nothing is closer
+		if (exact || (q <= static_cast<work_type>(max_denom) &&
+			      p <= max_num)) {
+			return rational_t(with_sign(p), static_cast<IntT>(q),
+					  raw_tag());
+		}
+
+		work_type num = 0, denom = 0;
+		bool found = false;
+		bool narrow_enough = false;
+		if constexpr (detail::is_builtin_integer<IntT>::value &&
+			      sizeof(IntT) <= sizeof(std::uint64_t)) {
+			// everything fits into 64 bits unless |x| < 2^-63: skip
+			// the slower 128-bit divisions
+			narrow_enough = detail::bit_width(q) <= 64;
+			if (narrow_enough) {
+				std::uint64_t n = 0, d = 0;
+				found = detail::best_approximation<std::uint64_t>(
+						static_cast<std::uint64_t>(p),
+						static_cast<std::uint64_t>(q),
+						static_cast<std::uint64_t>(max_num),
+						static_cast<std::uint64_t>(max_denom),
+						n, d);
+				num = n;
+				denom = d;
+			}
+		}
+		if (!narrow_enough)
+			found = detail::best_approximation(p, q, max_num,
+						static_cast<work_type>(max_denom),
+						num, denom);
+		if (!found) {
+			work_type low = p / q;
+			if (negative)
+				low = -low;
+			return overflowed(x, static_cast<wide_type>(low),
+					  wide_type(1));
+		}
+		return rational_t(with_sign(num), static_cast<IntT>(denom),
+				  raw_tag());
+	}
+
+	// lhs * N / D for a reduced compile-time ratio N / D, D > 0. The
+	// cross-cancelling gcds start with a remainder modulo the constant
+	// and the product needs no final gcd; lazy normalization skips them
+	// unless the product overflows.
+	template <std::intmax_t N, std::intmax_t D>
+	static constexpr rational_t scale(rational_t const& lhs,
+					  bool cancel = !lazy)
+	{
+		static_assert(detail::fits<IntT>(N) && detail::fits<IntT>(D),
+			      "The ratio must fit into the component type.");
+
+		if (!N || !lhs.num_)
+			return rational_t();
+
+		IntT gcd_1 = 1, gcd_2 = 1;
+		if (cancel) {
+			if constexpr (D != 1)
+				gcd_1 = gcd(IntT(D), IntT(lhs.num_ % IntT(D)));
+			if constexpr (N != 1 && N != -1)
+				gcd_2 = gcd(IntT(N), IntT(lhs.denom_ % IntT(N)));
+		}
+		wide_type num = 0, denom = 0;
+
+		bool overflow = detail::mul_overflow(wide_type(lhs.num_ / gcd_1),
+						     wide_type(IntT(N) / gcd_2),
+						     num);
+		overflow |= detail::mul_overflow(wide_type(lhs.denom_ / gcd_2),
+						 wide_type(IntT(D) / gcd_1),
+						 denom);
+		if (overflow && !cancel)
+			return scale<N, D>(lhs.normalized(), true);
+		if (overflow)
+			return overflowed(approx(lhs) * N / D, num, denom);
+		return narrow(num, denom, cancel);
+	}
+
+	// lhs + k, lhs - k (subtract) or k - lhs (reverse). The sum
+	// (num +- k * denom) / denom keeps the gcd of num and denom, so it
+	// needs no reduction. An unreduced lazy operand is reduced if the
+	// product overflows.
+	static constexpr rational_t add_integer(rational_t const& lhs, IntT k,
+						bool subtract, bool reverse)
+	{
+		wide_type product = 0, num = 0;
+
+		bool overflow = detail::mul_overflow(wide_type(k),
+						     wide_type(lhs.denom_),
+						     product);
+		overflow |= reverse
+			    ? detail::sub_overflow(product, wide_type(lhs.num_), num)
+			    : subtract
+			    ? detail::sub_overflow(wide_type(lhs.num_), product, num)
+			    : detail::add_overflow(wide_type(lhs.num_), product, num);
+		if (overflow && lazy) {
+			rational_t const reduced = lhs.normalized();
+			if (reduced.denom_ != lhs.denom_)
+				return add_integer(reduced, k, subtract, reverse);
+		}
+		if (overflow) {
+			long double const value = approx(lhs);
+			long double const k_value = static_cast<long double>(k);
+			return overflowed(reverse ? k_value - value
+					  : subtract ? value - k_value
+					  : value + k_value,
+					  num, wide_type(lhs.denom_));
+		}
+		return narrow(num, wide_type(lhs.denom_), !lazy);
+	}
+
+	// Integer operands beyond the range of IntT are handled exactly in
+	// big_type: the result can still fit, e.g. -100 + 200 for IntT = char.
+	typedef typename std::conditional<std::numeric_limits<IntT>::is_bounded,
+					  detail::widest_int, IntT>::type big_type;
+
+	// reduces the exact result num / denom, denom != 0, computed in
+	// big_type unless overflow is set
+	static constexpr rational_t big_result(big_type num, big_type denom,
+					       bool overflow, long double value)
+	{
+		if (!overflow && denom < 0) {
+			overflow |= detail::sub_overflow(big_type(0), num, num);
+			overflow |= detail::sub_overflow(big_type(0), denom, denom);
+		}
+		if (!overflow) {
+			using lab::gcd;	// or the one found by ADL
+			big_type const gcd_ = gcd(num, denom);
+			num /= gcd_;
+			denom /= gcd_;
+			if (detail::fits<IntT>(num) && detail::fits<IntT>(denom))
+				return rational_t(static_cast<IntT>(num),
+						  static_cast<IntT>(denom), raw_tag());
+		}
+		return OverflowPolicy::template on_overflow<rational_t>(value, num,
+									denom);
+	}
+
+	// sign of lhs - k
+	template <typename I>
+	static constexpr int compare_integer(rational_t const& lhs, I k)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		// beyond the range of IntT, hence of lhs
+		if (!detail::in_range<IntT>(k))
+			return k > I(0) ? -1 : 1;
+		if (lhs.denom_ == 1)
+			return (lhs.num_ > IntT(k)) - (lhs.num_ < IntT(k));
+
+		wide_type product = 0;
+		// |k * denom| > |num| when it does not fit
+		if (detail::mul_overflow(wide_type(IntT(k)), wide_type(lhs.denom_),
+					 product))
+			return k > I(0) ? -1 : 1;
+		return (wide_type(lhs.num_) > product)
+		       - (wide_type(lhs.num_) < product);
+	}
+
+	// sign of lhs - rhs, by cross-multiplication in wide_type; reduced
+	// form is not required
+	static constexpr int compare(rational_t const& lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		int const lhs_sign = (lhs.num_ > 0) - (lhs.num_ < 0);
+		int const rhs_sign = (rhs.num_ > 0) - (rhs.num_ < 0);
+
+		if (lhs_sign != rhs_sign)
+			return lhs_sign < rhs_sign ? -1 : 1;
+		if (!lhs_sign)
+			return 0;
+		// integers among others
+		if (lhs.denom_ == rhs.denom_)
+			return (lhs.num_ > rhs.num_) - (lhs.num_ < rhs.num_);
+
+		wide_type lhs_cross = 0, rhs_cross = 0;
+		bool overflow = detail::mul_overflow(wide_type(lhs.num_),
+						     wide_type(rhs.denom_),
+						     lhs_cross);
+		overflow |= detail::mul_overflow(wide_type(rhs.num_),
+						 wide_type(lhs.denom_),
+						 rhs_cross);
+		if constexpr (detail::is_builtin_integer<IntT>::value) {
+			// no wider type: compare the magnitudes exactly
+			if (overflow) {
+				typedef typename detail::make_unsigned<IntT>::type
+					unsigned_type;
+
+				int const order = detail::compare_fractions(
+					detail::magnitude<unsigned_type>(lhs.num_),
+					static_cast<unsigned_type>(lhs.denom_),
+					detail::magnitude<unsigned_type>(rhs.num_),
+					static_cast<unsigned_type>(rhs.denom_));
+				return lhs_sign > 0 ? order : -order;
+			}
+		}
+		return (lhs_cross > rhs_cross) - (lhs_cross < rhs_cross);
+	}
 public:
-	rational_t() noexcept : num_(0), denom_(1) {}
-	rational_t(IntT num, IntT denom) noexcept(false) : num_(num), denom_(denom)
+	constexpr rational_t() noexcept : num_(0), denom_(1) {}
+	constexpr rational_t(IntT num, IntT denom) noexcept(false)
+		: num_(num), denom_(denom)
 	{
 		if (!denom)
 			throw std::invalid_argument("Denominator can't be 0.");
-		check();
+		if (lazy)
+			check_sign();
+		else
+			check();
+	}
+	// exact conversion from a rational with narrower components,
+	// e.g. rational_t<bigint>(rational_t<int>(1, 3))
+	template <typename OtherIntT, typename OtherOverflow,
+		  typename OtherNormalization,
+		  typename = typename std::enable_if<
+			!std::numeric_limits<IntT>::is_bounded ||
+			(std::numeric_limits<OtherIntT>::is_bounded &&
+			 std::numeric_limits<IntT>::digits >=
+			 std::numeric_limits<OtherIntT>::digits)>::type>
+	explicit constexpr rational_t(rational_t<OtherIntT, OtherOverflow,
+				       OtherNormalization> const& number)
+		: num_(number.num()), denom_(number.denom())
+	{
+		if (OtherNormalization::lazy && !lazy)
+			check();
 	}
-	// assign operator
-	rational_t& operator=(rational_t const& number) noexcept
+	// exact conversion from a compile-time ratio, e.g. std::milli()
+	template <std::intmax_t N, std::intmax_t D>
+	constexpr rational_t(std::ratio<N, D>) noexcept
+		: num_(std::ratio<N, D>::num), denom_(std::ratio<N, D>::den)
 	{
-		if (this == &number)
-			return *this;
-		num_ = number.num_;
-		denom_ = number.denom_;
-		return *this;
+		static_assert(detail::fits<IntT>(std::ratio<N, D>::num) &&
+			      detail::fits<IntT>(std::ratio<N, D>::den),
+			      "The ratio must fit into the component type.");
 	}
-	operator double() const noexcept
+	// accessors
+	constexpr IntT num() const noexcept { return num_; }
+	constexpr IntT denom() const noexcept { return denom_; }
+
+	// the reduced form of the number
+	constexpr rational_t normalized() const noexcept
 	{
-		return static_cast<double>(num_) / denom_;
+		rational_t result(num_, denom_, raw_tag());
+		if (lazy)
+			result.check();
+		return result;
+	}
+
+	// the nearest floating-point value (ties to even), e.g.
+	// to_floating<float>(); exact components take one division
+	template <typename F>
+	constexpr F to_floating() const
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		static_assert(std::is_floating_point<F>::value,
+			      "Floating-point type required.");
+
+		if (!num_)
+			return F(0);
+		if constexpr (detail::is_builtin_integer<IntT>::value) {
+			typedef typename detail::make_unsigned<IntT>::type
+				unsigned_type;
+
+			F const value = detail::round_quotient<F>(
+				detail::magnitude<unsigned_type>(num_),
+				static_cast<unsigned_type>(denom_));
+			return num_ < 0 ? -value : value;
+		} else {
+			F const value = detail::round_quotient<F>(abs(num_), denom_);
+			return num_ < 0 ? -value : value;
+		}
+	}
+	constexpr operator double() const
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return to_floating<double>();
+	}
+	explicit constexpr operator float() const
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return to_floating<float>();
+	}
+	explicit constexpr operator long double() const
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return to_floating<long double>();
+	}
+	// the closest rational to x with a denominator of at most max_denom
+	// (ties to the smaller denominator), e.g. from_double(M_PI, 1000)
+	// == 355 / 113; throws std::invalid_argument for NaN and infinities,
+	// integer parts out of range go to OverflowPolicy
+	static rational_t from_double(double x, IntT const& max_denom)
+	{
+		return approximate(x, max_denom, false);
+	}
+	// the same with any denominator IntT can hold; exact for unbounded
+	// IntT, e.g. rational_t<bigint>::from_double(0.1)
+	static rational_t from_double(double x)
+	{
+		// numeric_limits<IntT>::max() means nothing when unbounded
+		if constexpr (std::numeric_limits<IntT>::is_bounded)
+			return approximate(x, std::numeric_limits<IntT>::max(),
+					   false);
+		else
+			return approximate(x, IntT(), true);
 	}
 
 	friend inline std::ostream& operator<<(std::ostream& os,
 					       rational_t const& number)
 	{
-		os << +number.num_ << " / " << +number.denom_;
+		rational_t const reduced = number.normalized();
+
+		os << +reduced.num_ << " / " << +reduced.denom_;
 		return os;
 	}
 
 	//unary +
-	friend rational_t const& operator+(rational_t const& number) noexcept
+	friend constexpr rational_t const& operator+(rational_t const& number)
+	noexcept
 	{
 		return number;
 	}
 
 	//unary -
-	friend rational_t const operator-(rational_t const& number) noexcept
+	friend constexpr rational_t const operator-(rational_t const& number)
 	{
-		return rational_t(-number.num_, number.denom_);
+		IntT num = 0;
+
+		if (detail::sub_overflow(IntT(0), number.num_, num))
+			return overflowed(-approx(number), num, number.denom_);
+		return rational_t(num, number.denom_, raw_tag());
 	}
 
 	//prefix increment
-	friend rational_t const& operator++(rational_t& number) noexcept
+	friend constexpr rational_t const& operator++(rational_t& number)
 	{
-		number = number + rational_t(1, 1);
+		number = add_integer(number, IntT(1), false, false);
 		return number;
 	}
 
 	//postfix increment
-	friend rational_t const operator++(rational_t& number, int) noexcept
+	friend constexpr rational_t const operator++(rational_t& number, int)
 	{
 		rational_t old(number);
 
-		number = number + rational_t(1, 1);
+		number = add_integer(number, IntT(1), false, false);
 		return old;
 	}
 
 	//prefix decrement
-	friend rational_t const& operator--(rational_t& number) noexcept
+	friend constexpr rational_t const& operator--(rational_t& number)
 	{
-		number = number - rational_t(1, 1);
+		number = add_integer(number, IntT(1), true, false);
 		return number;
 	}
 
 	//postfix decrement
-	friend rational_t const operator--(rational_t& number, int) noexcept
+	friend constexpr rational_t const operator--(rational_t& number, int)
 	{
 		rational_t old(number);
 
-		number = number - rational_t(1, 1);
+		number = add_integer(number, IntT(1), true, false);
 		return old;
 	}
 
 	// +=
-	friend rational_t& operator+=(rational_t& lhs,
-				    rational_t const& rhs) noexcept
+	friend constexpr rational_t& operator+=(rational_t& lhs,
+				    rational_t const& rhs)
 	{
 		lhs = lhs + rhs;
 		return lhs;
 	}
 
 	// ==
-	friend bool operator==(rational_t const& lhs,
+	friend constexpr bool operator==(rational_t const& lhs,
 			       rational_t const& rhs) noexcept
 	{
+		if (lazy)
+			return !compare(lhs, rhs);
 		return (lhs.denom_ == rhs.denom_) && (lhs.num_ == rhs.num_);
 	}
 
 	// !=
-	friend bool operator!=(rational_t const& lhs,
+	friend constexpr bool operator!=(rational_t const& lhs,
 			       rational_t const& rhs) noexcept
 	{
 		return !(lhs == rhs);
 	}
 
 	// binary plus
-	friend rational_t const operator+(rational_t const& lhs,
-					rational_t const& rhs) noexcept
+	friend constexpr rational_t const operator+(rational_t const& lhs,
+					rational_t const& rhs)
 	{
-		int const temp_denom = lhs.denom_ * rhs.denom_
-				       / gcd(lhs.denom_, rhs.denom_);
-		int const temp_num = temp_denom / lhs.denom_ * lhs.num_
-				     + temp_denom / rhs.denom_ * rhs.num_;
-
-		return rational_t(temp_num, temp_denom);
+		return add(lhs, rhs, false);
 	}
 
 	// binary -
-	friend rational_t const operator-(rational_t const& lhs,
-					rational_t const& rhs) noexcept
+	friend constexpr rational_t const operator-(rational_t const& lhs,
+					rational_t const& rhs)
 	{
-		return operator+(lhs, -rhs);
+		return add(lhs, rhs, true);
 	}
 
 	// binary -=
-	friend rational_t& operator-=(rational_t& lhs,
-				    rational_t const& rhs) noexcept
+	friend constexpr rational_t& operator-=(rational_t& lhs,
+				    rational_t const& rhs)
 	{
 		lhs = lhs - rhs;
 		return lhs;
 	}
 
 	// binary multiply
-	friend rational_t const operator*(rational_t const& lhs,
-					rational_t const& rhs) noexcept
+	friend constexpr rational_t const operator*(rational_t const& lhs,
+					rational_t const& rhs)
 	{
-		return rational_t(lhs.num_ * rhs.num_, lhs.denom_ * rhs.denom_);
+		return multiply(lhs, rhs.num_, rhs.denom_);
 	}
 
 	// binary *=
-	friend rational_t const operator*=(rational_t& lhs,
-					rational_t const& rhs) noexcept
+	friend constexpr rational_t const operator*=(rational_t& lhs,
+					rational_t const& rhs)
 	{
 		lhs = lhs * rhs;
 		return lhs;
 	}
 
 	// binary divide
-	friend rational_t const operator/(rational_t const& lhs,
-					rational_t const& rhs) noexcept
+	friend constexpr rational_t const operator/(rational_t const& lhs,
+					rational_t const& rhs)
 	{
-		return rational_t(lhs.num_ * rhs.denom_, lhs.denom_ * rhs.num_);
+		if (!rhs.num_)
+			throw std::invalid_argument("Denominator can't be 0.");
+		return multiply(lhs, rhs.denom_, rhs.num_);
 	}
 
 	// binary /=
-	friend rational_t const operator/=(rational_t& lhs,
-					rational_t const& rhs) noexcept
+	friend constexpr rational_t const operator/=(rational_t& lhs,
+					rational_t const& rhs)
 	{
 		lhs = lhs / rhs;
 		return lhs;
 	}
 
-	friend bool operator<(rational_t const& lhs,
-			      rational_t const& rhs) noexcept
+	// compile-time ratio operands, e.g. elapsed * std::milli(); other
+	// operations convert the ratio to rational_t
+	template <std::intmax_t N, std::intmax_t D>
+	friend constexpr rational_t const operator*(rational_t const& lhs,
+						    std::ratio<N, D>)
 	{
-		return rational_t(lhs - rhs).num_ < 0;
+		typedef std::ratio<N, D> ratio;
+
+		return scale<ratio::num, ratio::den>(lhs);
 	}
 
-	friend bool operator>(rational_t const& lhs,
-			      rational_t const& rhs) noexcept
+	template <std::intmax_t N, std::intmax_t D>
+	friend constexpr rational_t const operator*(std::ratio<N, D> lhs,
+						    rational_t const& rhs)
 	{
-		return rhs < lhs;
+		return rhs * lhs;
 	}
 
-	friend bool operator<=(rational_t const& lhs,
-			       rational_t const& rhs) noexcept
+	template <std::intmax_t N, std::intmax_t D>
+	friend constexpr rational_t const operator/(rational_t const& lhs,
+						    std::ratio<N, D>)
 	{
-		return !(lhs > rhs);
+		typedef std::ratio<N, D> ratio;
+		static_assert(ratio::num != 0, "Denominator can't be 0.");
+
+		return scale<(ratio::num < 0 ? -ratio::den : ratio::den),
+			     (ratio::num < 0 ? -ratio::num : ratio::num)>(lhs);
 	}
 
-	friend bool operator>=(rational_t const& lhs,
-			       rational_t const& rhs) noexcept
+	template <std::intmax_t N, std::intmax_t D>
+	friend constexpr rational_t& operator*=(rational_t& lhs,
+						std::ratio<N, D> rhs)
+	{
+		lhs = lhs * rhs;
+		return lhs;
+	}
+
+	template <std::intmax_t N, std::intmax_t D>
+	friend constexpr rational_t& operator/=(rational_t& lhs,
+						std::ratio<N, D> rhs)
+	{
+		lhs = lhs / rhs;
+		return lhs;
+	}
+
+	// integer operands, e.g. r + 1 or 3_r / 4. They skip the reductions
+	// a rational operand would need: r + k needs none, r * k and r / k
+	// one gcd.
+	template <typename I>
+	using enable_if_integer = typename std::enable_if<
+		detail::is_builtin_integer<I>::value &&
+		!std::is_same<I, bool>::value &&
+		(!std::numeric_limits<big_type>::is_bounded ||
+		 std::numeric_limits<I>::digits <=
+		 std::numeric_limits<big_type>::digits)>::type;
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator+(rational_t const& lhs, I rhs)
+	{
+		if (detail::in_range<IntT>(rhs))
+			return add_integer(lhs, IntT(rhs), false, false);
+
+		big_type num = 0;
+		bool overflow = detail::mul_overflow(big_type(rhs),
+						     big_type(lhs.denom_), num);
+		overflow |= detail::add_overflow(num, big_type(lhs.num_), num);
+		return big_result(num, big_type(lhs.denom_), overflow,
+				  approx(lhs) + rhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator+(I lhs, rational_t const& rhs)
+	{
+		return rhs + lhs;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator-(rational_t const& lhs, I rhs)
+	{
+		if (detail::in_range<IntT>(rhs))
+			return add_integer(lhs, IntT(rhs), true, false);
+
+		big_type num = 0;
+		bool overflow = detail::mul_overflow(big_type(rhs),
+						     big_type(lhs.denom_), num);
+		overflow |= detail::sub_overflow(big_type(lhs.num_), num, num);
+		return big_result(num, big_type(lhs.denom_), overflow,
+				  approx(lhs) - rhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator-(I lhs, rational_t const& rhs)
+	{
+		if (detail::in_range<IntT>(lhs))
+			return add_integer(rhs, IntT(lhs), false, true);
+
+		big_type num = 0;
+		bool overflow = detail::mul_overflow(big_type(lhs),
+						     big_type(rhs.denom_), num);
+		overflow |= detail::sub_overflow(num, big_type(rhs.num_), num);
+		return big_result(num, big_type(rhs.denom_), overflow,
+				  lhs - approx(rhs));
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator*(rational_t const& lhs, I rhs)
+	{
+		if (detail::in_range<IntT>(rhs))
+			return multiply(lhs, IntT(rhs), IntT(1));
+
+		big_type num = 0;
+		bool const overflow = detail::mul_overflow(big_type(lhs.num_),
+							   big_type(rhs), num);
+		return big_result(num, big_type(lhs.denom_), overflow,
+				  approx(lhs) * rhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator*(I lhs, rational_t const& rhs)
+	{
+		return rhs * lhs;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator/(rational_t const& lhs, I rhs)
+	{
+		if (!rhs)
+			throw std::invalid_argument("Denominator can't be 0.");
+		if (detail::in_range<IntT>(rhs))
+			return multiply(lhs, IntT(1), IntT(rhs));
+
+		big_type denom = 0;
+		bool const overflow = detail::mul_overflow(big_type(lhs.denom_),
+							   big_type(rhs), denom);
+		return big_result(big_type(lhs.num_), denom, overflow,
+				  approx(lhs) / rhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t const operator/(I lhs, rational_t const& rhs)
+	{
+		if (!rhs.num_)
+			throw std::invalid_argument("Denominator can't be 0.");
+		if (detail::in_range<IntT>(lhs))
+			return multiply(rational_t(IntT(lhs), IntT(1), raw_tag()),
+					rhs.denom_, rhs.num_);
+
+		big_type num = 0;
+		bool const overflow = detail::mul_overflow(big_type(lhs),
+							   big_type(rhs.denom_), num);
+		return big_result(num, big_type(rhs.num_), overflow,
+				  lhs / approx(rhs));
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t& operator+=(rational_t& lhs, I rhs)
 	{
-		return !(lhs < rhs);
+		lhs = lhs + rhs;
+		return lhs;
 	}
 
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t& operator-=(rational_t& lhs, I rhs)
+	{
+		lhs = lhs - rhs;
+		return lhs;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t& operator*=(rational_t& lhs, I rhs)
+	{
+		lhs = lhs * rhs;
+		return lhs;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr rational_t& operator/=(rational_t& lhs, I rhs)
+	{
+		lhs = lhs / rhs;
+		return lhs;
+	}
+
+	// an integer equals only a rational with denominator 1
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator==(rational_t const& lhs, I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		if (lazy)
+			return !compare_integer(lhs, rhs);
+		return lhs.denom_ == 1 && detail::in_range<IntT>(rhs)
+		       && lhs.num_ == IntT(rhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator==(I lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return rhs == lhs;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator!=(rational_t const& lhs, I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return !(lhs == rhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator!=(I lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return !(rhs == lhs);
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator<(rational_t const& lhs, I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(lhs, rhs) < 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator<(I lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(rhs, lhs) > 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator>(rational_t const& lhs, I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(lhs, rhs) > 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator>(I lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(rhs, lhs) < 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator<=(rational_t const& lhs, I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(lhs, rhs) <= 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator<=(I lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(rhs, lhs) >= 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator>=(rational_t const& lhs, I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(lhs, rhs) >= 0;
+	}
+
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr bool operator>=(I lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(rhs, lhs) <= 0;
+	}
+
+#ifdef __cpp_impl_three_way_comparison
+	template <typename I, typename = enable_if_integer<I>>
+	friend constexpr std::strong_ordering operator<=>(rational_t const& lhs,
+							  I rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare_integer(lhs, rhs) <=> 0;
+	}
+#endif
+
+	friend constexpr bool operator<(rational_t const& lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare(lhs, rhs) < 0;
+	}
+
+	friend constexpr bool operator>(rational_t const& lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare(lhs, rhs) > 0;
+	}
+
+	friend constexpr bool operator<=(rational_t const& lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare(lhs, rhs) <= 0;
+	}
+
+	friend constexpr bool operator>=(rational_t const& lhs, rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare(lhs, rhs) >= 0;
+	}
+
+#ifdef __cpp_impl_three_way_comparison
+	friend constexpr std::strong_ordering operator<=>(rational_t const& lhs,
+						rational_t const& rhs)
+	noexcept(detail::is_builtin_integer<IntT>::value)
+	{
+		return compare(lhs, rhs) <=> 0;
+	}
+#endif
+
 
 	// GCD, greatest common denominator
-	static inline int gcd(IntT a, IntT b) noexcept
+	static constexpr IntT gcd(IntT a, IntT b)
+	noexcept(detail::is_builtin_integer<IntT>::value)
 	{
-		return std::experimental::gcd(a, b);
-		a = std::abs(a);
-		b = std::abs(b);
-		return b ? gcd(b, a % b) : a;
+		using lab::gcd;	// or the one found by ADL
+		return gcd(a, b);
 	}
 };
 
 typedef rational_t<int> rational;
 
+namespace detail {
+
+struct rational_access {
+	// num / denom with denom > 0, coprime unless normalization is lazy
+	template<typename Rational>
+	static constexpr Rational make(typename Rational::int_type num,
+				       typename Rational::int_type denom) noexcept
+	{
+		return Rational(num, denom, typename Rational::raw_tag());
+	}
+
+	// sign of lhs - rhs, exactly
+	template<typename Rational>
+	static constexpr int compare(Rational const& lhs, Rational const& rhs)
+	noexcept(noexcept(lhs < rhs))
+	{
+		return Rational::compare(lhs, rhs);
+	}
+};
+
+} // namespace detail
+
+namespace detail {
+
+// Exact value of a decimal literal: digits with at most one point and
+// optional ' separators. Errors throw, which makes a constant evaluation
+// ill-formed, so a malformed literal does not compile.
+template <typename IntT>
+constexpr rational_t<IntT> parse_literal(char const* str, size_t len)
+{
+	IntT num = 0, denom = 1;
+	bool point = false;
+
+	for (size_t i = 0; i != len; ++i) {
+		char const c = str[i];
+		if (c == '\'')
+			continue;
+		if (c == '.' && !point) {
+			point = true;
+			continue;
+		}
+		if (c < '0' || c > '9')
+			throw std::invalid_argument("Invalid rational literal.");
+		if (mul_overflow(num, IntT(10), num) ||
+		    add_overflow(num, IntT(c - '0'), num) ||
+		    (point && mul_overflow(denom, IntT(10), denom)))
+			throw std::overflow_error("Rational overflow.");
+	}
+	return rational_t<IntT>(num, denom);
+}
+
+} // namespace detail
+
+inline namespace literals {
+
+/**
+ * @brief 3_r is rational(3, 1), 0.25_r is rational(1, 4); the value is
+ * computed at compile time. A negative constant is -3_r.
+ */
+template <char... Chars>
+constexpr rational operator""_r()
+{
+	constexpr char str[] = {Chars...};
+	constexpr rational value = detail::parse_literal<int>(str,
+							      sizeof...(Chars));
+	return value;
+}
+
+} // namespace literals
+
 } // namespace lab
 
+namespace std {
+
+/**
+ * @brief Hashes the reduced form, so equal values hash equally under lazy
+ * normalization too.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+struct hash<lab::rational_t<IntT, OverflowPolicy, NormalizationPolicy>> {
+	size_t operator()(lab::rational_t<IntT, OverflowPolicy,
+				NormalizationPolicy> const& number) const
+	noexcept(lab::detail::is_builtin_integer<IntT>::value)
+	{
+		auto const reduced = number.normalized();
+		return static_cast<size_t>(lab::detail::hash_pair(
+					reduced.num(), reduced.denom()));
+	}
+};
+
+} // namespace std
+
 #endif // RATIONAL_H
@@ -0,0 +1,626 @@
+#ifndef RATIONAL_BATCH_H
+#define RATIONAL_BATCH_H
+
+#include <climits>
+#include <stdexcept>
+
+#include "rational.h"
+#include "rational_soa_vector.h"
+#include "vector.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LAB_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lab {
+// Element-wise arithmetic over arrays of rational numbers.
+//
+// The arrays are given column-wise (numerators and denominators apart, as
+// stored by rational_soa_vector), so that lanes map to plain integers.
+// For rational_t<int> the cross-multiplications, sign normalization and
+// gcd reduction run in AVX2 or AVX-512 registers, chosen at run time;
+// other component types and CPUs without AVX2 use the scalar operators.
+// The vector lanes form the cross products exactly in 64 bits. A block in
+// which some unreduced numerator or denominator does not fit int is redone
+// by the scalar operators, which reduce it in their wide type or report it
+// through their overflow policy, so the results never depend on the
+// instruction set or on the position of an element.
+namespace batch {
+
+enum operation { op_add, op_sub, op_mul, op_div };
+
+namespace detail {
+
+template<typename IntT>
+void apply_scalar(operation op, const IntT* an, const IntT* ad,
+		  const IntT* bn, const IntT* bd, IntT* on, IntT* od,
+		  size_t n)
+{
+	typedef rational_t<IntT> rational_type;
+
+	for (size_t i = 0; i != n; ++i) {
+		rational_type const a(an[i], ad[i]);
+		rational_type const b(bn[i], bd[i]);
+		rational_type r;
+		switch (op) {
+		case op_add: r = a + b; break;
+		case op_sub: r = a - b; break;
+		case op_mul: r = a * b; break;
+		case op_div: r = a / b; break;
+		}
+		on[i] = r.num();
+		od[i] = r.denom();
+	}
+}
+
+// components are reduced with positive denominators
+template<typename IntT>
+void to_double_scalar(const IntT* num, const IntT* den, double* out,
+		      size_t n)
+{
+	typedef rational_t<IntT> rational_type;
+
+	for (size_t i = 0; i != n; ++i)
+		out[i] = lab::detail::rational_access::make<rational_type>(
+				num[i], den[i]).template to_floating<double>();
+}
+
+#ifdef LAB_BATCH_X86
+
+// Count trailing zeros of every lane: isolate the lowest set bit and read
+// its position off the exponent of the (exact) float conversion. Zero lanes
+// give a count above 31, which makes variable shifts produce 0.
+__attribute__((target("avx2")))
+inline __m256i ctz_epi32(__m256i x)
+{
+	__m256i const low = _mm256_and_si256(x,
+				_mm256_sub_epi32(_mm256_setzero_si256(), x));
+	__m256i e = _mm256_srli_epi32(
+			_mm256_castps_si256(_mm256_cvtepi32_ps(low)), 23);
+	e = _mm256_and_si256(e, _mm256_set1_epi32(0xff));
+	return _mm256_sub_epi32(e, _mm256_set1_epi32(127));
+}
+
+// Stein's binary gcd on 8 unsigned lanes at once.
+__attribute__((target("avx2")))
+inline __m256i gcd_epi32(__m256i u, __m256i v)
+{
+	__m256i const zero = _mm256_setzero_si256();
+	__m256i const shift = ctz_epi32(_mm256_or_si256(u, v));
+
+	__m256i const u_zero = _mm256_cmpeq_epi32(u, zero);
+	u = _mm256_blendv_epi8(u, v, u_zero);
+	v = _mm256_andnot_si256(u_zero, v);
+	u = _mm256_srlv_epi32(u, ctz_epi32(u));
+
+	for (;;) {
+		__m256i const active = _mm256_xor_si256(
+					_mm256_cmpeq_epi32(v, zero),
+					_mm256_set1_epi32(-1));
+		if (_mm256_testz_si256(active, active))
+			break;
+		v = _mm256_srlv_epi32(v, ctz_epi32(v));
+		__m256i const lo = _mm256_min_epu32(u, v);
+		__m256i const hi = _mm256_max_epu32(u, v);
+		u = _mm256_blendv_epi8(u, lo, active);
+		v = _mm256_and_si256(_mm256_sub_epi32(hi, lo), active);
+	}
+	return _mm256_sllv_epi32(u, shift);
+}
+
+// Exact division of 8 lanes known to be divisible, through doubles.
+__attribute__((target("avx2")))
+inline __m256i div_exact_epi32(__m256i x, __m256i d)
+{
+	__m128i const lo = _mm256_cvttpd_epi32(_mm256_div_pd(
+		_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)),
+		_mm256_cvtepi32_pd(_mm256_castsi256_si128(d))));
+	__m128i const hi = _mm256_cvttpd_epi32(_mm256_div_pd(
+		_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)),
+		_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1))));
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Exact products of the signed 32-bit lanes of a and b, as 64-bit lanes:
+// those of the even lanes in even, those of the odd lanes in odd.
+__attribute__((target("avx2")))
+inline void mul_wide_epi32(__m256i a, __m256i b, __m256i& even,
+			   __m256i& odd)
+{
+	even = _mm256_mul_epi32(a, b);
+	odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+			       _mm256_srli_epi64(b, 32));
+}
+
+// Moves the sign of the 64-bit lanes of den to num; returns the mask of
+// the lanes where either of them does not fit int.
+__attribute__((target("avx2")))
+inline __m256i normalize_epi64(__m256i& num, __m256i& den)
+{
+	__m256i const neg = _mm256_cmpgt_epi64(_mm256_setzero_si256(), den);
+	num = _mm256_sub_epi64(_mm256_xor_si256(num, neg), neg);
+	den = _mm256_sub_epi64(_mm256_xor_si256(den, neg), neg);
+
+	__m256i const max = _mm256_set1_epi64x(INT_MAX);
+	__m256i const min = _mm256_set1_epi64x(INT_MIN);
+	return _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpgt_epi64(num, max),
+				_mm256_cmpgt_epi64(min, num)),
+		_mm256_cmpgt_epi64(den, max));
+}
+
+// The unreduced a op b of 8 lanes, sign on the numerator; false if some
+// lane does not fit int. The operands are reduced with positive
+// denominators, so every sum of two products fits 64 bits.
+__attribute__((target("avx2")))
+inline bool combine_epi32(operation op, __m256i a_n, __m256i a_d,
+			  __m256i b_n, __m256i b_d, __m256i& num,
+			  __m256i& den)
+{
+	__m256i num_even, num_odd, den_even, den_odd;
+
+	switch (op) {
+	case op_add:
+	case op_sub: {
+		__m256i x_even, x_odd, y_even, y_odd;
+		mul_wide_epi32(a_n, b_d, x_even, x_odd);
+		mul_wide_epi32(b_n, a_d, y_even, y_odd);
+		if (op == op_add) {
+			num_even = _mm256_add_epi64(x_even, y_even);
+			num_odd = _mm256_add_epi64(x_odd, y_odd);
+		} else {
+			num_even = _mm256_sub_epi64(x_even, y_even);
+			num_odd = _mm256_sub_epi64(x_odd, y_odd);
+		}
+		mul_wide_epi32(a_d, b_d, den_even, den_odd);
+		break;
+	}
+	case op_mul:
+		mul_wide_epi32(a_n, b_n, num_even, num_odd);
+		mul_wide_epi32(a_d, b_d, den_even, den_odd);
+		break;
+	default:
+		mul_wide_epi32(a_n, b_d, num_even, num_odd);
+		mul_wide_epi32(a_d, b_n, den_even, den_odd);
+		break;
+	}
+
+	__m256i const overflow = _mm256_or_si256(
+		normalize_epi64(num_even, den_even),
+		normalize_epi64(num_odd, den_odd));
+	if (!_mm256_testz_si256(overflow, overflow))
+		return false;
+	num = _mm256_blend_epi32(num_even, _mm256_slli_epi64(num_odd, 32),
+				 0xAA);
+	den = _mm256_blend_epi32(den_even, _mm256_slli_epi64(den_odd, 32),
+				 0xAA);
+	return true;
+}
+
+__attribute__((target("avx2")))
+inline size_t apply_avx2(operation op, const int* an, const int* ad,
+			 const int* bn, const int* bd, int* on, int* od,
+			 size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i const a_n = _mm256_loadu_si256((const __m256i*)(an + i));
+		__m256i const a_d = _mm256_loadu_si256((const __m256i*)(ad + i));
+		__m256i const b_n = _mm256_loadu_si256((const __m256i*)(bn + i));
+		__m256i const b_d = _mm256_loadu_si256((const __m256i*)(bd + i));
+		__m256i num, den;
+
+		if (!combine_epi32(op, a_n, a_d, b_n, b_d, num, den)) {
+			apply_scalar(op, an + i, ad + i, bn + i, bd + i,
+				     on + i, od + i, 8);
+			continue;
+		}
+
+		__m256i const g = gcd_epi32(_mm256_abs_epi32(num), den);
+		_mm256_storeu_si256((__m256i*)(on + i), div_exact_epi32(num, g));
+		_mm256_storeu_si256((__m256i*)(od + i), div_exact_epi32(den, g));
+	}
+	return i;
+}
+
+// int components are exact in double, so one division rounds correctly.
+__attribute__((target("avx2")))
+inline size_t to_double_avx2(const int* num, const int* den, double* out,
+			     size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i const x = _mm256_loadu_si256((const __m256i*)(num + i));
+		__m256i const d = _mm256_loadu_si256((const __m256i*)(den + i));
+		_mm256_storeu_pd(out + i, _mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)),
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(d))));
+		_mm256_storeu_pd(out + i + 4, _mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)),
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1))));
+	}
+	return i;
+}
+
+// GCC 12 reports the placeholder operand of AVX-512 intrinsics as
+// maybe-uninitialized once they are inlined (GCC PR 105593).
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+inline __m512i ctz_epi32(__m512i x)
+{
+	__m512i const low = _mm512_and_si512(x,
+				_mm512_sub_epi32(_mm512_setzero_si512(), x));
+	__m512i e = _mm512_srli_epi32(
+			_mm512_castps_si512(_mm512_cvtepi32_ps(low)), 23);
+	e = _mm512_and_si512(e, _mm512_set1_epi32(0xff));
+	return _mm512_sub_epi32(e, _mm512_set1_epi32(127));
+}
+
+__attribute__((target("avx512f")))
+inline __m512i gcd_epi32(__m512i u, __m512i v)
+{
+	__m512i const zero = _mm512_setzero_si512();
+	__m512i const shift = ctz_epi32(_mm512_or_si512(u, v));
+
+	__mmask16 const u_zero = _mm512_cmpeq_epi32_mask(u, zero);
+	u = _mm512_mask_blend_epi32(u_zero, u, v);
+	v = _mm512_maskz_mov_epi32(static_cast<__mmask16>(~u_zero), v);
+	u = _mm512_srlv_epi32(u, ctz_epi32(u));
+
+	for (;;) {
+		__mmask16 const active = _mm512_cmpneq_epi32_mask(v, zero);
+		if (!active)
+			break;
+		v = _mm512_srlv_epi32(v, ctz_epi32(v));
+		__m512i const lo = _mm512_min_epu32(u, v);
+		__m512i const hi = _mm512_max_epu32(u, v);
+		u = _mm512_mask_mov_epi32(u, active, lo);
+		v = _mm512_maskz_sub_epi32(active, hi, lo);
+	}
+	return _mm512_sllv_epi32(u, shift);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i div_exact_epi32(__m512i x, __m512i d)
+{
+	__m256i const lo = _mm512_cvttpd_epi32(_mm512_div_pd(
+		_mm512_cvtepi32_pd(_mm512_castsi512_si256(x)),
+		_mm512_cvtepi32_pd(_mm512_castsi512_si256(d))));
+	__m256i const hi = _mm512_cvttpd_epi32(_mm512_div_pd(
+		_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(x, 1)),
+		_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(d, 1))));
+	return _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+}
+
+__attribute__((target("avx512f")))
+inline void mul_wide_epi32(__m512i a, __m512i b, __m512i& even,
+			   __m512i& odd)
+{
+	even = _mm512_mul_epi32(a, b);
+	odd = _mm512_mul_epi32(_mm512_srli_epi64(a, 32),
+			       _mm512_srli_epi64(b, 32));
+}
+
+__attribute__((target("avx512f")))
+inline __mmask8 normalize_epi64(__m512i& num, __m512i& den)
+{
+	__m512i const zero = _mm512_setzero_si512();
+	__mmask8 const neg = _mm512_cmplt_epi64_mask(den, zero);
+	num = _mm512_mask_sub_epi64(num, neg, zero, num);
+	den = _mm512_mask_sub_epi64(den, neg, zero, den);
+
+	__m512i const max = _mm512_set1_epi64(INT_MAX);
+	__m512i const min = _mm512_set1_epi64(INT_MIN);
+	return static_cast<__mmask8>(_mm512_cmpgt_epi64_mask(num, max)
+				     | _mm512_cmplt_epi64_mask(num, min)
+				     | _mm512_cmpgt_epi64_mask(den, max));
+}
+
+__attribute__((target("avx512f")))
+inline bool combine_epi32(operation op, __m512i a_n, __m512i a_d,
+			  __m512i b_n, __m512i b_d, __m512i& num,
+			  __m512i& den)
+{
+	__m512i num_even, num_odd, den_even, den_odd;
+
+	switch (op) {
+	case op_add:
+	case op_sub: {
+		__m512i x_even, x_odd, y_even, y_odd;
+		mul_wide_epi32(a_n, b_d, x_even, x_odd);
+		mul_wide_epi32(b_n, a_d, y_even, y_odd);
+		if (op == op_add) {
+			num_even = _mm512_add_epi64(x_even, y_even);
+			num_odd = _mm512_add_epi64(x_odd, y_odd);
+		} else {
+			num_even = _mm512_sub_epi64(x_even, y_even);
+			num_odd = _mm512_sub_epi64(x_odd, y_odd);
+		}
+		mul_wide_epi32(a_d, b_d, den_even, den_odd);
+		break;
+	}
+	case op_mul:
+		mul_wide_epi32(a_n, b_n, num_even, num_odd);
+		mul_wide_epi32(a_d, b_d, den_even, den_odd);
+		break;
+	default:
+		mul_wide_epi32(a_n, b_d, num_even, num_odd);
+		mul_wide_epi32(a_d, b_n, den_even, den_odd);
+		break;
+	}
+
+	if (normalize_epi64(num_even, den_even)
+	    | normalize_epi64(num_odd, den_odd))
+		return false;
+	num = _mm512_mask_blend_epi32(0xAAAA, num_even,
+				      _mm512_slli_epi64(num_odd, 32));
+	den = _mm512_mask_blend_epi32(0xAAAA, den_even,
+				      _mm512_slli_epi64(den_odd, 32));
+	return true;
+}
+
+__attribute__((target("avx512f")))
+inline size_t apply_avx512(operation op, const int* an, const int* ad,
+			   const int* bn, const int* bd, int* on, int* od,
+			   size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512i const a_n = _mm512_loadu_si512(an + i);
+		__m512i const a_d = _mm512_loadu_si512(ad + i);
+		__m512i const b_n = _mm512_loadu_si512(bn + i);
+		__m512i const b_d = _mm512_loadu_si512(bd + i);
+		__m512i num, den;
+
+		if (!combine_epi32(op, a_n, a_d, b_n, b_d, num, den)) {
+			apply_scalar(op, an + i, ad + i, bn + i, bd + i,
+				     on + i, od + i, 16);
+			continue;
+		}
+
+		__m512i const g = gcd_epi32(_mm512_abs_epi32(num), den);
+		_mm512_storeu_si512(on + i, div_exact_epi32(num, g));
+		_mm512_storeu_si512(od + i, div_exact_epi32(den, g));
+	}
+	return i;
+}
+
+__attribute__((target("avx512f")))
+inline size_t to_double_avx512(const int* num, const int* den, double* out,
+			       size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512i const x = _mm512_loadu_si512(num + i);
+		__m512i const d = _mm512_loadu_si512(den + i);
+		_mm512_storeu_pd(out + i, _mm512_div_pd(
+			_mm512_cvtepi32_pd(_mm512_castsi512_si256(x)),
+			_mm512_cvtepi32_pd(_mm512_castsi512_si256(d))));
+		_mm512_storeu_pd(out + i + 8, _mm512_div_pd(
+			_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(x, 1)),
+			_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(d, 1))));
+	}
+	return i;
+}
+
+#pragma GCC diagnostic pop
+
+enum isa { isa_scalar, isa_avx2, isa_avx512 };
+
+inline isa detect_isa() noexcept
+{
+	static isa const level = __builtin_cpu_supports("avx512f") ? isa_avx512
+			       : __builtin_cpu_supports("avx2") ? isa_avx2
+			       : isa_scalar;
+	return level;
+}
+
+#endif // LAB_BATCH_X86
+
+template<typename IntT>
+void apply(operation op, const IntT* an, const IntT* ad,
+	   const IntT* bn, const IntT* bd, IntT* on, IntT* od, size_t n)
+{
+	apply_scalar(op, an, ad, bn, bd, on, od, n);
+}
+
+inline void apply(operation op, const int* an, const int* ad,
+		  const int* bn, const int* bd, int* on, int* od, size_t n)
+{
+	size_t done = 0;
+#ifdef LAB_BATCH_X86
+	switch (detect_isa()) {
+	case isa_avx512:
+		done = apply_avx512(op, an, ad, bn, bd, on, od, n);
+		break;
+	case isa_avx2:
+		done = apply_avx2(op, an, ad, bn, bd, on, od, n);
+		break;
+	default:
+		break;
+	}
+#endif
+	apply_scalar(op, an + done, ad + done, bn + done, bd + done,
+		     on + done, od + done, n - done);
+}
+
+template<typename IntT>
+void to_double(const IntT* num, const IntT* den, double* out, size_t n)
+{
+	to_double_scalar(num, den, out, n);
+}
+
+inline void to_double(const int* num, const int* den, double* out, size_t n)
+{
+	size_t done = 0;
+#ifdef LAB_BATCH_X86
+	switch (detect_isa()) {
+	case isa_avx512:
+		done = to_double_avx512(num, den, out, n);
+		break;
+	case isa_avx2:
+		done = to_double_avx2(num, den, out, n);
+		break;
+	default:
+		break;
+	}
+#endif
+	to_double_scalar(num + done, den + done, out + done, n - done);
+}
+
+} // namespace detail
+
+/**
+ * @brief Computes out[i] = a[i] op b[i] for i in [0, n).
+ *
+ * Every column holds n components; outputs may alias inputs. Division by
+ * a zero element throws std::invalid_argument before anything is written.
+ *
+ * The components must be reduced with positive denominators, as stored by
+ * rational_soa_vector.
+ */
+template<typename IntT>
+void apply(operation op, const IntT* an, const IntT* ad,
+	   const IntT* bn, const IntT* bd, IntT* on, IntT* od, size_t n)
+{
+	if (op == op_div)
+		for (size_t i = 0; i != n; ++i)
+			if (!bn[i])
+				throw std::invalid_argument("Denominator can't be 0.");
+	detail::apply(op, an, ad, bn, bd, on, od, n);
+}
+
+/**
+ * @brief Computes out[i] = a[i] op b[i] over whole vectors.
+ *
+ * a and b must have the same size; out is resized to match. The vectors
+ * hold reduced components with positive denominators, as the raw-pointer
+ * overload requires.
+ */
+template<typename IntT>
+void apply(operation op, rational_soa_vector<IntT> const& a,
+	   rational_soa_vector<IntT> const& b,
+	   rational_soa_vector<IntT>& out)
+{
+	if (a.size() != b.size())
+		throw std::invalid_argument("Sizes of operands differ.");
+	if (out.size() != a.size())
+		out = rational_soa_vector<IntT>(a.size());
+	apply(op, a.num_data(), a.denom_data(), b.num_data(), b.denom_data(),
+	      out.num_data(), out.denom_data(), a.size());
+}
+
+template<typename IntT>
+void add(rational_soa_vector<IntT> const& a,
+	 rational_soa_vector<IntT> const& b, rational_soa_vector<IntT>& out)
+{
+	apply(op_add, a, b, out);
+}
+
+template<typename IntT>
+void sub(rational_soa_vector<IntT> const& a,
+	 rational_soa_vector<IntT> const& b, rational_soa_vector<IntT>& out)
+{
+	apply(op_sub, a, b, out);
+}
+
+template<typename IntT>
+void mul(rational_soa_vector<IntT> const& a,
+	 rational_soa_vector<IntT> const& b, rational_soa_vector<IntT>& out)
+{
+	apply(op_mul, a, b, out);
+}
+
+template<typename IntT>
+void div(rational_soa_vector<IntT> const& a,
+	 rational_soa_vector<IntT> const& b, rational_soa_vector<IntT>& out)
+{
+	apply(op_div, a, b, out);
+}
+
+/**
+ * @brief Computes out[i] = num[i] / denom[i] for i in [0, n), rounded to
+ * the nearest double.
+ *
+ * The components must be reduced with positive denominators, as stored by
+ * rational_soa_vector.
+ */
+template<typename IntT>
+void to_double(const IntT* num, const IntT* denom, double* out, size_t n)
+{
+	detail::to_double(num, denom, out, n);
+}
+
+/**
+ * @brief Converts a whole vector; out is resized to match.
+ */
+template<typename IntT>
+void to_double(rational_soa_vector<IntT> const& a, vector<double>& out)
+{
+	if (out.size() != a.size())
+		out = vector<double>(a.size());
+	to_double(a.num_data(), a.denom_data(), out.data(), a.size());
+}
+
+/**
+ * @brief Computes num[i] / denom[i] = rational_t<IntT>::from_double(x[i],
+ * max_denom) for i in [0, n): the best approximations with denominators of
+ * at most max_denom, reduced, with positive denominators.
+ *
+ * The continued fraction expansion branches per element, so this is a
+ * scalar loop; it is here to fill rational_soa_vector columns directly.
+ */
+template<typename IntT>
+void from_double(const double* x, IntT* num, IntT* denom, size_t n,
+		 IntT max_denom)
+{
+	for (size_t i = 0; i != n; ++i) {
+		rational_t<IntT> const value =
+			rational_t<IntT>::from_double(x[i], max_denom);
+		num[i] = value.num();
+		denom[i] = value.denom();
+	}
+}
+
+/**
+ * @brief The same with rational_t<IntT>::from_double(x[i]): any denominator
+ * IntT can hold, and the exact values for unbounded IntT such as bigint.
+ */
+template<typename IntT>
+void from_double(const double* x, IntT* num, IntT* denom, size_t n)
+{
+	for (size_t i = 0; i != n; ++i) {
+		rational_t<IntT> const value =
+			rational_t<IntT>::from_double(x[i]);
+		num[i] = value.num();
+		denom[i] = value.denom();
+	}
+}
+
+/**
+ * @brief Converts n doubles into out, which is resized to match.
+ */
+template<typename IntT>
+void from_double(const double* x, size_t n, rational_soa_vector<IntT>& out,
+		 IntT max_denom)
+{
+	if (out.size() != n)
+		out = rational_soa_vector<IntT>(n);
+	from_double(x, out.num_data(), out.denom_data(), n, max_denom);
+}
+
+template<typename IntT>
+void from_double(const double* x, size_t n, rational_soa_vector<IntT>& out)
+{
+	if (out.size() != n)
+		out = rational_soa_vector<IntT>(n);
+	from_double(x, out.num_data(), out.denom_data(), n);
+}
+
+} // namespace batch
+} // namespace lab
+
+#endif // RATIONAL_BATCH_H
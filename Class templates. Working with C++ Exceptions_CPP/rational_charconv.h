@@ -0,0 +1,525 @@
+#ifndef RATIONAL_CHARCONV_H
+#define RATIONAL_CHARCONV_H
+
+#include <charconv>             // std::from_chars_result, std::to_chars_result
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>         // std::errc
+#include <type_traits>
+#if __has_include(<version>)
+#include <version>
+#endif
+#ifdef __cpp_lib_format
+#include <format>
+#include <sstream>
+#include <string_view>
+#endif
+
+#include "gcd.h"
+#include "overflow.h"
+#include "rational.h"
+#include "vector.h"
+
+namespace lab {
+// Text input and output of rational numbers.
+//
+// from_chars() reads one number in the style of std::from_chars: no
+// leading whitespace, no '+', no locale, no allocation. The accepted forms
+// are an integer ("-7"), a decimal ("0.125", "-.5", "3.") and a fraction
+// ("22/7", "22 / 7", as written by operator<<; blanks around the slash
+// only, the sign on the numerator only). The value is reduced.
+//
+// Digits are accumulated in the widest built-in integer (in IntT itself
+// when IntT is unbounded), eight at a time where the input allows, and
+// checked against IntT once, after the reduction: "4294967296/4294967297"
+// is out of range for int, "2147483648/2" is not.
+//
+// to_chars() writes the reduced number as operator<< does ("-22 / 7"),
+// without streams: the digit count comes from the bit width, and the digits
+// are written back to front, two per step from a table of pairs. A buffer
+// of max_rational_chars<IntT> characters holds any number.
+
+namespace detail {
+
+constexpr bool is_digit(char c) noexcept
+{
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+constexpr bool is_blank(char c) noexcept
+{
+	return c == ' ' || c == '\t';
+}
+
+constexpr bool is_space(char c) noexcept
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+	       c == '\v' || c == '\f';
+}
+
+// Reads eight decimal digits at p into value, if they are all digits:
+// the bytes are validated and combined in one 64-bit word (pairs, then
+// quadruples, then the halves).
+inline bool eight_digits(const char* p, std::uint64_t& value) noexcept
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	std::uint64_t chunk;
+	std::memcpy(&chunk, p, sizeof(chunk));
+	if ((((chunk & 0xF0F0F0F0F0F0F0F0) |
+	      (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+	     != 0x3333333333333333))
+		return false;
+	chunk -= 0x3030303030303030;
+	chunk = chunk * 10 + (chunk >> 8);
+	chunk = (((chunk & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+		 (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32))))
+		>> 32;
+	value = chunk;
+	return true;
+#else
+	(void)p;
+	(void)value;
+	return false;
+#endif
+}
+
+template<typename UIntT>
+constexpr UIntT power_of_ten(int e, bool& overflow) noexcept(
+	is_builtin_integer<UIntT>::value)
+{
+	UIntT result = 1;
+	while (e--)
+		overflow |= mul_overflow(result, UIntT(10), result);
+	return result;
+}
+
+// Appends the decimal digits at [first, last) to value, in chunks of up to
+// 19 digits that fit into 64 bits. Returns the end of the digits and adds
+// their count to count; overflow is set if value leaves UIntT.
+template<typename UIntT>
+const char* parse_digits(const char* first, const char* last, UIntT& value,
+			 int& count, bool& overflow)
+{
+	for (;;) {
+		std::uint64_t chunk = 0, eight = 0;
+		int digits = 0;
+		while (digits <= 8 && last - first >= 8 &&
+		       eight_digits(first, eight)) {
+			chunk = chunk * 100000000 + eight;
+			digits += 8;
+			first += 8;
+		}
+		for (; digits != 19 && first != last && is_digit(*first);
+		     ++first, ++digits)
+			chunk = chunk * 10 + static_cast<unsigned>(*first - '0');
+		if (!digits)
+			return first;
+
+		count += digits;
+		if (value == UIntT(0)) {
+			if constexpr (is_builtin_integer<UIntT>::value)
+				value = static_cast<UIntT>(chunk);
+			else
+				value = UIntT(chunk);
+		} else {
+			UIntT const scale = power_of_ten<UIntT>(digits, overflow);
+			overflow |= mul_overflow(value, scale, value);
+			overflow |= add_overflow(value, UIntT(chunk), value);
+		}
+		if (digits != 19)
+			return first;
+	}
+}
+
+// "00" "01" ... "99"
+constexpr char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+constexpr std::uint64_t powers_of_ten[] = {
+	1ULL, 10ULL, 100ULL,
+	1000ULL, 10000ULL, 100000ULL,
+	1000000ULL, 10000000ULL, 100000000ULL,
+	1000000000ULL, 10000000000ULL, 100000000000ULL,
+	1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+	1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+	1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// Number of decimal digits of x: estimated from the bit width (log10(2)
+// is about 1233 / 4096) and corrected by one comparison, without a loop.
+// Setting the lowest bit changes no digit count and makes 0 count as 1.
+constexpr int count_digits(std::uint64_t x) noexcept
+{
+	x |= 1;
+	int const t = (64 - __builtin_clzll(x)) * 1233 >> 12;
+	return t + 1 - (x < powers_of_ten[t]);
+}
+
+// Writes exactly count digits of x (with leading zeros) at first. The loop
+// runs on the count, not on the value, so its branches are predictable.
+inline void write_digits(char* first, int count, std::uint64_t x) noexcept
+{
+	char* end = first + count;
+	for (; count >= 2; count -= 2) {
+		end -= 2;
+		std::memcpy(end, digit_pairs + x % 100 * 2, 2);
+		x /= 100;
+	}
+	if (count)
+		*--end = static_cast<char>('0' + x);
+}
+
+// Writes the decimal form of u at first; returns the end.
+template<typename UIntT>
+char* write_unsigned(char* first, UIntT u) noexcept
+{
+	if constexpr (sizeof(UIntT) > sizeof(std::uint64_t)) {
+		// 19 digits per 64-bit chunk below the leading one
+		std::uint64_t const chunk = powers_of_ten[19];
+		if (u >= chunk) {
+			first = write_unsigned(first,
+					       static_cast<UIntT>(u / chunk));
+			write_digits(first, 19,
+				     static_cast<std::uint64_t>(u % chunk));
+			return first + 19;
+		}
+	}
+	std::uint64_t const x = static_cast<std::uint64_t>(u);
+	int const count = count_digits(x);
+	write_digits(first, count, x);
+	return first + count;
+}
+
+template<typename IntT>
+char* write_integer(char* first, IntT x) noexcept
+{
+	typedef typename make_unsigned<IntT>::type unsigned_type;
+
+	*first = '-';
+	first += x < 0;
+	return write_unsigned(first, magnitude<unsigned_type>(x));
+}
+
+// "p / q" for reduced components, q > 0, into a buffer that holds it
+template<typename IntT>
+char* write_rational(char* first, IntT num, IntT denom) noexcept
+{
+	first = write_integer(first, num);
+	std::memcpy(first, " / ", 3);
+	return write_integer(first + 3, denom);
+}
+
+} // namespace detail
+
+/**
+ * @brief The longest text to_chars() writes for built-in components:
+ * "-2147483648 / 2147483647" for int.
+ */
+template<typename IntT>
+inline constexpr size_t max_rational_chars =
+	2 * (std::numeric_limits<IntT>::digits10 + 1) + 4;
+
+/**
+ * @brief Parses a rational number at the beginning of [first, last).
+ *
+ * On success value holds the reduced number and ptr points past it. If no
+ * number starts at first, ec is std::errc::invalid_argument and ptr is
+ * first; a zero denominator is reported the same way. If the number does
+ * not fit into IntT, ec is std::errc::result_out_of_range and ptr points
+ * past it. value is left unchanged on errors.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+std::from_chars_result from_chars(const char* first, const char* last,
+				  rational_t<IntT, OverflowPolicy,
+					     NormalizationPolicy>& value)
+{
+	typedef rational_t<IntT, OverflowPolicy, NormalizationPolicy>
+		rational_type;
+	typedef typename std::conditional<
+		detail::is_builtin_integer<IntT>::value,
+		detail::widest_uint, IntT>::type work_type;
+
+	const char* p = first;
+	bool const negative = p != last && *p == '-';
+	if (negative)
+		++p;
+
+	work_type num = 0, denom = 1;
+	int digits = 0;
+	bool overflow = false;
+	p = detail::parse_digits(p, last, num, digits, overflow);
+
+	if (p != last && *p == '.') {
+		// trailing zeros of the fraction do not change the value
+		const char* end = p + 1;
+		while (end != last && detail::is_digit(*end))
+			++end;
+		const char* significant = end;
+		while (significant != p + 1 && significant[-1] == '0')
+			--significant;
+		int fraction = 0;
+		detail::parse_digits(p + 1, significant, num, fraction,
+				     overflow);
+		if (!digits && end == p + 1)
+			return {first, std::errc::invalid_argument};
+		denom = detail::power_of_ten<work_type>(fraction, overflow);
+		p = end;
+	} else {
+		if (!digits)
+			return {first, std::errc::invalid_argument};
+		// a denominator, unless the slash is not followed by digits
+		const char* q = p;
+		while (q != last && detail::is_blank(*q))
+			++q;
+		if (q != last && *q == '/') {
+			++q;
+			while (q != last && detail::is_blank(*q))
+				++q;
+			work_type d = 0;
+			int denom_digits = 0;
+			const char* end = detail::parse_digits(q, last, d,
+							       denom_digits,
+							       overflow);
+			if (denom_digits) {
+				if (!overflow && d == work_type(0))
+					return {first,
+						std::errc::invalid_argument};
+				denom = d;
+				p = end;
+			}
+		}
+	}
+	if (overflow)
+		return {p, std::errc::result_out_of_range};
+
+	if (denom != work_type(1)) {
+		if constexpr (detail::is_builtin_integer<IntT>::value) {
+			// most inputs fit into 64 bits, where gcd and division
+			// are much cheaper than in 128
+			typedef std::uint64_t narrow_type;
+			narrow_type const limit =
+				std::numeric_limits<narrow_type>::max();
+			if (num <= limit && denom <= limit) {
+				narrow_type n = static_cast<narrow_type>(num);
+				narrow_type d = static_cast<narrow_type>(denom);
+				narrow_type const gcd_ = gcd(n, d);
+				num = n / gcd_;
+				denom = d / gcd_;
+			} else {
+				work_type const gcd_ = gcd(num, denom);
+				num /= gcd_;
+				denom /= gcd_;
+			}
+		} else {
+			using lab::gcd;	// or the one found by ADL
+			work_type const gcd_ = gcd(num, denom);
+			num /= gcd_;
+			denom /= gcd_;
+		}
+	}
+
+	if constexpr (std::numeric_limits<IntT>::is_bounded) {
+		// the magnitude of min is max + 1
+		work_type const max = static_cast<work_type>(
+			std::numeric_limits<IntT>::max());
+		if (denom > max || num > max + work_type(negative))
+			return {p, std::errc::result_out_of_range};
+		IntT const n = static_cast<IntT>(negative ? work_type(0) - num
+							  : num);
+		value = detail::rational_access::make<rational_type>(
+			n, static_cast<IntT>(denom));
+	} else {
+		value = detail::rational_access::make<rational_type>(
+			negative ? -num : num, denom);
+	}
+	return {p, std::errc()};
+}
+
+/**
+ * @brief Parses the whitespace-separated rational numbers of [first, last)
+ * (e.g. a file mapped into memory, one "p / q" per line) and appends them
+ * to out.
+ *
+ * Returns {last, errc()} when the whole buffer was read; otherwise ptr is
+ * the start of the first field that is not a number (invalid_argument) or
+ * does not fit (result_out_of_range), and out holds the numbers before it.
+ */
+template <typename Rational>
+std::from_chars_result parse_rationals(const char* first, const char* last,
+				       vector<Rational>& out)
+{
+	// one number per line is the common layout: reserve for it
+	size_t lines = 1;
+	for (const char* p = first;
+	     (p = static_cast<const char*>(
+		      std::memchr(p, '\n', static_cast<size_t>(last - p))));
+	     ++p)
+		++lines;
+	out.reserve(out.size() + lines);
+
+	for (;;) {
+		while (first != last && detail::is_space(*first))
+			++first;
+		if (first == last)
+			return {last, std::errc()};
+
+		Rational value;
+		std::from_chars_result const result = from_chars(first, last,
+								 value);
+		if (result.ec != std::errc())
+			return {first, result.ec};
+		if (result.ptr != last && !detail::is_space(*result.ptr))
+			return {first, std::errc::invalid_argument};
+		out.push_back(value);
+		first = result.ptr;
+	}
+}
+
+/**
+ * @brief Writes value, reduced, as "p / q" at the beginning of
+ * [first, last).
+ *
+ * Returns the end of the text, or {last, std::errc::value_too_large} if it
+ * does not fit, in which case the contents of the range are unspecified.
+ * Components without a fixed width are written with to_string().
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+std::to_chars_result to_chars(char* first, char* last,
+			      rational_t<IntT, OverflowPolicy,
+					 NormalizationPolicy> const& value)
+{
+	auto const reduced = value.normalized();
+
+	if constexpr (detail::is_builtin_integer<IntT>::value) {
+		if (last - first >= static_cast<std::ptrdiff_t>(
+					max_rational_chars<IntT>))
+			return {detail::write_rational(first, reduced.num(),
+						       reduced.denom()),
+				std::errc()};
+		char buffer[max_rational_chars<IntT>];
+		size_t const size = static_cast<size_t>(
+			detail::write_rational(buffer, reduced.num(),
+					       reduced.denom()) - buffer);
+		if (size > static_cast<size_t>(last - first))
+			return {last, std::errc::value_too_large};
+		std::memcpy(first, buffer, size);
+		return {first + size, std::errc()};
+	} else {
+		using std::to_string;	// or the one found by ADL
+		std::string const text = to_string(reduced.num()) + " / "
+					 + to_string(reduced.denom());
+		if (text.size() > static_cast<size_t>(last - first))
+			return {last, std::errc::value_too_large};
+		std::memcpy(first, text.data(), text.size());
+		return {first + text.size(), std::errc()};
+	}
+}
+
+namespace batch {
+
+/**
+ * @brief Writes num[i] / denom[i] for i in [0, n), each followed by
+ * separator, into one buffer.
+ *
+ * The components must be reduced with positive denominators, as stored by
+ * rational_soa_vector. A buffer of n * (max_rational_chars<IntT> + 1)
+ * characters always suffices; while that much room is left the numbers are
+ * written without bounds checks. Returns the end of the text, or
+ * {last, std::errc::value_too_large} if the buffer is too small.
+ */
+template<typename IntT>
+std::to_chars_result to_chars(const IntT* num, const IntT* denom, size_t n,
+			      char* first, char* last, char separator = '\n')
+{
+	static_assert(lab::detail::is_builtin_integer<IntT>::value,
+		      "Built-in components required.");
+	std::ptrdiff_t constexpr room = max_rational_chars<IntT> + 1;
+
+	for (size_t i = 0; i != n; ++i) {
+		if (last - first >= room) {
+			first = lab::detail::write_rational(first, num[i],
+							    denom[i]);
+		} else {
+			char buffer[room];
+			char* const end = lab::detail::write_rational(
+						buffer, num[i], denom[i]);
+			if (end - buffer >= last - first)
+				return {last, std::errc::value_too_large};
+			std::memcpy(first, buffer,
+				    static_cast<size_t>(end - buffer));
+			first += end - buffer;
+		}
+		*first++ = separator;
+	}
+	return {first, std::errc()};
+}
+
+/**
+ * @brief The same for an array of rational_t, e.g. vector<rational>::data().
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+std::to_chars_result to_chars(rational_t<IntT, OverflowPolicy,
+					 NormalizationPolicy> const* values,
+			      size_t n, char* first, char* last,
+			      char separator = '\n')
+{
+	for (size_t i = 0; i != n; ++i) {
+		std::to_chars_result const result = lab::to_chars(first, last,
+								  values[i]);
+		if (result.ec != std::errc() || result.ptr == last)
+			return {last, std::errc::value_too_large};
+		first = result.ptr;
+		*first++ = separator;
+	}
+	return {first, std::errc()};
+}
+
+} // namespace batch
+
+} // namespace lab
+
+#ifdef __cpp_lib_format
+namespace std {
+
+/**
+ * @brief std::format("{:>12}", r) formats r as operator<< does; the
+ * specifications of strings (fill, alignment, width) apply to the text.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+struct formatter<lab::rational_t<IntT, OverflowPolicy, NormalizationPolicy>>
+	: formatter<string_view> {
+	template <typename FormatContext>
+	auto format(lab::rational_t<IntT, OverflowPolicy,
+				    NormalizationPolicy> const& value,
+		    FormatContext& ctx) const
+	{
+		if constexpr (lab::detail::is_builtin_integer<IntT>::value) {
+			char buffer[lab::max_rational_chars<IntT>];
+			to_chars_result const result = lab::to_chars(
+				buffer, buffer + sizeof(buffer), value);
+			return formatter<string_view>::format(
+				string_view(buffer, static_cast<size_t>(
+					    result.ptr - buffer)), ctx);
+		} else {
+			ostringstream os;
+			os << value;
+			return formatter<string_view>::format(os.str(), ctx);
+		}
+	}
+};
+
+} // namespace std
+#endif
+
+#endif // RATIONAL_CHARCONV_H
@@ -0,0 +1,371 @@
+#ifndef RATIONAL_EXPR_H
+#define RATIONAL_EXPR_H
+
+#include <limits>
+#include <stdexcept>            // std::invalid_argument
+#include <type_traits>
+
+#include "rational.h"
+
+namespace lab {
+
+// Expression templates for rational_t.
+//
+// fused(a) + b * c - d does not compute a normalized temporary per
+// operator: it records the expression tree and evaluates it when converted
+// to rational_t, in one pass of cross-multiplications over an accumulator
+// type and a single gcd at the end.
+//
+// Every node knows at compile time how many bits its unreduced numerator
+// and denominator can take. A node whose bound exceeds the accumulator is
+// evaluated eagerly, with the regular rational_t operators applied to its
+// (possibly fused) operands, so the result is the same either way.
+//
+// An expression starts with fused(); an operator applied to an expression
+// and a rational_t or another expression continues it. Note that in
+// fused(a) + b * c the product b * c is an ordinary rational_t operation,
+// write fused(a) + fused(b) * c to fuse it as well.
+
+namespace detail {
+
+// Fused evaluation runs in the widest built-in integer, or in IntT itself
+// when IntT is unbounded.
+template<typename IntT>
+struct fused_type {
+	typedef typename std::conditional<std::numeric_limits<IntT>::is_bounded,
+					  widest_int, IntT>::type type;
+	static constexpr int digits = std::numeric_limits<IntT>::is_bounded
+				      ? std::numeric_limits<widest_int>::digits
+				      : std::numeric_limits<int>::max();
+};
+
+constexpr int max_bits(int a, int b) noexcept { return a > b ? a : b; }
+
+// Divides num and denom by their gcd. The bit bounds are worst cases:
+// when both fit into long long at run time, the gcd and the divisions
+// avoid the slower __int128 arithmetic.
+template<typename AccT>
+void reduce_fused(AccT& num, AccT& denom)
+{
+	using lab::gcd;	// or the one found by ADL
+
+	if constexpr (is_builtin_integer<AccT>::value &&
+		      std::numeric_limits<AccT>::digits >
+		      std::numeric_limits<long long>::digits) {
+		if (fits<long long>(num) && fits<long long>(denom)) {
+			long long n = static_cast<long long>(num);
+			long long d = static_cast<long long>(denom);
+			long long const gcd_ = gcd(n, d);
+			n /= gcd_;
+			d /= gcd_;
+			num = n;
+			denom = d;
+			return;
+		}
+	}
+	AccT const gcd_ = gcd(num, denom);
+	num /= gcd_;
+	denom /= gcd_;
+}
+
+// Each operation gives the bit bounds of its result (|x| <= 2^bits) and
+// computes it from unreduced operands of any sign.
+struct expr_add {
+	static constexpr int num_bits(int ln, int ld, int rn, int rd) noexcept
+	{
+		return max_bits(ln + rd, rn + ld) + 1;
+	}
+	static constexpr int denom_bits(int, int ld, int, int rd) noexcept
+	{
+		return ld + rd;
+	}
+	template<typename AccT>
+	static void apply(AccT const& ln, AccT const& ld, AccT const& rn,
+			  AccT const& rd, AccT& num, AccT& denom)
+	{
+		if (ld == rd) {
+			num = ln + rn;
+			denom = ld;
+		} else {
+			num = ln * rd + rn * ld;
+			denom = ld * rd;
+		}
+	}
+	template<typename Rational>
+	static Rational apply(Rational const& lhs, Rational const& rhs)
+	{
+		return lhs + rhs;
+	}
+};
+
+struct expr_sub {
+	static constexpr int num_bits(int ln, int ld, int rn, int rd) noexcept
+	{
+		return max_bits(ln + rd, rn + ld) + 1;
+	}
+	static constexpr int denom_bits(int, int ld, int, int rd) noexcept
+	{
+		return ld + rd;
+	}
+	template<typename AccT>
+	static void apply(AccT const& ln, AccT const& ld, AccT const& rn,
+			  AccT const& rd, AccT& num, AccT& denom)
+	{
+		if (ld == rd) {
+			num = ln - rn;
+			denom = ld;
+		} else {
+			num = ln * rd - rn * ld;
+			denom = ld * rd;
+		}
+	}
+	template<typename Rational>
+	static Rational apply(Rational const& lhs, Rational const& rhs)
+	{
+		return lhs - rhs;
+	}
+};
+
+struct expr_mul {
+	static constexpr int num_bits(int ln, int, int rn, int) noexcept
+	{
+		return ln + rn;
+	}
+	static constexpr int denom_bits(int, int ld, int, int rd) noexcept
+	{
+		return ld + rd;
+	}
+	template<typename AccT>
+	static void apply(AccT const& ln, AccT const& ld, AccT const& rn,
+			  AccT const& rd, AccT& num, AccT& denom)
+	{
+		num = ln * rn;
+		denom = ld * rd;
+	}
+	template<typename Rational>
+	static Rational apply(Rational const& lhs, Rational const& rhs)
+	{
+		return lhs * rhs;
+	}
+};
+
+struct expr_div {
+	static constexpr int num_bits(int ln, int, int, int rd) noexcept
+	{
+		return ln + rd;
+	}
+	static constexpr int denom_bits(int, int ld, int rn, int) noexcept
+	{
+		return ld + rn;
+	}
+	template<typename AccT>
+	static void apply(AccT const& ln, AccT const& ld, AccT const& rn,
+			  AccT const& rd, AccT& num, AccT& denom)
+	{
+		if (rn == AccT(0))
+			throw std::invalid_argument("Denominator can't be 0.");
+		num = ln * rd;
+		denom = ld * rn;
+	}
+	template<typename Rational>
+	static Rational apply(Rational const& lhs, Rational const& rhs)
+	{
+		return lhs / rhs;
+	}
+};
+
+} // namespace detail
+
+/**
+ * @brief Leaf of a rational expression: a copy of one operand.
+ */
+template<typename Rational>
+class rational_expr_leaf {
+public:
+	typedef Rational					rational_type;
+	typedef typename Rational::int_type			int_type;
+	typedef typename detail::fused_type<int_type>::type	fused_type;
+
+	static constexpr int num_bits = std::numeric_limits<int_type>::digits;
+	static constexpr int denom_bits = std::numeric_limits<int_type>::digits;
+	static constexpr bool fusable = true;
+private:
+	Rational value_;
+public:
+	explicit rational_expr_leaf(Rational const& value) : value_(value) {}
+
+	void fused(fused_type& num, fused_type& denom) const
+	{
+		num = value_.num();
+		denom = value_.denom();
+	}
+	Rational eval() const { return value_; }
+	operator Rational() const { return value_; }
+};
+
+/**
+ * @brief Node of a rational expression: Op applied to two subexpressions.
+ */
+template<typename Op, typename L, typename R>
+class rational_expr {
+public:
+	typedef typename L::rational_type	rational_type;
+	typedef typename L::int_type		int_type;
+	typedef typename L::fused_type		fused_type;
+
+	static_assert(std::is_same<rational_type,
+				   typename R::rational_type>::value,
+		      "Operands of a rational expression must have one type.");
+
+	static constexpr int num_bits = Op::num_bits(L::num_bits, L::denom_bits,
+						     R::num_bits, R::denom_bits);
+	static constexpr int denom_bits = Op::denom_bits(L::num_bits,
+							 L::denom_bits,
+							 R::num_bits,
+							 R::denom_bits);
+	// the unreduced result fits into the accumulator (so does its negation)
+	static constexpr bool fusable =
+		detail::max_bits(num_bits, denom_bits)
+		< detail::fused_type<int_type>::digits;
+private:
+	L lhs_;
+	R rhs_;
+
+	// reduces the fused result and stores it in rational_type
+	static rational_type finish(fused_type num, fused_type denom)
+	{
+		typedef typename rational_type::overflow_policy overflow_policy;
+
+		if (denom < fused_type(0)) {
+			num = -num;
+			denom = -denom;
+		}
+		if (!(rational_type::normalization_policy::lazy &&
+		      detail::fits<int_type>(num) &&
+		      detail::fits<int_type>(denom)))
+			detail::reduce_fused(num, denom);
+		if (!detail::fits<int_type>(num) || !detail::fits<int_type>(denom))
+			return overflow_policy::template on_overflow<rational_type>(
+					static_cast<long double>(num)
+					/ static_cast<long double>(denom),
+					num, denom);
+		return detail::rational_access::make<rational_type>(
+					static_cast<int_type>(num),
+					static_cast<int_type>(denom));
+	}
+public:
+	rational_expr(L const& lhs, R const& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+	// unreduced result of a fusable node
+	void fused(fused_type& num, fused_type& denom) const
+	{
+		fused_type ln, ld, rn, rd;
+
+		lhs_.fused(ln, ld);
+		rhs_.fused(rn, rd);
+		Op::apply(ln, ld, rn, rd, num, denom);
+	}
+
+	rational_type eval() const
+	{
+		if constexpr (fusable) {
+			fused_type num, denom;
+
+			fused(num, denom);
+			return finish(num, denom);
+		} else {
+			return Op::apply(lhs_.eval(), rhs_.eval());
+		}
+	}
+	operator rational_type() const { return eval(); }
+};
+
+namespace detail {
+
+template<typename T>
+struct is_rational : std::false_type {};
+template<typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+struct is_rational<rational_t<IntT, OverflowPolicy, NormalizationPolicy>>
+	: std::true_type {};
+
+template<typename T>
+struct is_rational_expr : std::false_type {};
+template<typename Rational>
+struct is_rational_expr<rational_expr_leaf<Rational>> : std::true_type {};
+template<typename Op, typename L, typename R>
+struct is_rational_expr<rational_expr<Op, L, R>> : std::true_type {};
+
+// operand -> expression
+template<typename T, bool = is_rational_expr<T>::value>
+struct as_expr {
+	typedef T type;
+	static T const& make(T const& x) noexcept { return x; }
+};
+template<typename T>
+struct as_expr<T, false> {
+	typedef rational_expr_leaf<T> type;
+	static type make(T const& x) { return type(x); }
+};
+
+// at least one operand is an expression, the other one may be a rational_t
+template<typename L, typename R>
+using enable_rational_expr = typename std::enable_if<
+	(is_rational_expr<L>::value || is_rational_expr<R>::value) &&
+	(is_rational_expr<L>::value || is_rational<L>::value) &&
+	(is_rational_expr<R>::value || is_rational<R>::value)>::type;
+
+template<typename Op, typename L, typename R>
+using rational_expr_t = rational_expr<Op, typename as_expr<L>::type,
+				      typename as_expr<R>::type>;
+
+template<typename Op, typename L, typename R>
+rational_expr_t<Op, L, R> make_expr(L const& lhs, R const& rhs)
+{
+	return rational_expr_t<Op, L, R>(as_expr<L>::make(lhs),
+					 as_expr<R>::make(rhs));
+}
+
+} // namespace detail
+
+/**
+ * @brief Starts a fused expression with the operand number.
+ */
+template<typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+rational_expr_leaf<rational_t<IntT, OverflowPolicy, NormalizationPolicy>>
+fused(rational_t<IntT, OverflowPolicy, NormalizationPolicy> const& number)
+{
+	return rational_expr_leaf<rational_t<IntT, OverflowPolicy,
+					     NormalizationPolicy>>(number);
+}
+
+template<typename L, typename R, typename = detail::enable_rational_expr<L, R>>
+detail::rational_expr_t<detail::expr_add, L, R>
+operator+(L const& lhs, R const& rhs)
+{
+	return detail::make_expr<detail::expr_add>(lhs, rhs);
+}
+
+template<typename L, typename R, typename = detail::enable_rational_expr<L, R>>
+detail::rational_expr_t<detail::expr_sub, L, R>
+operator-(L const& lhs, R const& rhs)
+{
+	return detail::make_expr<detail::expr_sub>(lhs, rhs);
+}
+
+template<typename L, typename R, typename = detail::enable_rational_expr<L, R>>
+detail::rational_expr_t<detail::expr_mul, L, R>
+operator*(L const& lhs, R const& rhs)
+{
+	return detail::make_expr<detail::expr_mul>(lhs, rhs);
+}
+
+template<typename L, typename R, typename = detail::enable_rational_expr<L, R>>
+detail::rational_expr_t<detail::expr_div, L, R>
+operator/(L const& lhs, R const& rhs)
+{
+	return detail::make_expr<detail::expr_div>(lhs, rhs);
+}
+
+} // namespace lab
+
+#endif // RATIONAL_EXPR_H
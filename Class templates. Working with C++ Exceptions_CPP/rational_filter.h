@@ -0,0 +1,251 @@
+#ifndef RATIONAL_FILTER_H
+#define RATIONAL_FILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "overflow.h"
+#include "rational.h"
+#include "vector.h"
+
+namespace lab {
+
+// Filtered comparisons of rational numbers.
+//
+// A rational number is approximated by a double with a known relative
+// error. When two approximations are further apart than their errors, the
+// order of the numbers follows from the doubles; otherwise (equal or very
+// close values) the exact comparison decides. For random data almost every
+// comparison is settled by a subtraction of doubles, which pays off where
+// the exact comparison is expensive: 128-bit cross products of long long
+// components and compare_fractions() for __int128. Class-type components
+// such as bigint are always compared exactly: converting them to double
+// costs about as much as the comparison.
+
+namespace detail {
+
+// The double approximation of a rational number and its relative error.
+template<typename Rational>
+struct double_approximation {
+	typedef typename Rational::int_type int_type;
+
+	// components that convert to double exactly: one rounding, in the
+	// division; other built-in ones: three
+	static constexpr bool exact_components =
+		std::numeric_limits<int_type>::digits
+		<= std::numeric_limits<double>::digits;
+	static constexpr double error = exact_components ? 0x1p-53 : 0x1p-51;
+
+	// __int128 converts in software; most values fit long long, which
+	// converts in one instruction
+	static double to_double(int_type x) noexcept
+	{
+		if constexpr (sizeof(int_type) > sizeof(long long)) {
+			long long const narrow = static_cast<long long>(x);
+			if (narrow == x)
+				return static_cast<double>(narrow);
+		}
+		return static_cast<double>(x);
+	}
+
+	// NaN for class types: the filter then never decides
+	static double of(Rational const& x) noexcept
+	{
+		if constexpr (is_builtin_integer<int_type>::value)
+			return to_double(x.num()) / to_double(x.denom());
+		else
+			return std::numeric_limits<double>::quiet_NaN();
+	}
+};
+
+// Sign of x - y from approximations a of x and b of y with relative
+// error at most error, or 0 if they do not decide it. The bound is doubled
+// to cover the rounding of the test itself.
+inline int filtered_sign(double a, double b, double error) noexcept
+{
+	double const margin = 2 * error * (std::fabs(a) + std::fabs(b));
+	if (a - b > margin)
+		return 1;
+	if (b - a > margin)
+		return -1;
+	return 0;
+}
+
+} // namespace detail
+
+/**
+ * @brief filtered_rational is a rational number with its double
+ * approximation, a sort key for filtered comparisons.
+ */
+template<typename Rational>
+class filtered_rational {
+	typedef detail::double_approximation<Rational> approximation;
+
+	double approx_;
+	Rational value_;
+public:
+	filtered_rational() : approx_(0), value_() {}
+	explicit filtered_rational(Rational const& value)
+		: approx_(approximation::of(value)), value_(value) {}
+
+	double approx() const noexcept { return approx_; }
+	Rational const& value() const noexcept { return value_; }
+
+	/**
+	 * @brief Sign of lhs - rhs; exact, but from the approximations
+	 * whenever they decide it.
+	 */
+	friend int compare(filtered_rational const& lhs,
+			   filtered_rational const& rhs)
+	{
+		int const sign = detail::filtered_sign(lhs.approx_, rhs.approx_,
+						       approximation::error);
+		return sign ? sign : detail::rational_access::compare(
+					     lhs.value_, rhs.value_);
+	}
+
+	friend bool operator<(filtered_rational const& lhs,
+			      filtered_rational const& rhs)
+	{
+		return compare(lhs, rhs) < 0;
+	}
+	friend bool operator>(filtered_rational const& lhs,
+			      filtered_rational const& rhs)
+	{
+		return compare(lhs, rhs) > 0;
+	}
+	friend bool operator<=(filtered_rational const& lhs,
+			       filtered_rational const& rhs)
+	{
+		return compare(lhs, rhs) <= 0;
+	}
+	friend bool operator>=(filtered_rational const& lhs,
+			       filtered_rational const& rhs)
+	{
+		return compare(lhs, rhs) >= 0;
+	}
+	friend bool operator==(filtered_rational const& lhs,
+			       filtered_rational const& rhs)
+	{
+		return compare(lhs, rhs) == 0;
+	}
+	friend bool operator!=(filtered_rational const& lhs,
+			       filtered_rational const& rhs)
+	{
+		return compare(lhs, rhs) != 0;
+	}
+};
+
+/**
+ *  @brief  Sign of lhs - rhs, trying the double approximations first.
+ *
+ *  Each call converts both numbers; to compare one number many times, use
+ *  filtered_rational keys instead.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+int filtered_compare(rational_t<IntT, OverflowPolicy,
+				NormalizationPolicy> const& lhs,
+		     rational_t<IntT, OverflowPolicy,
+				NormalizationPolicy> const& rhs)
+{
+	typedef rational_t<IntT, OverflowPolicy, NormalizationPolicy> rational;
+	typedef detail::double_approximation<rational> approximation;
+
+	int const sign = detail::filtered_sign(approximation::of(lhs),
+					       approximation::of(rhs),
+					       approximation::error);
+	return sign ? sign : detail::rational_access::compare(lhs, rhs);
+}
+
+/**
+ * @brief Function object ordering rational numbers by filtered_compare().
+ */
+struct filtered_less {
+	template<typename Rational>
+	bool operator()(Rational const& lhs, Rational const& rhs) const
+	{
+		return filtered_compare(lhs, rhs) < 0;
+	}
+};
+
+/**
+ *  @brief  Sorts first[0], ..., first[n - 1] in ascending order.
+ *
+ *  Every number is approximated once; the sort then runs on
+ *  filtered_rational keys, which takes a second array of n keys. The keys
+ *  live in a std::vector, which also constructs class-type components
+ *  such as bigint.
+ */
+template<typename Rational>
+void filtered_sort(Rational* first, size_t n)
+{
+	if (n < 2)
+		return;
+	std::vector<filtered_rational<Rational> > keys;
+	keys.reserve(n);
+	for (size_t i = 0; i != n; ++i)
+		keys.emplace_back(first[i]);
+	std::sort(keys.begin(), keys.end());
+	for (size_t i = 0; i != n; ++i)
+		first[i] = keys[i].value();
+}
+
+template<typename Rational>
+void filtered_sort(vector<Rational>& vec)
+{
+	filtered_sort(vec.data(), vec.size());
+}
+
+namespace detail {
+
+// the first element x with sign * compare(x, y) < 0 for all others y
+template<typename Rational>
+const Rational* filtered_extreme(const Rational* first, size_t n, int sign)
+{
+	typedef double_approximation<Rational> approximation;
+
+	if (!n)
+		return nullptr;
+	const Rational* best = first;
+	double best_approx = approximation::of(*first);
+	for (size_t i = 1; i != n; ++i) {
+		double const approx = approximation::of(first[i]);
+		int order = filtered_sign(approx, best_approx,
+					  approximation::error);
+		if (!order)
+			order = rational_access::compare(first[i], *best);
+		if (sign * order < 0) {
+			best = first + i;
+			best_approx = approx;
+		}
+	}
+	return best;
+}
+
+} // namespace detail
+
+/**
+ *  @brief  The first smallest of first[0], ..., first[n - 1], or nullptr
+ *  if n is 0.
+ */
+template<typename Rational>
+const Rational* filtered_min_element(const Rational* first, size_t n)
+{
+	return detail::filtered_extreme(first, n, 1);
+}
+
+/**
+ *  @brief  The first largest of first[0], ..., first[n - 1], or nullptr
+ *  if n is 0.
+ */
+template<typename Rational>
+const Rational* filtered_max_element(const Rational* first, size_t n)
+{
+	return detail::filtered_extreme(first, n, -1);
+}
+
+} // namespace lab
+
+#endif // RATIONAL_FILTER_H
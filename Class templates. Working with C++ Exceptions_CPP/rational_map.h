@@ -0,0 +1,368 @@
+#ifndef RATIONAL_MAP_H
+#define RATIONAL_MAP_H
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "hash.h"
+#include "rational.h"
+
+namespace lab {
+
+/**
+ * @brief rational_map is an open-addressing hash map from rational numbers
+ * to T, for deduplication and memoization of exact ratios.
+ *
+ * Keys are stored reduced, as their two components, in one flat array of
+ * slots next to the values. A lookup hashes the key once and probes the
+ * following slots (linear probing), comparing the components directly. A
+ * denominator is never 0, so a zero denominator marks an empty slot: no
+ * control bytes and no tombstones, erase() shifts the following entries
+ * back instead. The capacity is a power of two and the table grows at 3/4
+ * load. T must be default constructible.
+ */
+template<typename Rational, typename T, typename Alloc = std::allocator<T> >
+class rational_map {
+public:
+	typedef size_t				size_type;
+	typedef Rational			key_type;
+	typedef T				mapped_type;
+	typedef typename Rational::int_type	int_type;
+	typedef Alloc				allocator_type;
+private:
+	struct slot {
+		int_type num = int_type(0);
+		int_type denom = int_type(0);	// 0: empty
+		T value = T();
+	};
+	typedef typename std::allocator_traits<allocator_type>::
+		template rebind_alloc<slot>		slot_allocator;
+	typedef std::allocator_traits<slot_allocator>	alloc_traits;
+
+	slot* storage;
+	size_type mask;
+	size_type count;
+	slot_allocator a;
+
+	static size_type round_up_pow2(size_type n)
+	{
+		size_type constexpr top = ~(~size_type(0) >> 1);
+		if (n > top)
+			throw std::length_error("Too many entries.");
+		size_type p = 1;
+		while (p < n)
+			p <<= 1;
+		return p;
+	}
+
+	// replaces the storage pointer by capacity empty slots; on failure
+	// nothing changes
+	void create_storage(size_type capacity)
+	{
+		slot* const p = alloc_traits::allocate(a, capacity);
+		if (!p)
+			throw std::bad_alloc();
+
+		size_type i = 0;
+		try {
+			for (; i != capacity; ++i)
+				alloc_traits::construct(a, p + i);
+		} catch (...) {
+			while (i != 0)
+				alloc_traits::destroy(a, p + --i);
+			alloc_traits::deallocate(a, p, capacity);
+			throw;
+		}
+		storage = p;
+		mask = capacity - 1;
+		count = 0;
+	}
+
+	void destroy_storage() noexcept
+	{
+		if (!storage)
+			return;
+		for (size_type i = 0; i != capacity(); ++i)
+			alloc_traits::destroy(a, storage + i);
+		alloc_traits::deallocate(a, storage, capacity());
+		storage = nullptr;
+		mask = 0;
+		count = 0;
+	}
+
+	static bool occupied(slot const& s) noexcept
+	{
+		return s.denom != int_type(0);
+	}
+
+	size_type home(int_type const& num, int_type const& denom) const
+	{
+		return static_cast<size_type>(detail::hash_pair(num, denom))
+		       & mask;
+	}
+
+	// the slot holding num / denom, or the empty slot ending its probe
+	size_type locate(int_type const& num, int_type const& denom) const
+	{
+		size_type i = home(num, denom);
+		while (occupied(storage[i]) &&
+		       !(storage[i].num == num && storage[i].denom == denom))
+			i = (i + 1) & mask;
+		return i;
+	}
+
+	// moves every entry into a table of new_capacity slots
+	void rehash(size_type new_capacity)
+	{
+		slot* const old_storage = storage;
+		size_type const old_capacity = capacity();
+		size_type const old_count = count;
+
+		create_storage(new_capacity);
+		for (size_type i = 0; i != old_capacity; ++i) {
+			slot& s = old_storage[i];
+			if (!occupied(s))
+				continue;
+			slot& target = storage[locate(s.num, s.denom)];
+			target.num = s.num;
+			target.denom = s.denom;
+			target.value = std::move(s.value);
+		}
+		count = old_count;
+
+		for (size_type i = 0; i != old_capacity; ++i)
+			alloc_traits::destroy(a, old_storage + i);
+		alloc_traits::deallocate(a, old_storage, old_capacity);
+	}
+
+	// the slot of the reduced key, inserted with a default value if new
+	std::pair<slot*, bool> emplace(key_type const& key)
+	{
+		if ((count + 1) * 4 > capacity() * 3)
+			rehash(capacity() ? capacity() * 2 : 16);
+
+		key_type const reduced = key.normalized();
+		slot& s = storage[locate(reduced.num(), reduced.denom())];
+		if (occupied(s))
+			return std::make_pair(&s, false);
+		s.num = reduced.num();
+		s.denom = reduced.denom();
+		++count;
+		return std::make_pair(&s, true);
+	}
+public:
+	/**
+	 * @brief Returns the number of entries in the map
+	 */
+	inline size_type size() const noexcept { return count; }
+
+	/**
+	 * @brief Returns the number of slots, 0 or a power of two.
+	 */
+	inline size_type capacity() const noexcept
+	{
+		return storage ? mask + 1 : 0;
+	}
+
+	/**
+	 * Returns true if the %rational_map is empty.
+	 */
+	bool empty() const noexcept { return count == 0; }
+
+	/**
+	 *  @brief  Creates an empty %rational_map; the first insertion
+	 *  allocates.
+	 */
+	rational_map() noexcept : storage(nullptr), mask(0), count(0) {}
+
+	/**
+	 *  @brief  Creates an empty %rational_map that holds n entries without
+	 *  growing.
+	 */
+	explicit rational_map(size_type n)
+		: storage(nullptr), mask(0), count(0)
+	{
+		reserve(n);
+	}
+
+	explicit rational_map(rational_map const& other)
+		: storage(nullptr), mask(0), count(0)
+	{
+		if (!other.storage)
+			return;
+		create_storage(other.capacity());
+		for (size_type i = 0; i != capacity(); ++i)
+			storage[i] = other.storage[i];
+		count = other.count;
+	}
+
+	/**
+	 *  @brief  %rational_map move constructor; other is left empty.
+	 */
+	explicit rational_map(rational_map&& other) noexcept
+		: storage(other.storage), mask(other.mask), count(other.count)
+	{
+		other.storage = nullptr;
+		other.mask = 0;
+		other.count = 0;
+	}
+
+	rational_map& operator=(rational_map const& other)
+	{
+		if (this == &other)
+			return *this;
+		rational_map copy(other);
+		return *this = std::move(copy);
+	}
+
+	rational_map& operator=(rational_map&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		destroy_storage();
+		storage = other.storage;
+		mask = other.mask;
+		count = other.count;
+		other.storage = nullptr;
+		other.mask = 0;
+		other.count = 0;
+		return *this;
+	}
+
+	~rational_map()
+	{
+		destroy_storage();
+	}
+
+	/**
+	 * @brief reserve: Grows the table so that n entries fit below the
+	 * maximal load; throws std::length_error if no table that large
+	 * fits size_type.
+	 */
+	void reserve(size_type n)
+	{
+		if (n > ~size_type(0) / 4)
+			throw std::length_error("Too many entries.");
+		size_type const needed = round_up_pow2((n * 4 + 2) / 3);
+		if (needed > capacity())
+			rehash(needed < 16 ? 16 : needed);
+	}
+
+	/**
+	 * @brief clear: Drops all entries, keeping the capacity.
+	 */
+	void clear()
+	{
+		for (size_type i = 0; i != capacity(); ++i)
+			if (occupied(storage[i]))
+				storage[i] = slot();
+		count = 0;
+	}
+
+	/**
+	 *  @brief  Inserts key -> value unless key is present already.
+	 *  @return The value stored for key, and whether it was inserted.
+	 */
+	std::pair<T*, bool> insert(key_type const& key, T const& value)
+	{
+		std::pair<slot*, bool> const result = emplace(key);
+		if (result.second)
+			result.first->value = value;
+		return std::make_pair(&result.first->value, result.second);
+	}
+
+	/**
+	 *  @brief  The value of key, inserted default constructed if absent.
+	 */
+	T& operator[](key_type const& key)
+	{
+		return emplace(key).first->value;
+	}
+
+	/**
+	 *  @brief  The value of key; throws std::out_of_range if absent.
+	 */
+	T& at(key_type const& key) noexcept(false)
+	{
+		T* const value = find(key);
+		if (!value) throw std::out_of_range("No such key.");
+		return *value;
+	}
+	const T& at(key_type const& key) const noexcept(false)
+	{
+		const T* const value = find(key);
+		if (!value) throw std::out_of_range("No such key.");
+		return *value;
+	}
+
+	/**
+	 *  @brief  The value of key, or nullptr if absent.
+	 */
+	T* find(key_type const& key)
+	{
+		return const_cast<T*>(
+			static_cast<rational_map const&>(*this).find(key));
+	}
+	const T* find(key_type const& key) const
+	{
+		if (!count)
+			return nullptr;
+		key_type const reduced = key.normalized();
+		slot const& s = storage[locate(reduced.num(), reduced.denom())];
+		return occupied(s) ? &s.value : nullptr;
+	}
+
+	bool contains(key_type const& key) const
+	{
+		return find(key) != nullptr;
+	}
+
+	/**
+	 *  @brief  Removes key; returns false if it was absent.
+	 *
+	 *  The entries after it in its probe run are shifted back, unless
+	 *  that would move them before their home slot.
+	 */
+	bool erase(key_type const& key)
+	{
+		if (!count)
+			return false;
+		key_type const reduced = key.normalized();
+		size_type i = locate(reduced.num(), reduced.denom());
+		if (!occupied(storage[i]))
+			return false;
+
+		for (size_type j = (i + 1) & mask; occupied(storage[j]);
+		     j = (j + 1) & mask) {
+			size_type const h = home(storage[j].num,
+						 storage[j].denom);
+			// h is cyclically outside (i, j]: j may move to i
+			if (((j - h) & mask) >= ((j - i) & mask)) {
+				storage[i] = std::move(storage[j]);
+				i = j;
+			}
+		}
+		storage[i] = slot();
+		--count;
+		return true;
+	}
+
+	/**
+	 * @brief for_each: Calls f(key, value) for every entry, in table
+	 * order. The stored keys are reduced already.
+	 */
+	template<typename F>
+	void for_each(F f) const
+	{
+		for (size_type i = 0; i != capacity(); ++i)
+			if (occupied(storage[i]))
+				f(detail::rational_access::make<key_type>(
+					  storage[i].num, storage[i].denom),
+				  storage[i].value);
+	}
+};
+
+} // namespace lab
+
+#endif // RATIONAL_MAP_H
@@ -0,0 +1,301 @@
+#ifndef RATIONAL_NUMERIC_H
+#define RATIONAL_NUMERIC_H
+
+#include <type_traits>
+
+#include "gcd.h"
+#include "overflow.h"
+#include "rational.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+namespace lab {
+
+// Parallel sums of arrays of rational numbers.
+//
+// The input is cut into a few chunks per thread of the pool. Each chunk is
+// summed by a rational_sum, over a common denominator, and the partial sums
+// are combined pairwise in a tree, which keeps the operands of every
+// addition of similar size.
+
+namespace detail {
+
+/**
+ * @brief rational_sum adds rational numbers over a common denominator that
+ * is only reduced once, at the end.
+ *
+ * Adding p / q to n / d takes the lcm of d and q, one gcd of two
+ * denominators, and no gcd of the numerator: a rational_t addition also
+ * reduces every intermediate sum. Equal denominators, as in sums of
+ * fixed-point values, are added without any gcd. The sum is kept in the
+ * wide type of the components; when it would overflow, it is reduced and
+ * moved into a rational_t total, whose overflow policy applies.
+ */
+template<typename Rational>
+class rational_sum {
+	typedef typename Rational::int_type		int_type;
+	typedef typename widen<int_type>::type		wide_type;
+
+	wide_type num;
+	wide_type denom;
+	Rational total;
+
+	// num / denom += p / q; false, with nothing changed, on overflow
+	bool try_add(wide_type const& p, wide_type const& q)
+	{
+		wide_type new_num = 0;
+		if (q == denom) {
+			if (add_overflow(num, p, new_num))
+				return false;
+			num = new_num;
+			return true;
+		}
+
+		using lab::gcd;	// or the one found by ADL
+		wide_type const gcd_ = gcd(denom, q);
+		wide_type const factor = q / gcd_;
+		wide_type new_denom = 0, addend = 0;
+		if (mul_overflow(denom, factor, new_denom) ||
+		    mul_overflow(num, factor, new_num) ||
+		    mul_overflow(p, wide_type(denom / gcd_), addend) ||
+		    add_overflow(new_num, addend, new_num))
+			return false;
+		num = new_num;
+		denom = new_denom;
+		return true;
+	}
+
+	// moves num / denom into total
+	void flush()
+	{
+		if (num == wide_type(0)) {
+			denom = wide_type(1);
+			return;
+		}
+		using lab::gcd;	// or the one found by ADL
+		wide_type const gcd_ = gcd(num, denom);
+		num /= gcd_;
+		denom /= gcd_;
+		if (fits<int_type>(num) && fits<int_type>(denom))
+			total += rational_access::make<Rational>(
+				static_cast<int_type>(num),
+				static_cast<int_type>(denom));
+		else
+			total += Rational::overflow_policy::template
+				 on_overflow<Rational>(
+					static_cast<long double>(num)
+					/ static_cast<long double>(denom),
+					num, denom);
+		num = wide_type(0);
+		denom = wide_type(1);
+	}
+public:
+	rational_sum() : num(0), denom(1), total() {}
+
+	void add(Rational const& x)
+	{
+		wide_type const p(x.num()), q(x.denom());
+		if (!try_add(p, q)) {
+			flush();
+			try_add(p, q);	// into 0 / 1: cannot overflow
+		}
+	}
+
+	/**
+	 * @brief The sum so far, reduced unless normalization is lazy.
+	 */
+	Rational result()
+	{
+		flush();
+		return total;
+	}
+};
+
+// a few chunks per thread, of at least grain elements
+inline size_t chunk_count(size_t n, thread_pool const& pool, size_t grain)
+{
+	size_t const chunks = (n + grain - 1) / grain;
+	size_t const limit = 4 * (pool.size() + 1);
+	return chunks < limit ? chunks : limit;
+}
+
+inline size_t chunk_begin(size_t n, size_t chunks, size_t c)
+{
+	return n * c / chunks;
+}
+
+// partial[0] = partial[0] + ... + partial[count - 1], pairwise
+template<typename Rational>
+void tree_combine(Rational* partial, size_t count, thread_pool& pool)
+{
+	for (size_t step = 1; step < count; step *= 2) {
+		size_t const pairs = (count + step - 1) / (2 * step);
+		pool.parallel_for(0, pairs, [=](size_t lo, size_t hi) {
+			for (size_t i = lo; i != hi; ++i)
+				partial[2 * step * i] +=
+					partial[2 * step * i + step];
+		});
+	}
+}
+
+// the sums of f(first[i]) over the first count of chunks chunks
+template<typename Rational, typename T, typename F>
+void chunk_sums(const T* first, size_t n, F const& f, Rational* partial,
+		size_t chunks, size_t count, thread_pool& pool)
+{
+	pool.parallel_for(0, count, [&](size_t lo, size_t hi) {
+		for (size_t c = lo; c != hi; ++c) {
+			size_t const begin = chunk_begin(n, chunks, c);
+			size_t const end = chunk_begin(n, chunks, c + 1);
+			rational_sum<Rational> sum;
+			for (size_t i = begin; i != end; ++i)
+				sum.add(f(first[i]));
+			partial[c] = sum.result();
+		}
+	});
+}
+
+} // namespace detail
+
+/**
+ * @brief The smallest number of elements summed by one task of the
+ * parallel sums.
+ */
+constexpr size_t sum_grain = 4096;
+
+/**
+ *  @brief  The sum of f(first[i]) for i in [0, n), a rational_t.
+ *
+ *  The order of the additions is unspecified; it does not change the
+ *  exact result, only where an overflow is detected.
+ */
+template<typename T, typename F>
+auto transform_reduce(const T* first, size_t n, F f,
+		      thread_pool& pool = default_thread_pool())
+	-> typename std::decay<decltype(f(*first))>::type
+{
+	typedef typename std::decay<decltype(f(*first))>::type rational;
+
+	size_t const chunks = detail::chunk_count(n, pool, sum_grain);
+	if (chunks <= 1) {
+		detail::rational_sum<rational> sum;
+		for (size_t i = 0; i != n; ++i)
+			sum.add(f(first[i]));
+		return sum.result();
+	}
+
+	vector<rational> partial(chunks);
+	detail::chunk_sums(first, n, f, partial.data(), chunks, chunks, pool);
+	detail::tree_combine(partial.data(), chunks, pool);
+	return partial.data()[0];
+}
+
+template<typename T, typename F>
+auto transform_reduce(vector<T> const& vec, F f,
+		      thread_pool& pool = default_thread_pool())
+	-> typename std::decay<decltype(f(*vec.data()))>::type
+{
+	return transform_reduce(vec.data(), vec.size(), f, pool);
+}
+
+/**
+ *  @brief  The sum of first[0], ..., first[n - 1].
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+rational_t<IntT, OverflowPolicy, NormalizationPolicy>
+reduce(const rational_t<IntT, OverflowPolicy, NormalizationPolicy>* first,
+       size_t n, thread_pool& pool = default_thread_pool())
+{
+	typedef rational_t<IntT, OverflowPolicy, NormalizationPolicy> rational;
+	return transform_reduce(first, n,
+				[](rational const& x) -> rational const& {
+					return x;
+				}, pool);
+}
+
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+rational_t<IntT, OverflowPolicy, NormalizationPolicy>
+reduce(vector<rational_t<IntT, OverflowPolicy,
+			 NormalizationPolicy> > const& vec,
+       thread_pool& pool = default_thread_pool())
+{
+	return reduce(vec.data(), vec.size(), pool);
+}
+
+namespace detail {
+
+// out[i] = init + first[0] + ... + first[i - 1 + inclusive]; out may be
+// first. The chunk sums are taken first, their prefix sums give the value
+// each chunk starts from, and the chunks are then scanned in parallel.
+template<typename Rational>
+void scan(const Rational* first, size_t n, Rational* out,
+	  Rational const& init, bool inclusive, thread_pool& pool)
+{
+	size_t const chunks = chunk_count(n, pool, sum_grain);
+	vector<Rational> offset(chunks ? chunks : 1, init);
+
+	if (chunks > 1) {
+		auto const identity = [](Rational const& x) -> Rational const& {
+			return x;
+		};
+		chunk_sums(first, n, identity, offset.data() + 1, chunks,
+			   chunks - 1, pool);
+		for (size_t c = 1; c != chunks; ++c)
+			offset.data()[c] += offset.data()[c - 1];
+	}
+
+	pool.parallel_for(0, chunks, [&](size_t lo, size_t hi) {
+		for (size_t c = lo; c != hi; ++c) {
+			size_t const begin = chunk_begin(n, chunks, c);
+			size_t const end = chunk_begin(n, chunks, c + 1);
+			Rational running = offset.data()[c];
+			for (size_t i = begin; i != end; ++i) {
+				Rational const x = first[i];
+				if (inclusive)
+					running += x;
+				out[i] = running;
+				if (!inclusive)
+					running += x;
+			}
+		}
+	});
+}
+
+} // namespace detail
+
+/**
+ *  @brief  out[i] = first[0] + ... + first[i] for i in [0, n).
+ *
+ *  out may equal first. The array is read twice: once for the chunk sums,
+ *  once to write the prefix sums.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+void inclusive_scan(const rational_t<IntT, OverflowPolicy,
+				     NormalizationPolicy>* first, size_t n,
+		    rational_t<IntT, OverflowPolicy, NormalizationPolicy>* out,
+		    thread_pool& pool = default_thread_pool())
+{
+	detail::scan(first, n, out,
+		     rational_t<IntT, OverflowPolicy, NormalizationPolicy>(),
+		     true, pool);
+}
+
+/**
+ *  @brief  out[i] = init + first[0] + ... + first[i - 1] for i in [0, n).
+ *
+ *  out may equal first.
+ */
+template <typename IntT, typename OverflowPolicy, typename NormalizationPolicy>
+void exclusive_scan(const rational_t<IntT, OverflowPolicy,
+				     NormalizationPolicy>* first, size_t n,
+		    rational_t<IntT, OverflowPolicy, NormalizationPolicy>* out,
+		    rational_t<IntT, OverflowPolicy,
+			       NormalizationPolicy> const& init,
+		    thread_pool& pool = default_thread_pool())
+{
+	detail::scan(first, n, out, init, false, pool);
+}
+
+} // namespace lab
+
+#endif // RATIONAL_NUMERIC_H
@@ -0,0 +1,158 @@
+#ifndef RATIONAL_SOA_VECTOR_H
+#define RATIONAL_SOA_VECTOR_H
+
+#include <iostream>
+#include <stdexcept>
+
+#include "aligned_allocator.h"
+#include "rational.h"
+#include "vector.h"
+
+namespace lab {
+
+/**
+ * @brief rational_soa_vector stores a sequence of rational numbers as two
+ * separate cache-line aligned columns: numerators and denominators.
+ *
+ * A kernel that only needs the numerators (sign tests, sums over a common
+ * denominator) reads half the memory of a vector<rational_t<IntT>>, and
+ * each column is a plain array of IntT that vectorizes well.
+ */
+template<typename IntT = int>
+class rational_soa_vector {
+public:
+	typedef size_t				size_type;
+	typedef rational_t<IntT>		value_type;
+	typedef IntT				component_type;
+	typedef aligned_allocator<IntT>		allocator_type;
+	typedef vector<IntT, allocator_type>	column_type;
+
+	/**
+	 * @brief Proxy returned by the non-const subscript: reads and writes
+	 * a rational number spread over both columns.
+	 */
+	class reference {
+		rational_soa_vector& v;
+		size_type pos;
+
+		friend class rational_soa_vector;
+		reference(rational_soa_vector& vec, size_type p) noexcept
+			: v(vec), pos(p) {}
+	public:
+		operator value_type() const
+		{
+			return value_type(v.nums.data()[pos], v.denoms.data()[pos]);
+		}
+		reference& operator=(value_type const& value) noexcept
+		{
+			v.nums.data()[pos] = value.num();
+			v.denoms.data()[pos] = value.denom();
+			return *this;
+		}
+		reference& operator=(reference const& other) noexcept
+		{
+			return operator=(static_cast<value_type>(other));
+		}
+	};
+private:
+	column_type nums;
+	column_type denoms;
+public:
+	/**
+	 * @brief Returns the number of elements in the container
+	 */
+	size_type size() const noexcept { return nums.size(); }
+	size_type capacity() const noexcept { return nums.capacity(); }
+	bool empty() const noexcept { return nums.empty(); }
+
+	/**
+	 *  @brief  Creates a %rational_soa_vector with no elements.
+	 */
+	rational_soa_vector() {}
+
+	/**
+	 *  @brief  Creates a %rational_soa_vector with n zeros.
+	 */
+	explicit rational_soa_vector(size_type n)
+		: nums(n, IntT(0)), denoms(n, IntT(1)) {}
+
+	/**
+	 *  @brief  Splits an array of structures into the two columns.
+	 *  @param  vec  A vector of rational numbers to copy from.
+	 */
+	explicit rational_soa_vector(vector<value_type> const& vec)
+	{
+		reserve(vec.size());
+		for (size_type i = 0; i != vec.size(); ++i)
+			push_back(vec.data()[i]);
+	}
+
+	void reserve(size_type new_capacity)
+	{
+		if (new_capacity <= capacity())
+			return;
+		nums.reserve(new_capacity);
+		denoms.reserve(new_capacity);
+	}
+
+	void clear()
+	{
+		nums.clear();
+		denoms.clear();
+	}
+
+	/**
+	 *  @brief  Add a rational number to the end of the vector.
+	 */
+	void push_back(value_type const& value)
+	{
+		nums.push_back(value.num());
+		denoms.push_back(value.denom());
+	}
+
+	void pop_back()
+	{
+		nums.pop_back();
+		denoms.pop_back();
+	}
+
+	/**
+	 *  @brief  Subscript access to the data contained in the vector.
+	 *  @param pos The index of the element.
+	 *  @return  A proxy in the non-const case, a copy otherwise.
+	 */
+	reference operator[](size_type pos) noexcept(false)
+	{
+		if (pos >= size()) throw std::out_of_range("No such element.");
+		return reference(*this, pos);
+	}
+	value_type operator[](size_type pos) const noexcept(false)
+	{
+		return value_type(nums[pos], denoms[pos]);
+	}
+
+	/**
+	 * Returns the aligned columns; [num_data(), num_data() + size())
+	 * and [denom_data(), denom_data() + size()) are valid ranges.
+	 * Denominators written through denom_data() must stay positive and
+	 * coprime with the corresponding numerators.
+	 */
+	IntT* num_data() noexcept { return nums.data(); }
+	const IntT* num_data() const noexcept { return nums.data(); }
+	IntT* denom_data() noexcept { return denoms.data(); }
+	const IntT* denom_data() const noexcept { return denoms.data(); }
+
+	/**
+	 * @brief print: Print all elements of the vector using std::cout
+	 */
+	void print() const
+	{
+		for (size_type i = 0; i != size(); i++)
+			std::cout << operator[](i) << "; ";
+		std::cout << "\n";
+	}
+};
+
+} // namespace lab
+
+#endif // RATIONAL_SOA_VECTOR_H
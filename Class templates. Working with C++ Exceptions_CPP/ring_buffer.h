@@ -0,0 +1,326 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace lab {
+
+/**
+ * @brief ring_buffer is a fixed-capacity circular sequence container.
+ *
+ * The capacity is rounded up to a power of two, so positions are mapped to
+ * storage with a mask instead of a division. Pushing to a full buffer
+ * overwrites the oldest element, which makes it a drop-in replacement for
+ * the erase(0, k) + push_back pattern on a sliding window without shifting
+ * the contents on every step.
+ */
+template<typename T, typename Alloc = std::allocator<T> >
+class ring_buffer {
+public:
+	typedef size_t		size_type;
+	typedef ptrdiff_t	difference_type;
+	typedef T*		pointer;
+	typedef const T*	const_pointer;
+	typedef T&		reference;
+	typedef const T&	const_reference;
+	typedef T		value_type;
+	typedef Alloc		allocator_type;
+	typedef std::pair<pointer, size_type>		array_range;
+	typedef std::pair<const_pointer, size_type>	const_array_range;
+private:
+	typedef std::allocator_traits<allocator_type> alloc_traits;
+
+	pointer storage;
+	size_type mask;
+	size_type head;		// index of the first element, not masked
+	size_type tail;		// index past the last element, not masked
+	allocator_type a;
+
+	static size_type round_up_pow2(size_type n)
+	{
+		size_type constexpr top = ~(~size_type(0) >> 1);
+		if (n > top)
+			throw std::length_error("Capacity is too large.");
+		size_type p = 1;
+		while (p < n)
+			p <<= 1;
+		return p;
+	}
+
+	void create_storage(size_type capacity)
+	{
+		storage = a.allocate(capacity);
+		if (!storage)
+			throw std::bad_alloc();
+
+		size_type i = 0;
+		try {
+			for (; i != capacity; ++i)
+				alloc_traits::construct(a, storage + i);
+		} catch (...) {
+			while (i != 0)
+				alloc_traits::destroy(a, storage + --i);
+			a.deallocate(storage, capacity);
+			throw;
+		}
+		mask = capacity - 1;
+		head = tail = 0;
+	}
+
+	void destroy_storage() noexcept
+	{
+		if (!storage)
+			return;
+		for (size_type i = 0; i != capacity(); ++i)
+			alloc_traits::destroy(a, storage + i);
+		a.deallocate(storage, capacity());
+		storage = nullptr;
+	}
+
+	inline pointer slot(size_type pos) const noexcept
+	{
+		return storage + ((head + pos) & mask);
+	}
+public:
+	/**
+	 * @brief Returns the number of elements in the container
+	 */
+	inline size_type size() const noexcept { return tail - head; }
+
+	/**
+	 * @brief Returns the number of elements the buffer can hold, always
+	 * a power of two.
+	 */
+	inline size_type capacity() const noexcept
+	{
+		return storage ? mask + 1 : 0;
+	}
+
+	/**
+	 * Returns true if the %ring_buffer is empty.
+	 */
+	bool empty() const noexcept { return head == tail; }
+
+	/**
+	 * Returns true if the next push_back will overwrite the oldest element.
+	 */
+	bool full() const noexcept { return size() == capacity(); }
+
+	/**
+	 *  @brief  Creates an empty %ring_buffer.
+	 *  @param  capacity The minimal number of elements to hold. It is
+	 *  rounded up to the nearest power of two; std::length_error is
+	 *  thrown when that power does not fit size_type.
+	 */
+	explicit ring_buffer(size_type capacity) noexcept(false)
+	{
+		if (!capacity)
+			throw std::invalid_argument("Capacity can't be 0.");
+		create_storage(round_up_pow2(capacity));
+	}
+
+	/**
+	 *  @brief  %ring_buffer copy constructor.
+	 *  @param  other  A %ring_buffer of identical element and allocator
+	 *  types. The copy has the same capacity and contents.
+	 */
+	explicit ring_buffer(ring_buffer const& other)
+	{
+		create_storage(other.capacity());
+		push_back(other);
+	}
+
+	/**
+	 *  @brief  %ring_buffer move constructor.
+	 *  The contents of other are left without storage; it may only be
+	 *  destroyed or assigned to.
+	 */
+	explicit ring_buffer(ring_buffer&& other) noexcept
+		: storage(other.storage), mask(other.mask),
+		  head(other.head), tail(other.tail)
+	{
+		other.storage = nullptr;
+		other.head = other.tail = 0;
+	}
+
+	ring_buffer& operator=(ring_buffer const& other)
+	{
+		if (this == &other)
+			return *this;
+		if (capacity() != other.capacity()) {
+			destroy_storage();
+			create_storage(other.capacity());
+		}
+		clear();
+		push_back(other);
+		return *this;
+	}
+
+	ring_buffer& operator=(ring_buffer&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		destroy_storage();
+		storage = other.storage;
+		mask = other.mask;
+		head = other.head;
+		tail = other.tail;
+		other.storage = nullptr;
+		other.head = other.tail = 0;
+		return *this;
+	}
+
+	~ring_buffer()
+	{
+		destroy_storage();
+	}
+
+	/**
+	 * @brief clear: Drops all elements, keeping the capacity.
+	 */
+	void clear() noexcept { head = tail = 0; }
+
+	/**
+	 *  @brief  Add data to the end of the %ring_buffer.
+	 *  @param  element Data to be added.
+	 *
+	 *  If the buffer is full the oldest element is overwritten.
+	 */
+	void push_back(const_reference element)
+	{
+		*(storage + (tail & mask)) = element;
+		if (full())
+			++head;
+		++tail;
+	}
+
+	/**
+	 * @brief Add a range of elements to the end of the %ring_buffer.
+	 * @param p:		pointer to the first element
+	 * @param p_size:	size of the range
+	 *
+	 * Elements are copied in at most two contiguous runs. If the range
+	 * does not fit, the oldest elements are overwritten; only the last
+	 * capacity() elements of a range larger than the buffer are kept.
+	 */
+	void push_back(const_pointer p, size_type p_size)
+	{
+		if (p_size > capacity()) {
+			p += p_size - capacity();
+			p_size = capacity();
+		}
+
+		size_type const pos = tail & mask;
+		size_type const first = (capacity() - pos < p_size)
+					? capacity() - pos : p_size;
+		for (size_type i = 0; i != first; ++i)
+			storage[pos + i] = p[i];
+		for (size_type i = first; i != p_size; ++i)
+			storage[i - first] = p[i];
+
+		tail += p_size;
+		if (size() > capacity())
+			head = tail - capacity();
+	}
+	void push_back(ring_buffer const& other)
+	{
+		const_array_range one = other.array_one();
+		const_array_range two = other.array_two();
+		push_back(one.first, one.second);
+		push_back(two.first, two.second);
+	}
+
+	/**
+	 * @brief pop_front: Delete first elements
+	 * @param n: number of elements to erase (if the buffer is shorter,
+	 *	  it becomes empty).
+	 */
+	void pop_front(size_type n = 1) noexcept
+	{
+		head += (n < size()) ? n : size();
+	}
+
+	/**
+	 * @brief pop_back: Delete last elements
+	 * @param n: number of elements to erase (if the buffer is shorter,
+	 *	  it becomes empty).
+	 */
+	void pop_back(size_type n = 1) noexcept
+	{
+		tail -= (n < size()) ? n : size();
+	}
+
+	/**
+	 *  @brief  Subscript access to the data contained in the %ring_buffer.
+	 *  @param pos The index of the element counted from the oldest one.
+	 *  @return  Read/write reference to data.
+	 */
+	reference operator[](size_type pos) noexcept(false)
+	{
+		if (pos >= size()) throw std::out_of_range("No such element.");
+		return *slot(pos);
+	}
+	const_reference operator[](size_type pos) const noexcept(false)
+	{
+		if (pos >= size()) throw std::out_of_range("No such element.");
+		return *slot(pos);
+	}
+
+	reference front() noexcept(false) { return operator[](0); }
+	const_reference front() const noexcept(false) { return operator[](0); }
+	reference back() noexcept(false) { return operator[](size() - 1); }
+	const_reference back() const noexcept(false)
+	{
+		return operator[](size() - 1);
+	}
+
+	/**
+	 * @brief Returns the first contiguous run of elements, starting with
+	 * the oldest one. Together with array_two() it covers the whole
+	 * contents in order, so a kernel can process two plain arrays.
+	 */
+	array_range array_one() noexcept
+	{
+		size_type const pos = head & mask;
+		size_type const len = (capacity() - pos < size())
+				      ? capacity() - pos : size();
+		return array_range(storage + pos, len);
+	}
+	const_array_range array_one() const noexcept
+	{
+		size_type const pos = head & mask;
+		size_type const len = (capacity() - pos < size())
+				      ? capacity() - pos : size();
+		return const_array_range(storage + pos, len);
+	}
+
+	/**
+	 * @brief Returns the wrapped-around run of elements; its size is 0
+	 * when the contents are contiguous.
+	 */
+	array_range array_two() noexcept
+	{
+		return array_range(storage, size() - array_one().second);
+	}
+	const_array_range array_two() const noexcept
+	{
+		return const_array_range(storage, size() - array_one().second);
+	}
+
+	/**
+	 * @brief print: Print all elements of the buffer using std::cout
+	 */
+	void print() const noexcept
+	{
+		for (size_type i = 0; i != size(); i++)
+			std::cout << *slot(i) << "; ";
+		std::cout << "\n";
+	}
+};
+
+} // namespace lab
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,272 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lab {
+
+/**
+ * @brief thread_pool runs tasks on a fixed set of worker threads.
+ *
+ * Every worker has its own deque of tasks. A task submitted by a worker
+ * goes to the back of its deque, and the worker takes its next task from
+ * there too, so nested work stays on the thread whose cache holds its
+ * data. Idle workers take the oldest tasks of the others from the front
+ * (work stealing) and tasks submitted from outside from a shared deque.
+ *
+ * parallel_for() splits an index range into chunks that the workers and
+ * the calling thread claim from a shared counter, so an uneven workload
+ * balances itself and a call from inside a task cannot deadlock: the
+ * caller keeps working until every chunk is done, and chunks are only
+ * waited for once somebody runs them.
+ */
+class thread_pool {
+public:
+	typedef size_t size_type;
+private:
+	struct task_queue {
+		std::mutex mutex;
+		std::deque<std::function<void()> > tasks;
+
+		void push(std::function<void()>&& task)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+		bool pop(std::function<void()>& task, bool back)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (tasks.empty())
+				return false;
+			if (back) {
+				task = std::move(tasks.back());
+				tasks.pop_back();
+			} else {
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			return true;
+		}
+	};
+
+	// the pool and the queue of the calling thread, if it is a worker
+	struct worker_id {
+		thread_pool const* pool;
+		size_type index;
+	};
+	static worker_id& current() noexcept
+	{
+		static thread_local worker_id id = { nullptr, 0 };
+		return id;
+	}
+
+	size_type const shared;		// index of the shared queue
+	std::unique_ptr<task_queue[]> queues;	// one per worker, then shared
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::atomic<size_type> pending;	// tasks submitted but not taken
+	bool stopping;
+
+	bool take(size_type self, std::function<void()>& task)
+	{
+		bool found = self != shared && queues[self].pop(task, true);
+		if (!found)
+			found = queues[shared].pop(task, false);
+		for (size_type i = 1; !found && i < shared; ++i)
+			found = queues[(self + i) % shared].pop(task, false);
+		if (found)
+			pending.fetch_sub(1);
+		return found;
+	}
+
+	void run(size_type self)
+	{
+		current() = worker_id{ this, self };
+		for (;;) {
+			std::function<void()> task;
+			if (take(self, task)) {
+				task();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [this] {
+				return stopping || pending.load() != 0;
+			});
+			if (stopping && pending.load() == 0)
+				return;
+		}
+	}
+
+	// lets the workers drain the queues and joins them
+	void stop() noexcept
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		ready.notify_all();
+		for (std::thread& worker : workers)
+			if (worker.joinable())
+				worker.join();
+		workers.clear();
+	}
+public:
+	/**
+	 * @brief One worker per hardware thread but the calling one.
+	 */
+	static size_type default_size() noexcept
+	{
+		unsigned const n = std::thread::hardware_concurrency();
+		return n > 1 ? n - 1 : 0;
+	}
+
+	/**
+	 *  @brief  Starts the workers.
+	 *  @param  threads The number of worker threads; with 0 every
+	 *  parallel_for() runs on the calling thread.
+	 */
+	explicit thread_pool(size_type threads = default_size())
+		: shared(threads), queues(new task_queue[threads + 1]),
+		  pending(0), stopping(false)
+	{
+		workers.reserve(threads);
+		try {
+			for (size_type i = 0; i != threads; ++i)
+				workers.emplace_back([this, i] { run(i); });
+		} catch (...) {
+			stop();
+			throw;
+		}
+	}
+
+	thread_pool(thread_pool const&) = delete;
+	thread_pool& operator=(thread_pool const&) = delete;
+
+	/**
+	 * @brief Finishes the queued tasks and joins the workers.
+	 */
+	~thread_pool()
+	{
+		stop();
+	}
+
+	/**
+	 * @brief Returns the number of worker threads.
+	 */
+	size_type size() const noexcept { return workers.size(); }
+
+	/**
+	 * @brief Queues a task: on the deque of the calling worker, or on the
+	 * shared one when called from outside the pool.
+	 */
+	void submit(std::function<void()> task)
+	{
+		worker_id const& id = current();
+		size_type const queue = id.pool == this ? id.index : shared;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending.fetch_add(1);
+		}
+		queues[queue].push(std::move(task));
+		ready.notify_one();
+	}
+
+	/**
+	 *  @brief  Calls f(lo, hi) on disjoint subranges covering
+	 *  [first, last), in parallel, and returns when all calls are done.
+	 *  @param  grain The smallest subrange worth a task of its own.
+	 *
+	 *  The first exception thrown by f is rethrown here, after the other
+	 *  subranges finished.
+	 */
+	template<typename F>
+	void parallel_for(size_type first, size_type last, F const& f,
+			  size_type grain = 1)
+	{
+		if (first >= last)
+			return;
+		size_type const n = last - first;
+		size_type chunks = (n + grain - 1) / (grain ? grain : 1);
+		if (chunks > 4 * (size() + 1))
+			chunks = 4 * (size() + 1);
+		if (chunks <= 1 || workers.empty()) {
+			f(first, last);
+			return;
+		}
+
+		struct state {
+			std::atomic<size_type> next{0};
+			std::atomic<size_type> done{0};
+			std::mutex mutex;
+			std::condition_variable finished;
+			std::exception_ptr error;
+
+			void fail()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error)
+					error = std::current_exception();
+			}
+			void finish(size_type chunks)
+			{
+				if (done.fetch_add(1) + 1 != chunks)
+					return;
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		};
+		std::shared_ptr<state> const s = std::make_shared<state>();
+
+		// a helper that starts after the last chunk was claimed only
+		// touches the shared state, never f
+		auto work = [s, first, n, chunks, &f] {
+			for (;;) {
+				size_type const c = s->next.fetch_add(1);
+				if (c >= chunks)
+					return;
+				try {
+					f(first + n * c / chunks,
+					  first + n * (c + 1) / chunks);
+				} catch (...) {
+					s->fail();
+				}
+				s->finish(chunks);
+			}
+		};
+		size_type const helpers = chunks - 1 < size() ? chunks - 1
+							      : size();
+		for (size_type i = 0; i != helpers; ++i)
+			submit(work);
+		work();
+
+		std::unique_lock<std::mutex> lock(s->mutex);
+		s->finished.wait(lock, [&s, chunks] {
+			return s->done.load() == chunks;
+		});
+		if (s->error)
+			std::rethrow_exception(s->error);
+	}
+};
+
+/**
+ * @brief The pool shared by the parallel algorithms of the library,
+ * started on first use.
+ */
+inline thread_pool& default_thread_pool()
+{
+	static thread_pool pool;
+	return pool;
+}
+
+} // namespace lab
+
+#endif // THREAD_POOL_H
@@ -2,6 +2,7 @@
 #define VECTOR_H
 
 #include <iostream>
+#include <memory>
 #include <type_traits>
 #include <stdexcept>
 #include <iterator>
@@ -34,13 +35,41 @@ private:
 	pointer end_of_storage;
 	allocator_type a;
 
+	typedef std::allocator_traits<allocator_type>	alloc_traits;
+
+	// Elements are assigned to, never constructed, so the storage of types
+	// that own resources (bigint, rational_t<bigint>) is constructed when
+	// allocated and destroyed when released. Types with a trivial
+	// destructor are assigned into the raw storage.
+	enum : bool {
+		constructed_storage = !std::is_trivially_destructible<T>::value
+	};
+
 	inline pointer allocate(size_type n)
 	{
-		return n != 0 ? a.allocate(n) : pointer();
+		if (n == 0)
+			return pointer();
+		pointer const p = a.allocate(n);
+		if constexpr (constructed_storage) {
+			size_type i = 0;
+			try {
+				for (; i != n; ++i)
+					alloc_traits::construct(a, p + i);
+			} catch (...) {
+				while (i != 0)
+					alloc_traits::destroy(a, p + --i);
+				a.deallocate(p, n);
+				throw;
+			}
+		}
+		return p;
 	}
 
 	inline void deallocate()
 	{
+		if constexpr (constructed_storage)
+			for (pointer p = start; p != end_of_storage; ++p)
+				alloc_traits::destroy(a, p);
 		a.deallocate(start, capacity());
 	}
 
@@ -196,7 +225,6 @@ public:
 	 */
 	explicit vector(vector&& other) noexcept
 	{
-		create_storage(other.size() * capacity_factor);
 		move_content(std::move(other));
 	}
 
@@ -428,7 +456,8 @@ public:
 	}
 	const_reference operator[](size_type pos) const noexcept(false)
 	{
-		return operator [](pos);
+		if (pos >= size()) throw std::out_of_range("No such element.");
+		return (*(start + pos));
 	}
 
 	/**